@@ -0,0 +1,473 @@
+#!/usr/bin/env python3
+"""
+Benchmarks for wplc.
+
+Each suite generates its inputs, compiles them with one or more wplc
+binaries and prints the best time of the phases it is about, as
+reported by -time-report. To measure a change, build wplc before and
+after it and pass both binaries; every binary gets its own column.
+
+usage:
+  bench/bench.py [-r REPS] [-f=FLAGS] [-s MB] <suite> <wplc> [<wplc> ...]
+  bench/bench.py gen <shape> <size> [<count>]    print a generated input
+
+suites:
+  parse     Lex and Parse on large inputs
+  visit     Semantic and Codegen per expression node on deep expressions
+  nesting   10^4 to 10^6 chained terms and nested parentheses
+  symbols   Semantic time and allocations on deep and wide scopes
+  opt       run time of programs built at -O0 to -O3, and compile time
+
+FLAGS is passed to every wplc run, e.g. -f="-parser=fast"; the = is
+needed as the value starts with a dash. Only flags that all the
+binaries know can be used. -s sets the stack limit of the wplc runs in
+MB; a compile that overflows it shows up as "signal 11".
+
+The opt suite also needs llc and a C compiler, taken from $LLC and $CC
+(default llc and cc). Its programs are in bench/programs.
+"""
+import argparse
+import glob
+import os
+import re
+import resource
+import subprocess
+import sys
+import tempfile
+import time
+
+# Input shapes. Each returns the text of a WPL program.
+
+
+def functions(n, count=None):
+    """n small functions with a branch and a loop each."""
+    out = []
+    for i in range(n):
+        out.append(f"int func f{i}(int a, int b) {{\n"
+                   f"  int x <- 3;\n"
+                   f"  x <- a * {i} + b - (a / 7);\n"
+                   f"  if x > 10 then {{ x <- x - 1; }} else {{ x <- x + 1; }}\n"
+                   f"  while x < 100 do {{ x <- x * 2; }}\n"
+                   f"  return x;\n"
+                   f"}}")
+    out.append("int func program() {\n  int y;\n  y <- f0(1, 2);\n  return y;\n}")
+    return "\n".join(out) + "\n"
+
+
+def mixed(terms, count=1):
+    """count assignments of a terms-term sum alternating a and (a*2-1)."""
+    expr = "+".join("a" if i % 2 == 0 else "(a*2-1)" for i in range(terms))
+    body = "".join(f"  x <- {expr};\n" for _ in range(count))
+    return f"int func f(int a) {{\n  int x;\n{body}  return x;\n}}\n"
+
+
+def mixed_nodes(terms, count=1):
+    """The expression nodes of mixed(terms, count): an a is one node, an
+    (a*2-1) is six, and every + is one more."""
+    return count * ((terms + 1) // 2 + 6 * (terms // 2) + terms - 1)
+
+
+def chain(terms, count=1):
+    """count assignments of a+a+...+a with terms terms."""
+    expr = "+".join("a" for _ in range(terms))
+    body = "".join(f"  x <- {expr};\n" for _ in range(count))
+    return f"int func f(int a) {{\n  int x;\n{body}  return x;\n}}\n"
+
+
+def parens(depth, count=1):
+    """count assignments of a inside depth pairs of parentheses."""
+    expr = "(" * depth + "a" + ")" * depth
+    body = "".join(f"  x <- {expr};\n" for _ in range(count))
+    return f"int func f(int a) {{\n  int x;\n{body}  return x;\n}}\n"
+
+
+def blocks(depth, count=None):
+    """depth nested blocks, each declaring a variable of its own that
+    reads the one of the block around it."""
+    out = ["int func f(int a) {\n  int v0;\n  v0 <- a;\n"]
+    for i in range(1, depth + 1):
+        out.append(f"  {{\n  int v{i};\n  v{i} <- v{i - 1} + 1;\n")
+    out.append(f"  v0 <- v{depth};\n" + "  }\n" * depth + "  return v0;\n}\n")
+    return "".join(out)
+
+
+def locals_(n, count=None):
+    """One function with n local variables, each assigned and read once."""
+    body = "".join(f"  int v{i};\n  v{i} <- {i};\n  x <- x + v{i};\n" for i in range(n))
+    return f"int func f(int a) {{\n  int x;\n  x <- a;\n{body}  return x;\n}}\n"
+
+
+def live(n, count=None):
+    """n functions of six steps, each calling the one before it in chains
+    of ten that end in f0, all called from program() so the optimizer
+    keeps them."""
+    out = ["extern int func printf(str s, ...);"]
+    for i in range(n):
+        steps = "".join(f"  r <- r * {k + 2} + x - {k};\n"
+                        f"  if r > 1000 {{ r <- r / 3; }} else {{ r <- r + 7; }}\n"
+                        for k in range(6))
+        call = f"  r <- r + f{i - 1 if i % 10 else 0}(x);\n" if i else ""
+        out.append(f"int func f{i}(int x) {{\n  int r <- 0;\n  r <- x;\n{steps}{call}"
+                   f"  return r;\n}}")
+    calls = "".join(f"  s <- s + f{i}({i});\n" for i in range(n))
+    out.append(f"int func program() {{\n  int s <- 0;\n{calls}"
+               f"  printf(\"%d\\n\", s);\n  return 0;\n}}")
+    return "\n".join(out) + "\n"
+
+
+def helpers(n, count=None):
+    """A chain of n helper functions, each calling the one before, called
+    from a loop that runs the number of times given by the first
+    argument."""
+    out = ["extern int func getIntArg(int i);", "extern str func printf(...);",
+           "int func h0(int x) {\n  return x - x / 7 * 7;\n}"]
+    for i in range(1, n):
+        out.append(f"int func h{i}(int x) {{\n"
+                   f"  int y <- 0;\n"
+                   f"  y <- h{i - 1}(x + {i});\n"
+                   f"  if (y > {i % 5}) then {{ return y * 3 - x / {i + 1}; }}\n"
+                   f"  return y + {i};\n"
+                   f"}}")
+    out.append(f"int func program() {{\n"
+               f"  int limit <- 0;\n"
+               f"  limit <- getIntArg(1);\n"
+               f"  var s <- 0;\n"
+               f"  var i <- 0;\n"
+               f"  while (i < limit) do {{\n"
+               f"    s <- s + h{n - 1}(i) - s / 3;\n"
+               f"    i <- i + 1;\n"
+               f"  }}\n"
+               f"  printf(\"%d\\n\", s);\n"
+               f"  return 0;\n"
+               f"}}")
+    return "\n".join(out) + "\n"
+
+
+SHAPES = {
+    "functions": functions,
+    "mixed": mixed,
+    "chain": chain,
+    "parens": parens,
+    "blocks": blocks,
+    "locals": locals_,
+    "live": live,
+    "helpers": helpers,
+}
+
+# Running wplc
+
+PHASE_LINE = re.compile(r"^  (\S.*?)\s+([0-9.]+)\s+[0-9.]+%$")
+TOTAL_LINE = re.compile(r"^  Total\s+([0-9.]+)$")
+ALLOC_LINE = re.compile(r"^  (\S.*?)\s+(\d+)\s+\d+(?:  .*)?$")
+
+
+def phase_times(report):
+    """The seconds of each phase in a -time-report."""
+    times = {}
+    for line in report.splitlines():
+        m = PHASE_LINE.match(line)
+        if m:
+            times[m.group(1)] = float(m.group(2))
+        m = TOTAL_LINE.match(line)
+        if m:
+            times["Total"] = float(m.group(1))
+    return times
+
+
+def phase_allocations(report):
+    """The allocations of each phase in a -mem-report, as "<phase> allocs"."""
+    allocs = {}
+    for line in report.splitlines():
+        m = ALLOC_LINE.match(line)
+        if m:
+            allocs[m.group(1) + " allocs"] = int(m.group(2))
+    return allocs
+
+
+STACK_MB = None
+
+
+def set_stack_limit():
+    if STACK_MB is not None:
+        size = resource.RLIM_INFINITY if STACK_MB == 0 else STACK_MB << 20
+        resource.setrlimit(resource.RLIMIT_STACK, (size, size))
+
+
+def compile_once(wplc, flags, path, extra=()):
+    return subprocess.run([wplc, *flags, *extra, "-nocode", "-time-report", path],
+                          stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                          text=True, errors="replace", preexec_fn=set_stack_limit)
+
+
+def best_times(wplc, flags, path, reps, extra=()):
+    """The best time of every phase over reps compiles, or the exit
+    status of a compile that failed. With -mem-report in extra, the
+    allocations of every phase are added too."""
+    best = {}
+    for _ in range(reps):
+        run = compile_once(wplc, flags, path, extra)
+        if run.returncode != 0:
+            return run.returncode
+        for phase, seconds in phase_times(run.stderr).items():
+            best[phase] = min(seconds, best.get(phase, seconds))
+        best.update(phase_allocations(run.stderr))
+    return best
+
+
+def cell(value):
+    if isinstance(value, (str, int)):
+        return str(value)
+    return f"{value:.3f}" if value < 100 else f"{value:.0f}"
+
+
+def print_table(header, rows):
+    widths = [max(len(str(r[i])) for r in [header] + rows) for i in range(len(header))]
+    for r in [header] + rows:
+        print("  ".join(str(c).ljust(w) if i == 0 else str(c).rjust(w)
+                        for i, (c, w) in enumerate(zip(r, widths))))
+
+
+def report(args, inputs, phases, unit="s", scale=lambda seconds, inp: seconds, extra=()):
+    """Compile every input with every binary and print one row per input
+    and one column per phase and binary. inputs are (label, text, ...)
+    tuples; scale turns the seconds of a phase into the unit shown and
+    gets the whole tuple. extra is passed to every wplc run."""
+    print(f"{args.suite}: best of {args.reps}, {unit}"
+          + (f", flags {' '.join(args.flags)}" if args.flags else ""))
+    for i, wplc in enumerate(args.wplc, 1):
+        print(f"  [{i}] {wplc}")
+    header = ["input"] + [f"{p}[{i}]" for p in phases for i in range(1, len(args.wplc) + 1)]
+    rows = []
+    with tempfile.TemporaryDirectory(prefix="wplc-bench-") as work:
+        for n, inp in enumerate(inputs):
+            path = os.path.join(work, f"input{n}.wpl")
+            with open(path, "w") as f:
+                f.write(inp[1])
+            results = [best_times(wplc, args.flags, path, args.reps, extra)
+                       for wplc in args.wplc]
+            row = [inp[0]]
+            for p in phases:
+                for r in results:
+                    if isinstance(r, int):
+                        row.append(f"signal {-r}" if r < 0 else f"exit {r}")
+                    elif p not in r:
+                        row.append("-")
+                    elif p.endswith(" allocs"):
+                        row.append(cell(r[p]))
+                    else:
+                        row.append(cell(scale(r[p], inp)))
+            rows.append(row)
+            print(f"  done: {inp[0]}", file=sys.stderr)
+    print_table(header, rows)
+
+
+# Suites
+
+
+def suite_parse(args):
+    """Long expressions are where full LL prediction of the left-recursive
+    expr rule is expensive; many small functions are the common case."""
+    report(args, [
+        ("20000 functions", functions(20000)),
+        ("10^4-term mixed expression", mixed(10000)),
+        ("10^5-term mixed expression", mixed(100000)),
+        ("10^5-term chain", chain(100000)),
+    ], ["Lex", "Parse"])
+
+
+def suite_visit(args):
+    """The cost per node of the semantic and codegen passes, most of which
+    is visiting expressions: ten assignments of a long sum."""
+    inputs = [(f"10 x {t}-term mixed expression", mixed(t, 10), mixed_nodes(t, 10))
+              for t in (2000, 20000)]
+    report(args, inputs, ["Semantic", "Codegen"], unit="ns per expression node",
+           scale=lambda seconds, inp: seconds * 1e9 / inp[2])
+
+
+def suite_nesting(args):
+    """Chained operators are parsed in a loop, so only the passes over the
+    AST could run out of stack on them. Parentheses also nest the parse,
+    and both parsers recurse on them."""
+    inputs = [(f"a+a+... 10^{e} terms", chain(10 ** e)) for e in (4, 5, 6)]
+    inputs += [(f"{label} nested parens", parens(depth))
+               for label, depth in (("10^4", 10 ** 4), ("3*10^4", 3 * 10 ** 4),
+                                    ("10^5", 10 ** 5), ("10^6", 10 ** 6))]
+    report(args, inputs, ["Parse", "Lower", "Semantic", "Codegen"])
+
+
+def suite_symbols(args):
+    """Declarations and lookups in the symbol table: a deep stack of block
+    scopes, one wide scope, and many small functions. The allocations
+    are counted by -mem-report and do not depend on the run."""
+    report(args, [
+        ("3000 nested blocks", blocks(3000)),
+        ("100k locals, each read once", locals_(100000)),
+        ("20000 functions", functions(20000)),
+    ], ["Semantic", "Semantic allocs"], extra=["-mem-report"])
+
+
+BENCH = os.path.dirname(os.path.abspath(__file__))
+LLC = os.environ.get("LLC", "llc")
+CC = os.environ.get("CC", "cc")
+LEVELS = ["O0", "O1", "O2", "O3"]
+TEST_RUNS = 200
+
+
+def build(wplc, flags, level, source, exe, runtime):
+    """Compile source at level, and link it with the runtime into exe.
+    Returns None, or the step that failed."""
+    ll, obj = exe + ".ll", exe + ".o"
+    for step, cmd in (("wplc", [wplc, *flags, "-" + level, source, "-o", ll]),
+                      ("llc", [LLC, "-O2", "-filetype=obj", ll, "-o", obj]),
+                      ("link", [CC, "-no-pie", obj, runtime, "-o", exe])):
+        run = subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                             preexec_fn=set_stack_limit)
+        if run.returncode != 0:
+            return f"{step} failed"
+    return None
+
+
+def run_time(exe, argv, runs):
+    """The output and exit status of exe and the wall time of runs runs
+    of it, or the signal that killed it. The exit status is what
+    program() returned."""
+    start = time.perf_counter()
+    for _ in range(runs):
+        run = subprocess.run([exe, *argv], stdout=subprocess.PIPE)
+        if run.returncode < 0:
+            return run.returncode
+    return (run.stdout, run.returncode), time.perf_counter() - start
+
+
+def suite_opt(args):
+    """Every program is built at every level with every binary, through
+    llc -O2 and linked with wpl_runtime.c, and all the builds of a
+    program must print the same. The programs of tests/ that build
+    everywhere run TEST_RUNS times each with the arguments 3 4 5, timed
+    once in total; that is mostly process start-up. The other programs
+    are timed one run at a time, best of reps. Then the compile time of
+    5000 functions that are all called, where -O1 and up add the
+    Optimize phase."""
+    columns = [(i, wplc, level) for level in LEVELS
+               for i, wplc in enumerate(args.wplc, 1)]
+    print(f"{args.suite}: best of {args.reps}, s"
+          + (f", flags {' '.join(args.flags)}" if args.flags else ""))
+    for i, wplc in enumerate(args.wplc, 1):
+        print(f"  [{i}] {wplc}")
+    with tempfile.TemporaryDirectory(prefix="wplc-bench-") as work:
+        runtime = os.path.join(work, "wpl_runtime.o")
+        subprocess.run([CC, "-c", os.path.join(BENCH, "..", "wpl_runtime.c"), "-o", runtime],
+                       check=True)
+        helpers_source = os.path.join(work, "helpers.wpl")
+        with open(helpers_source, "w") as f:
+            f.write(helpers(40))
+        tests = sorted(glob.glob(os.path.join(BENCH, "..", "tests", "*", "*.wpl")))
+        # (label, sources, arguments, runs): runs is TEST_RUNS for the
+        # programs of tests/, timed together once, and None for a
+        # program timed on its own
+        programs = [
+            ("tests/", tests, ["3", "4", "5"], TEST_RUNS),
+            ("primes below 3*10^6", [os.path.join(BENCH, "programs", "primes.wpl")],
+             ["3000000"], None),
+            ("collatz below 1.5*10^6", [os.path.join(BENCH, "programs", "collatz.wpl")],
+             ["1500000"], None),
+            ("40 chained helpers, 3*10^7 calls", [helpers_source], ["30000000"], None),
+        ]
+        header = ["program"] + [f"{level}[{i}]" for i, _, level in columns]
+        rows = []
+        for n, (label, sources, argv, runs) in enumerate(programs):
+            exes, failed = {}, {}
+            for c, (_, wplc, level) in enumerate(columns):
+                for k, source in enumerate(sources):
+                    exe = os.path.join(work, f"p{n}_{k}_{c}")
+                    error = build(wplc, args.flags, level, source, exe, runtime)
+                    if error:
+                        failed.setdefault(source, error)
+                    exes[c, source] = exe
+            if runs:
+                # A program of tests/ that does not build everywhere is
+                # left out of every column, so the columns stay comparable
+                sources = [s for s in sources if s not in failed]
+                label += f" ({len(sources)} programs, {runs} runs each)"
+            row = [label]
+            expected = {}
+            for c in range(len(columns)):
+                if failed and not runs:
+                    row.append(next(iter(failed.values())))
+                    continue
+                total, result = 0.0, None
+                for source in sources:
+                    timed = [run_time(exes[c, source], argv, runs or 1)
+                             for _ in range(1 if runs else args.reps)]
+                    signal = next((t for t in timed if isinstance(t, int)), None)
+                    if signal is not None:
+                        result = f"signal {-signal}"
+                        break
+                    output = timed[0][0]
+                    if expected.setdefault(source, output) != output:
+                        result = "differs"
+                        break
+                    total += min(t for _, t in timed)
+                row.append(result or cell(total))
+            rows.append(row)
+            print(f"  done: {label}", file=sys.stderr)
+        print("run time")
+        print_table(header, rows)
+
+        path = os.path.join(work, "live.wpl")
+        with open(path, "w") as f:
+            f.write(live(5000))
+        phases = ["Optimize", "Total"]
+        header = ["5000 live functions"] + [f"{p}[{i}]" for p in phases
+                                            for i in range(1, len(args.wplc) + 1)]
+        rows = []
+        for level in LEVELS:
+            results = [best_times(wplc, args.flags, path, args.reps, ["-" + level])
+                       for wplc in args.wplc]
+            row = ["-" + level]
+            for p in phases:
+                for r in results:
+                    if isinstance(r, int):
+                        row.append(f"signal {-r}" if r < 0 else f"exit {r}")
+                    else:
+                        row.append(cell(r[p]) if p in r else "-")
+            rows.append(row)
+            print(f"  done: -{level}", file=sys.stderr)
+        print("compile time")
+        print_table(header, rows)
+
+
+SUITES = {
+    "parse": suite_parse,
+    "visit": suite_visit,
+    "nesting": suite_nesting,
+    "symbols": suite_symbols,
+    "opt": suite_opt,
+}
+
+
+def main():
+    if len(sys.argv) > 1 and sys.argv[1] == "gen":
+        if len(sys.argv) < 4 or sys.argv[2] not in SHAPES:
+            sys.exit(f"usage: {sys.argv[0]} gen <{'|'.join(SHAPES)}> <size> [<count>]")
+        sys.stdout.write(SHAPES[sys.argv[2]](*map(int, sys.argv[3:5])))
+        return
+    parser = argparse.ArgumentParser(
+        description="Benchmarks for wplc (see the top of this file).")
+    parser.add_argument("-r", "--reps", type=int, default=3,
+                        help="compiles per input and binary; the best is reported")
+    parser.add_argument("-f", "--flags", default="",
+                        help="flags passed to every wplc run")
+    parser.add_argument("-s", "--stack", type=int, metavar="MB",
+                        help="stack limit of the wplc runs, 0 for unlimited")
+    parser.add_argument("suite", choices=SUITES)
+    parser.add_argument("wplc", nargs="+", help="wplc binaries to compare")
+    args = parser.parse_args()
+    args.flags = args.flags.split()
+    global STACK_MB
+    STACK_MB = args.stack
+    SUITES[args.suite](args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,17 @@
+# AST component module
+#
+# The abstract syntax tree, its lowering from the ANTLR parse tree
+# and the base class of the visitors that walk it.
+#########################################################
+include(LLVM)
+
+set (AST_DIR ${CMAKE_SOURCE_DIR}/src/ast)
+set (AST_INCLUDE 
+  ${AST_DIR}/include
+  ${LLVM_INCLUDE_DIR}
+)
+
+set (AST_SOURCES
+  ${AST_DIR}/AST.cpp
+  ${AST_DIR}/ASTLowering.cpp
+)
@@ -0,0 +1,23 @@
+# Driver component module
+#
+# The compilation pipeline used by wplc (lex, parse, semantic
+# analysis and code generation for one input).
+#########################################################
+
+set (DRIVER_DIR ${CMAKE_SOURCE_DIR}/src/driver)
+set (DRIVER_INCLUDE ${DRIVER_DIR}/include)
+
+set (DRIVER_SOURCES
+  ${DRIVER_DIR}/WPLCompiler.cpp
+  ${DRIVER_DIR}/CompileServer.cpp
+  ${DRIVER_DIR}/CompileCache.cpp
+  ${DRIVER_DIR}/IncrementalBuild.cpp
+  ${DRIVER_DIR}/MappedInputStream.cpp
+  ${DRIVER_DIR}/DFACache.cpp
+  ${DRIVER_DIR}/WPLFastLexer.cpp
+  ${DRIVER_DIR}/WPLFastParser.cpp
+  ${DRIVER_DIR}/ComponentTokenSource.cpp
+  ${DRIVER_DIR}/InputSlicer.cpp
+  ${DRIVER_DIR}/OpenDocument.cpp
+  ${DRIVER_DIR}/LanguageServer.cpp
+)
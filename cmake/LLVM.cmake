@@ -2,4 +2,4 @@
 # Platform dependent
 set(LLVM_DIR /usr/lib/llvm-14)
 set(LLVM_INCLUDE_DIR "${LLVM_DIR}/include")
-set(LLVM_LIBS LLVMCore)
+set(LLVM_LIBS LLVMCore LLVMSupport LLVMTransformUtils LLVMLinker LLVMAsmParser LLVMPasses)
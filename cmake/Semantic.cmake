@@ -8,4 +8,5 @@ set (SEMANTIC_INCLUDE ${SEMANTIC_DIR}/include)
 set (SEMANTIC_SOURCES
   ${SEMANTIC_DIR}/SemanticVisitor.cpp
   ${SEMANTIC_DIR}/PropertyManager.cpp
+  ${SEMANTIC_DIR}/CallGraph.cpp
 )
\ No newline at end of file
@@ -8,10 +8,10 @@ include(LLVM)
 set (SYMBOL_DIR ${CMAKE_SOURCE_DIR}/src/symbol)
 set (SYMBOL_INCLUDE 
   ${SYMBOL_DIR}/include
+  ${CMAKE_SOURCE_DIR}/src/ast/include
   ${LLVM_INCLUDE_DIR}
 )
 
 set (SYMBOL_SOURCES
-  ${SYMBOL_DIR}/Scope.cpp
   ${SYMBOL_DIR}/STManager.cpp
 )
\ No newline at end of file
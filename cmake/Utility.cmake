@@ -8,4 +8,5 @@ set (UTILITY_INCLUDE ${UTILITY_DIR}/include)
 
 set (UTILITY_SOURCES
   ${UTILITY_DIR}/WPLErrorHandler.cpp
+  ${UTILITY_DIR}/MemoryAccounting.cpp
 )
\ No newline at end of file
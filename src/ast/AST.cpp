@@ -0,0 +1,223 @@
+/**
+ * @file AST.cpp
+ * @author nllopez
+ * @brief Text of the AST nodes and the generic walks over the AST.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "AST.h"
+
+using namespace ast;
+
+llvm::StringRef Tree::save(llvm::StringRef text) {
+  if (text.empty()) {
+    return {};
+  }
+  char* data = allocator.Allocate<char>(text.size());
+  std::copy(text.begin(), text.end(), data);
+  return llvm::StringRef(data, text.size());
+}
+
+const char* BinaryExpr::spelling(Operator op) {
+  switch (op) {
+    case Operator::MUL: return "*";
+    case Operator::DIV: return "/";
+    case Operator::PLUS: return "+";
+    case Operator::MINUS: return "-";
+    case Operator::LESS: return "<";
+    case Operator::LEQ: return "<=";
+    case Operator::GTR: return ">";
+    case Operator::GEQ: return ">=";
+    case Operator::EQUAL: return "=";
+    case Operator::NEQ: return "~=";
+    case Operator::AND: return "&";
+    case Operator::OR: return "|";
+  }
+  return "";
+}
+
+/**
+ * @brief Rebuild the text of an expression from its tokens. Only used
+ *  for error messages, which quote the expressions they are about.
+ */
+std::string ast::getText(const Expr* e) {
+  // Each item is an expression still to be spelled or a piece of text.
+  // Items are pushed in reverse so that they come off in source order.
+  struct Item {
+    const Expr* e;
+    llvm::StringRef text;
+  };
+  llvm::SmallVector<Item, 32> work;
+  work.push_back({e, {}});
+  std::string text;
+  while (!work.empty()) {
+    Item item = work.pop_back_val();
+    if (item.e == nullptr) {
+      text += item.text;
+      continue;
+    }
+    switch (item.e->kind) {
+      case Kind::CallExpr: {
+        const CallExpr* call = llvm::cast<CallExpr>(item.e);
+        work.push_back({nullptr, ")"});
+        for (size_t i = call->args.size(); i > 0; i--) {
+          work.push_back({call->args[i - 1], {}});
+          if (i > 1) {
+            work.push_back({nullptr, ","});
+          }
+        }
+        work.push_back({nullptr, "("});
+        work.push_back({nullptr, call->id.text()});
+        break;
+      }
+      case Kind::SubscriptExpr: {
+        const SubscriptExpr* subscript = llvm::cast<SubscriptExpr>(item.e);
+        work.push_back({nullptr, "]"});
+        work.push_back({subscript->subscript, {}});
+        work.push_back({nullptr, "["});
+        work.push_back({nullptr, subscript->id.text()});
+        break;
+      }
+      case Kind::UMinusExpr:
+        work.push_back({llvm::cast<UnaryExpr>(item.e)->e, {}});
+        work.push_back({nullptr, "-"});
+        break;
+      case Kind::NotExpr:
+        work.push_back({llvm::cast<UnaryExpr>(item.e)->e, {}});
+        work.push_back({nullptr, "~"});
+        break;
+      case Kind::ParenExpr:
+        work.push_back({nullptr, ")"});
+        work.push_back({llvm::cast<ParenExpr>(item.e)->e, {}});
+        work.push_back({nullptr, "("});
+        break;
+      case Kind::ArrayLengthExpr:
+        text += llvm::cast<ArrayLengthExpr>(item.e)->arrayname.text();
+        text += ".length";
+        break;
+      case Kind::IDExpr:
+        text += llvm::cast<IDExpr>(item.e)->id.text();
+        break;
+      case Kind::Constant:
+        text += llvm::cast<Constant>(item.e)->text;
+        break;
+      default: {
+        const BinaryExpr* binary = llvm::cast<BinaryExpr>(item.e);
+        work.push_back({binary->right, {}});
+        work.push_back({nullptr, BinaryExpr::spelling(binary->op)});
+        work.push_back({binary->left, {}});
+      }
+    }
+  }
+  return text;
+}
+
+Expr* ast::operand(const Expr* e, size_t i) {
+  switch (e->kind) {
+    case Kind::CallExpr: {
+      llvm::ArrayRef<Expr*> args = llvm::cast<CallExpr>(e)->args;
+      return i < args.size() ? args[i] : nullptr;
+    }
+    case Kind::SubscriptExpr:
+      return i == 0 ? llvm::cast<SubscriptExpr>(e)->subscript : nullptr;
+    case Kind::UMinusExpr:
+    case Kind::NotExpr:
+      return i == 0 ? llvm::cast<UnaryExpr>(e)->e : nullptr;
+    case Kind::ParenExpr:
+      return i == 0 ? llvm::cast<ParenExpr>(e)->e : nullptr;
+    case Kind::MultExpr:
+    case Kind::AddExpr:
+    case Kind::RelExpr:
+    case Kind::EqExpr:
+    case Kind::AndExpr:
+    case Kind::OrExpr: {
+      const BinaryExpr* binary = llvm::cast<BinaryExpr>(e);
+      return i == 0 ? binary->left : i == 1 ? binary->right : nullptr;
+    }
+    default:
+      return nullptr;
+  }
+}
+
+void ast::children(Node* n, llvm::SmallVectorImpl<Node*>& out) {
+  switch (n->kind) {
+    case Kind::CompilationUnit:
+      for (Node* c : llvm::cast<CompilationUnit>(n)->components) out.push_back(c);
+      break;
+    case Kind::ScalarDeclaration:
+      for (Scalar* s : llvm::cast<ScalarDeclaration>(n)->scalars) out.push_back(s);
+      break;
+    case Kind::Scalar:
+      if (llvm::cast<Scalar>(n)->vi) out.push_back(llvm::cast<Scalar>(n)->vi);
+      break;
+    case Kind::ExternProcedure:
+    case Kind::ExternFunction:
+      for (Param* p : llvm::cast<ExternDeclaration>(n)->params) out.push_back(p);
+      break;
+    case Kind::Procedure:
+    case Kind::Function:
+      for (Param* p : llvm::cast<Routine>(n)->params) out.push_back(p);
+      out.push_back(llvm::cast<Routine>(n)->b);
+      break;
+    case Kind::Block:
+      for (Node* s : llvm::cast<Block>(n)->statements) out.push_back(s);
+      break;
+    case Kind::Assignment:
+      for (Expr* e : llvm::cast<Assignment>(n)->exprs) out.push_back(e);
+      break;
+    case Kind::ArrayAssignment:
+      out.push_back(llvm::cast<ArrayAssignment>(n)->target);
+      out.push_back(llvm::cast<ArrayAssignment>(n)->e);
+      break;
+    case Kind::Loop:
+      out.push_back(llvm::cast<Loop>(n)->e);
+      out.push_back(llvm::cast<Loop>(n)->b);
+      break;
+    case Kind::Conditional:
+      out.push_back(llvm::cast<Conditional>(n)->e);
+      out.push_back(llvm::cast<Conditional>(n)->yesblock);
+      if (llvm::cast<Conditional>(n)->noblock) out.push_back(llvm::cast<Conditional>(n)->noblock);
+      break;
+    case Kind::Select:
+      for (SelectAlt* a : llvm::cast<Select>(n)->alts) out.push_back(a);
+      break;
+    case Kind::SelectAlt:
+      out.push_back(llvm::cast<SelectAlt>(n)->e);
+      out.push_back(llvm::cast<SelectAlt>(n)->s);
+      break;
+    case Kind::Call:
+      for (Expr* e : llvm::cast<Call>(n)->args) out.push_back(e);
+      break;
+    case Kind::Return:
+      if (llvm::cast<Return>(n)->e) out.push_back(llvm::cast<Return>(n)->e);
+      break;
+    case Kind::CallExpr:
+      for (Expr* e : llvm::cast<CallExpr>(n)->args) out.push_back(e);
+      break;
+    case Kind::SubscriptExpr:
+      out.push_back(llvm::cast<SubscriptExpr>(n)->subscript);
+      break;
+    case Kind::UMinusExpr:
+    case Kind::NotExpr:
+      out.push_back(llvm::cast<UnaryExpr>(n)->e);
+      break;
+    case Kind::MultExpr:
+    case Kind::AddExpr:
+    case Kind::RelExpr:
+    case Kind::EqExpr:
+    case Kind::AndExpr:
+    case Kind::OrExpr:
+      out.push_back(llvm::cast<BinaryExpr>(n)->left);
+      out.push_back(llvm::cast<BinaryExpr>(n)->right);
+      break;
+    case Kind::ParenExpr:
+      out.push_back(llvm::cast<ParenExpr>(n)->e);
+      break;
+    case Kind::ArrayDeclaration:
+    case Kind::Param:
+    case Kind::ArrayLengthExpr:
+    case Kind::IDExpr:
+    case Kind::Constant:
+      break;
+  }
+}
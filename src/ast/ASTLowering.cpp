@@ -0,0 +1,349 @@
+/**
+ * @file ASTLowering.cpp
+ * @author nllopez
+ * @brief Implementation of the parse tree to AST lowering.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "ASTLowering.h"
+#include "llvm/Support/TimeProfiler.h"
+
+using namespace ast;
+
+std::unique_ptr<Tree> ASTLowering::lower(WPLParser::CompilationUnitContext* ctx,
+    std::shared_ptr<NameTable> names, llvm::StringRef source) {
+  return lower(llvm::makeArrayRef(ctx), std::move(names), source);
+}
+
+std::unique_ptr<Tree> ASTLowering::lower(llvm::ArrayRef<WPLParser::CompilationUnitContext*> units,
+    std::shared_ptr<NameTable> names, llvm::StringRef source) {
+  llvm::TimeTraceScope timeScope("Lower");
+  std::unique_ptr<Tree> tree = names ? std::make_unique<Tree>(std::move(names)) : std::make_unique<Tree>();
+  ASTLowering lowering(*tree, source);
+  llvm::SmallVector<Node*, 32> components;
+  for (WPLParser::CompilationUnitContext* ctx : units) {
+    for (WPLParser::CuComponentContext* e : ctx->components) {
+      components.push_back(lowering.component(e));
+    }
+  }
+  Span s = span(units.front());
+  s.end = span(units.back()).end;
+  tree->root = tree->create<CompilationUnit>(s, tree->copy<Node*>(components));
+  return tree;
+}
+
+Span ASTLowering::span(antlr4::ParserRuleContext* ctx) {
+  antlr4::Token* start = ctx->getStart();
+  Span s;
+  s.begin = start->getStartIndex();
+  s.end = ctx->getStop()->getStopIndex() + 1;
+  s.line = start->getLine();
+  s.column = start->getCharPositionInLine();
+  return s;
+}
+
+Identifier ASTLowering::identifier(antlr4::Token* token) {
+  if (!source.empty()) {
+    size_t start = token->getStartIndex();
+    return tree.intern(source.substr(start, token->getStopIndex() + 1 - start));
+  }
+  return tree.intern(token->getText());
+}
+
+TypeName ASTLowering::typeName(WPLParser::TypeContext* ctx) {
+  if (ctx == nullptr) {
+    return TypeName::NONE;
+  }
+  switch (ctx->getStart()->getType()) {
+    case WPLParser::BOOL: return TypeName::BOOL;
+    case WPLParser::INT: return TypeName::INT;
+    case WPLParser::STR: return TypeName::STR;
+  }
+  return TypeName::NONE;
+}
+
+Node* ASTLowering::component(WPLParser::CuComponentContext* ctx) {
+  if (ctx->varDeclaration()) {
+    return varDeclaration(ctx->varDeclaration());
+  }
+  if (ctx->procedure()) {
+    return procedure(ctx->procedure());
+  }
+  if (ctx->function()) {
+    return function(ctx->function());
+  }
+  return externDeclaration(ctx->externDeclaration());
+}
+
+Node* ASTLowering::varDeclaration(WPLParser::VarDeclarationContext* ctx) {
+  if (ctx->scalarDeclaration()) {
+    return scalarDeclaration(ctx->scalarDeclaration());
+  }
+  return arrayDeclaration(ctx->arrayDeclaration());
+}
+
+ScalarDeclaration* ASTLowering::scalarDeclaration(WPLParser::ScalarDeclarationContext* ctx) {
+  llvm::SmallVector<Scalar*, 4> scalars;
+  for (WPLParser::ScalarContext* sctx : ctx->scalars) {
+    Constant* init = sctx->vi ? constant(sctx->vi->c) : nullptr;
+    scalars.push_back(tree.create<Scalar>(span(sctx), identifier(sctx->id), init));
+  }
+  return tree.create<ScalarDeclaration>(span(ctx), typeName(ctx->t), tree.copy<Scalar*>(scalars));
+}
+
+ArrayDeclaration* ASTLowering::arrayDeclaration(WPLParser::ArrayDeclarationContext* ctx) {
+  return tree.create<ArrayDeclaration>(span(ctx), typeName(ctx->typename_),
+    tree.save(ctx->INTEGER()->getText()), identifier(ctx->ID()->getSymbol()));
+}
+
+ExternDeclaration* ASTLowering::externDeclaration(WPLParser::ExternDeclarationContext* ctx) {
+  if (WPLParser::ExternProcHeaderContext* ph = ctx->externProcHeader()) {
+    return tree.create<ExternDeclaration>(Kind::ExternProcedure, span(ctx), span(ph), TypeName::NONE,
+      identifier(ph->id), params(ph->params()), ph->ELLIPSIS() != nullptr);
+  }
+  WPLParser::ExternFuncHeaderContext* fh = ctx->externFuncHeader();
+  return tree.create<ExternDeclaration>(Kind::ExternFunction, span(ctx), span(fh), typeName(fh->t),
+    identifier(fh->id), params(fh->params()), fh->ELLIPSIS() != nullptr);
+}
+
+Routine* ASTLowering::procedure(WPLParser::ProcedureContext* ctx) {
+  WPLParser::ProcHeaderContext* ph = ctx->ph;
+  llvm::ArrayRef<Param*> p = params(ph->p);
+  return tree.create<Routine>(Kind::Procedure, span(ctx), span(ph), TypeName::NONE,
+    identifier(ph->id), p, block(ctx->b));
+}
+
+Routine* ASTLowering::function(WPLParser::FunctionContext* ctx) {
+  WPLParser::FuncHeaderContext* fh = ctx->fh;
+  llvm::ArrayRef<Param*> p = params(fh->p);
+  return tree.create<Routine>(Kind::Function, span(ctx), span(fh), typeName(fh->t),
+    identifier(fh->id), p, block(ctx->b));
+}
+
+/**
+ * @brief The grammar parses parameter names as expressions. The name of
+ *  a parameter is the text of its expression, which is an identifier
+ *  in any program that makes sense.
+ */
+llvm::ArrayRef<Param*> ASTLowering::params(WPLParser::ParamsContext* ctx) {
+  if (ctx == nullptr) {
+    return {};
+  }
+  llvm::SmallVector<Param*, 8> p;
+  for (size_t i = 0; i < ctx->types.size(); i++) {
+    WPLParser::ExprContext* name = ctx->ids[i];
+    p.push_back(tree.create<Param>(span(name), typeName(ctx->types[i]),
+      name->getStart() == name->getStop() ? identifier(name->getStart()) : tree.intern(name->getText())));
+  }
+  return tree.copy<Param*>(p);
+}
+
+Block* ASTLowering::block(WPLParser::BlockContext* ctx) {
+  llvm::SmallVector<Node*, 16> statements;
+  for (WPLParser::StatementContext* sctx : ctx->statement()) {
+    statements.push_back(statement(sctx));
+  }
+  return tree.create<Block>(span(ctx), tree.copy<Node*>(statements));
+}
+
+Node* ASTLowering::statement(WPLParser::StatementContext* ctx) {
+  if (WPLParser::AssignmentContext* a = ctx->assignment()) {
+    return assignment(a);
+  }
+  if (WPLParser::LoopContext* l = ctx->loop()) {
+    return tree.create<Loop>(span(l), expr(l->e), block(l->b));
+  }
+  if (WPLParser::SelectContext* s = ctx->select()) {
+    return select(s);
+  }
+  if (WPLParser::ConditionalContext* c = ctx->conditional()) {
+    Expr* e = expr(c->e);
+    Block* yes = block(c->yesblock);
+    Block* no = c->noblock ? block(c->noblock) : nullptr;
+    return tree.create<Conditional>(span(c), e, yes, no);
+  }
+  if (WPLParser::CallContext* c = ctx->call()) {
+    return call(c);
+  }
+  if (WPLParser::BlockContext* b = ctx->block()) {
+    return block(b);
+  }
+  if (WPLParser::ReturnContext* r = ctx->return_()) {
+    return tree.create<Return>(span(r), r->expr() ? expr(r->expr()) : nullptr);
+  }
+  return varDeclaration(ctx->varDeclaration());
+}
+
+Node* ASTLowering::assignment(WPLParser::AssignmentContext* ctx) {
+  if (ctx->arrayIndex()) {
+    SubscriptExpr* target = arrayIndex(ctx->arrayIndex());
+    return tree.create<ArrayAssignment>(span(ctx), target, expr(ctx->e[0]));
+  }
+  llvm::SmallVector<Identifier, 4> targets;
+  for (antlr4::Token* t : ctx->targets) {
+    targets.push_back(identifier(t));
+  }
+  llvm::ArrayRef<Identifier> t = tree.copy<Identifier>(targets);
+  return tree.create<Assignment>(span(ctx), t, exprs(ctx->exprs));
+}
+
+Select* ASTLowering::select(WPLParser::SelectContext* ctx) {
+  llvm::SmallVector<SelectAlt*, 8> alts;
+  for (WPLParser::SelectAltContext* alt : ctx->selectAlt()) {
+    Expr* e = expr(alt->e);
+    alts.push_back(tree.create<SelectAlt>(span(alt), e, statement(alt->s)));
+  }
+  return tree.create<Select>(span(ctx), tree.copy<SelectAlt*>(alts));
+}
+
+Call* ASTLowering::call(WPLParser::CallContext* ctx) {
+  llvm::SmallVector<Expr*, 8> args;
+  if (ctx->arguments()) {
+    for (WPLParser::ArgContext* arg : ctx->arguments()->args) {
+      args.push_back(expr(arg->expr()));
+    }
+  }
+  return tree.create<Call>(span(ctx), identifier(ctx->id), tree.copy<Expr*>(args));
+}
+
+SubscriptExpr* ASTLowering::arrayIndex(WPLParser::ArrayIndexContext* ctx) {
+  return tree.create<SubscriptExpr>(span(ctx), identifier(ctx->id), expr(ctx->expr()));
+}
+
+Constant* ASTLowering::constant(WPLParser::ConstantContext* ctx) {
+  antlr4::Token* token = ctx->getStart();
+  ConstantKind kind = ConstantKind::INTEGER;
+  if (token->getType() == WPLParser::BOOLEAN) {
+    kind = ConstantKind::BOOLEAN;
+  } else if (token->getType() == WPLParser::STRING) {
+    kind = ConstantKind::STRING;
+  }
+  return tree.create<Constant>(span(ctx), kind, tree.save(token->getText()));
+}
+
+llvm::ArrayRef<Expr*> ASTLowering::exprs(const std::vector<WPLParser::ExprContext*>& ctxs) {
+  llvm::SmallVector<Expr*, 8> e;
+  for (WPLParser::ExprContext* ctx : ctxs) {
+    e.push_back(expr(ctx));
+  }
+  return tree.copy<Expr*>(e);
+}
+
+static Operator binaryOperator(size_t type) {
+  switch (type) {
+    case WPLParser::MUL: return Operator::MUL;
+    case WPLParser::DIV: return Operator::DIV;
+    case WPLParser::PLUS: return Operator::PLUS;
+    case WPLParser::MINUS: return Operator::MINUS;
+    case WPLParser::LESS: return Operator::LESS;
+    case WPLParser::LEQ: return Operator::LEQ;
+    case WPLParser::GTR: return Operator::GTR;
+    case WPLParser::GEQ: return Operator::GEQ;
+    case WPLParser::EQUAL: return Operator::EQUAL;
+    case WPLParser::NEQ: return Operator::NEQ;
+    case WPLParser::AND: return Operator::AND;
+  }
+  return Operator::OR;
+}
+
+// The AST kind of an alternative of expr
+static Kind exprKind(WPLParser::ExprContext* ctx) {
+  if (dynamic_cast<WPLParser::IDExprContext*>(ctx)) return Kind::IDExpr;
+  if (dynamic_cast<WPLParser::ConstExprContext*>(ctx)) return Kind::Constant;
+  if (dynamic_cast<WPLParser::MultExprContext*>(ctx)) return Kind::MultExpr;
+  if (dynamic_cast<WPLParser::AddExprContext*>(ctx)) return Kind::AddExpr;
+  if (dynamic_cast<WPLParser::RelExprContext*>(ctx)) return Kind::RelExpr;
+  if (dynamic_cast<WPLParser::EqExprContext*>(ctx)) return Kind::EqExpr;
+  if (dynamic_cast<WPLParser::AndExprContext*>(ctx)) return Kind::AndExpr;
+  if (dynamic_cast<WPLParser::OrExprContext*>(ctx)) return Kind::OrExpr;
+  if (dynamic_cast<WPLParser::ParenExprContext*>(ctx)) return Kind::ParenExpr;
+  if (dynamic_cast<WPLParser::UMinusExprContext*>(ctx)) return Kind::UMinusExpr;
+  if (dynamic_cast<WPLParser::NotExprContext*>(ctx)) return Kind::NotExpr;
+  if (dynamic_cast<WPLParser::FuncProcCallExprContext*>(ctx)) return Kind::CallExpr;
+  if (dynamic_cast<WPLParser::SubscriptExprContext*>(ctx)) return Kind::SubscriptExpr;
+  return Kind::ArrayLengthExpr;
+}
+
+// The i-th operand of an alternative of expr, or nullptr past the last one
+static WPLParser::ExprContext* exprOperand(WPLParser::ExprContext* ctx, Kind kind, size_t i) {
+  switch (kind) {
+    case Kind::IDExpr:
+    case Kind::Constant:
+    case Kind::ArrayLengthExpr:
+      return nullptr;
+    case Kind::ParenExpr:
+      return i == 0 ? static_cast<WPLParser::ParenExprContext*>(ctx)->expr() : nullptr;
+    case Kind::UMinusExpr:
+      return i == 0 ? static_cast<WPLParser::UMinusExprContext*>(ctx)->e : nullptr;
+    case Kind::NotExpr:
+      return i == 0 ? static_cast<WPLParser::NotExprContext*>(ctx)->e : nullptr;
+    case Kind::CallExpr: {
+      std::vector<WPLParser::ExprContext*>& args = static_cast<WPLParser::FuncProcCallExprContext*>(ctx)->args;
+      return i < args.size() ? args[i] : nullptr;
+    }
+    case Kind::SubscriptExpr:
+      return i == 0 ? static_cast<WPLParser::SubscriptExprContext*>(ctx)->arrayIndex()->expr() : nullptr;
+    default:
+      // Every binary alternative is left=expr operator right=expr
+      return i < 2 ? static_cast<WPLParser::ExprContext*>(ctx->children[2 * i]) : nullptr;
+  }
+}
+
+/**
+ * @brief Lower an expression from a work stack rather than by recursion,
+ *  since machine-generated expressions nest deeper than the C++ stack
+ *  allows. An expression is built once all its operands have been.
+ */
+Expr* ASTLowering::expr(WPLParser::ExprContext* root) {
+  struct Pending {
+    WPLParser::ExprContext* ctx;
+    Kind kind;
+    size_t next;        // the operand to lower next
+    size_t results;     // where the lowered operands start
+  };
+  llvm::SmallVector<Pending, 16> work;
+  llvm::SmallVector<Expr*, 16> results;
+  work.push_back({root, exprKind(root), 0, 0});
+  while (!work.empty()) {
+    Pending& p = work.back();
+    if (WPLParser::ExprContext* next = exprOperand(p.ctx, p.kind, p.next)) {
+      p.next++;
+      work.push_back({next, exprKind(next), 0, results.size()});
+      continue;
+    }
+    Expr* e = exprNode(p.ctx, p.kind, llvm::makeArrayRef(results).drop_front(p.results));
+    results.truncate(p.results);
+    work.pop_back();
+    results.push_back(e);
+  }
+  return results.back();
+}
+
+Expr* ASTLowering::exprNode(WPLParser::ExprContext* ctx, Kind kind, llvm::ArrayRef<Expr*> operands) {
+  Span s = span(ctx);
+  switch (kind) {
+    case Kind::IDExpr:
+      return tree.create<IDExpr>(s, identifier(static_cast<WPLParser::IDExprContext*>(ctx)->ID()->getSymbol()));
+    case Kind::Constant:
+      return constant(static_cast<WPLParser::ConstExprContext*>(ctx)->constant());
+    case Kind::ArrayLengthExpr:
+      return tree.create<ArrayLengthExpr>(s, identifier(ctx->getStart()));
+    case Kind::ParenExpr:
+      return tree.create<ParenExpr>(s, operands[0]);
+    case Kind::UMinusExpr:
+    case Kind::NotExpr:
+      return tree.create<UnaryExpr>(kind, s, operands[0]);
+    case Kind::CallExpr: {
+      Identifier name = identifier(static_cast<WPLParser::FuncProcCallExprContext*>(ctx)->fpname);
+      return tree.create<CallExpr>(s, name, tree.copy<Expr*>(operands));
+    }
+    case Kind::SubscriptExpr: {
+      WPLParser::ArrayIndexContext* index = static_cast<WPLParser::SubscriptExprContext*>(ctx)->arrayIndex();
+      return tree.create<SubscriptExpr>(span(index), identifier(index->id), operands[0]);
+    }
+    default: {
+      antlr4::tree::TerminalNode* op = static_cast<antlr4::tree::TerminalNode*>(ctx->children[1]);
+      return tree.create<BinaryExpr>(kind, s, binaryOperator(op->getSymbol()->getType()), operands[0], operands[1]);
+    }
+  }
+}
@@ -0,0 +1,407 @@
+/**
+ * @file AST.h
+ * @author nllopez
+ * @brief The abstract syntax tree that the semantic and code generating
+ *  visitors work on. It is lowered from the ANTLR parse tree, after
+ *  which the parse tree and the tokens can be freed.
+ *
+ *  Every node is allocated in the bump allocator of its Tree and is
+ *  never destroyed on its own, so nodes hold only plain data: child
+ *  pointers, arrays of children that live in the same allocator,
+ *  interned identifiers and a source span. The nodes are numbered
+ *  densely in the order they are created, so per-node data can be kept
+ *  in flat arrays indexed by Node::index.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "Identifier.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/Casting.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+namespace ast {
+
+/**
+ * @brief Where a node is in the source. begin and end are character
+ *  indices into the input stream, end one past the last character.
+ *  line and column are those of the first token, as ANTLR counts them.
+ */
+struct Span {
+  uint32_t begin = 0;
+  uint32_t end = 0;
+  uint32_t line = 0;
+  uint32_t column = 0;
+};
+
+// The declared types. NONE is a 'var' declaration or a procedure.
+enum class TypeName : uint8_t {NONE, BOOL, INT, STR};
+
+// One kind for each grammar rule or labeled expr alternative
+enum class Kind : uint8_t {
+  CompilationUnit,
+  // Declarations
+  ScalarDeclaration,
+  Scalar,
+  ArrayDeclaration,
+  ExternProcedure,
+  ExternFunction,
+  Procedure,
+  Function,
+  Param,
+  // Statements
+  Block,
+  Assignment,
+  ArrayAssignment,
+  Loop,
+  Conditional,
+  Select,
+  SelectAlt,
+  Call,
+  Return,
+  // Expressions
+  CallExpr,
+  SubscriptExpr,
+  UMinusExpr,
+  NotExpr,
+  MultExpr,
+  AddExpr,
+  RelExpr,
+  EqExpr,
+  AndExpr,
+  OrExpr,
+  ParenExpr,
+  ArrayLengthExpr,
+  IDExpr,
+  Constant
+};
+
+class Node {
+  public:
+    Kind getKind() const { return kind; }
+
+    const Kind kind;
+    uint32_t index = 0;    // dense, in creation order
+    Span span;
+
+  protected:
+    Node(Kind k, Span s) : kind(k), span(s) {}
+};
+
+/******************************************************************
+ * Expressions
+ ******************************************************************/
+class Expr : public Node {
+  public:
+    static bool classof(const Node* n) { return n->kind >= Kind::CallExpr; }
+
+  protected:
+    Expr(Kind k, Span s) : Node(k, s) {}
+};
+
+class CallExpr : public Expr {
+  public:
+    CallExpr(Span s, Identifier name, llvm::ArrayRef<Expr*> a) : Expr(Kind::CallExpr, s), id(name), args(a) {}
+    static bool classof(const Node* n) { return n->kind == Kind::CallExpr; }
+
+    Identifier id;
+    llvm::ArrayRef<Expr*> args;
+};
+
+// An array element, also the target of an array assignment
+class SubscriptExpr : public Expr {
+  public:
+    SubscriptExpr(Span s, Identifier name, Expr* i) : Expr(Kind::SubscriptExpr, s), id(name), subscript(i) {}
+    static bool classof(const Node* n) { return n->kind == Kind::SubscriptExpr; }
+
+    Identifier id;
+    Expr* subscript;
+};
+
+// '-' or '~'
+class UnaryExpr : public Expr {
+  public:
+    UnaryExpr(Kind k, Span s, Expr* operand) : Expr(k, s), e(operand) {}
+    static bool classof(const Node* n) { return n->kind == Kind::UMinusExpr || n->kind == Kind::NotExpr; }
+
+    Expr* e;
+};
+
+enum class Operator : uint8_t {MUL, DIV, PLUS, MINUS, LESS, LEQ, GTR, GEQ, EQUAL, NEQ, AND, OR};
+
+// The kind is that of the operator's alternative in the grammar
+class BinaryExpr : public Expr {
+  public:
+    BinaryExpr(Kind k, Span s, Operator o, Expr* l, Expr* r) : Expr(k, s), op(o), left(l), right(r) {}
+    static bool classof(const Node* n) { return n->kind >= Kind::MultExpr && n->kind <= Kind::OrExpr; }
+    static const char* spelling(Operator op);
+
+    Operator op;
+    Expr* left;
+    Expr* right;
+};
+
+class ParenExpr : public Expr {
+  public:
+    ParenExpr(Span s, Expr* inner) : Expr(Kind::ParenExpr, s), e(inner) {}
+    static bool classof(const Node* n) { return n->kind == Kind::ParenExpr; }
+
+    Expr* e;
+};
+
+class ArrayLengthExpr : public Expr {
+  public:
+    ArrayLengthExpr(Span s, Identifier name) : Expr(Kind::ArrayLengthExpr, s), arrayname(name) {}
+    static bool classof(const Node* n) { return n->kind == Kind::ArrayLengthExpr; }
+
+    Identifier arrayname;
+};
+
+class IDExpr : public Expr {
+  public:
+    IDExpr(Span s, Identifier name) : Expr(Kind::IDExpr, s), id(name) {}
+    static bool classof(const Node* n) { return n->kind == Kind::IDExpr; }
+
+    Identifier id;
+};
+
+enum class ConstantKind : uint8_t {INTEGER, BOOLEAN, STRING};
+
+// The text is the token text, quotes and escapes included
+class Constant : public Expr {
+  public:
+    Constant(Span s, ConstantKind k, llvm::StringRef t) : Expr(Kind::Constant, s), constantKind(k), text(t) {}
+    static bool classof(const Node* n) { return n->kind == Kind::Constant; }
+
+    ConstantKind constantKind;
+    llvm::StringRef text;
+};
+
+/******************************************************************
+ * Statements
+ ******************************************************************/
+class Block : public Node {
+  public:
+    Block(Span s, llvm::ArrayRef<Node*> body) : Node(Kind::Block, s), statements(body) {}
+    static bool classof(const Node* n) { return n->kind == Kind::Block; }
+
+    llvm::ArrayRef<Node*> statements;
+};
+
+class Assignment : public Node {
+  public:
+    Assignment(Span s, llvm::ArrayRef<Identifier> t, llvm::ArrayRef<Expr*> e)
+      : Node(Kind::Assignment, s), targets(t), exprs(e) {}
+    static bool classof(const Node* n) { return n->kind == Kind::Assignment; }
+
+    llvm::ArrayRef<Identifier> targets;
+    llvm::ArrayRef<Expr*> exprs;
+};
+
+class ArrayAssignment : public Node {
+  public:
+    ArrayAssignment(Span s, SubscriptExpr* t, Expr* v) : Node(Kind::ArrayAssignment, s), target(t), e(v) {}
+    static bool classof(const Node* n) { return n->kind == Kind::ArrayAssignment; }
+
+    SubscriptExpr* target;
+    Expr* e;
+};
+
+class Loop : public Node {
+  public:
+    Loop(Span s, Expr* cond, Block* body) : Node(Kind::Loop, s), e(cond), b(body) {}
+    static bool classof(const Node* n) { return n->kind == Kind::Loop; }
+
+    Expr* e;
+    Block* b;
+};
+
+class Conditional : public Node {
+  public:
+    Conditional(Span s, Expr* cond, Block* yes, Block* no)
+      : Node(Kind::Conditional, s), e(cond), yesblock(yes), noblock(no) {}
+    static bool classof(const Node* n) { return n->kind == Kind::Conditional; }
+
+    Expr* e;
+    Block* yesblock;
+    Block* noblock;    // nullptr without an else
+};
+
+class SelectAlt : public Node {
+  public:
+    SelectAlt(Span span, Expr* cond, Node* statement) : Node(Kind::SelectAlt, span), e(cond), s(statement) {}
+    static bool classof(const Node* n) { return n->kind == Kind::SelectAlt; }
+
+    Expr* e;
+    Node* s;
+};
+
+class Select : public Node {
+  public:
+    Select(Span s, llvm::ArrayRef<SelectAlt*> a) : Node(Kind::Select, s), alts(a) {}
+    static bool classof(const Node* n) { return n->kind == Kind::Select; }
+
+    llvm::ArrayRef<SelectAlt*> alts;
+};
+
+class Call : public Node {
+  public:
+    Call(Span s, Identifier name, llvm::ArrayRef<Expr*> a) : Node(Kind::Call, s), id(name), args(a) {}
+    static bool classof(const Node* n) { return n->kind == Kind::Call; }
+
+    Identifier id;
+    llvm::ArrayRef<Expr*> args;
+};
+
+class Return : public Node {
+  public:
+    Return(Span s, Expr* value) : Node(Kind::Return, s), e(value) {}
+    static bool classof(const Node* n) { return n->kind == Kind::Return; }
+
+    Expr* e;    // nullptr in a procedure
+};
+
+/******************************************************************
+ * Declarations
+ ******************************************************************/
+class Scalar : public Node {
+  public:
+    Scalar(Span s, Identifier name, Constant* init) : Node(Kind::Scalar, s), id(name), vi(init) {}
+    static bool classof(const Node* n) { return n->kind == Kind::Scalar; }
+
+    Identifier id;
+    Constant* vi;    // nullptr without an initializer
+};
+
+class ScalarDeclaration : public Node {
+  public:
+    ScalarDeclaration(Span s, TypeName type, llvm::ArrayRef<Scalar*> v)
+      : Node(Kind::ScalarDeclaration, s), t(type), scalars(v) {}
+    static bool classof(const Node* n) { return n->kind == Kind::ScalarDeclaration; }
+
+    TypeName t;    // NONE for 'var'
+    llvm::ArrayRef<Scalar*> scalars;
+};
+
+class ArrayDeclaration : public Node {
+  public:
+    ArrayDeclaration(Span s, TypeName type, llvm::StringRef n, Identifier name)
+      : Node(Kind::ArrayDeclaration, s), t(type), size(n), id(name) {}
+    static bool classof(const Node* n) { return n->kind == Kind::ArrayDeclaration; }
+
+    TypeName t;
+    llvm::StringRef size;    // the INTEGER token text
+    Identifier id;
+};
+
+// The span is that of the name, which the grammar parses as an expr
+class Param : public Node {
+  public:
+    Param(Span s, TypeName type, Identifier name) : Node(Kind::Param, s), t(type), id(name) {}
+    static bool classof(const Node* n) { return n->kind == Kind::Param; }
+
+    TypeName t;
+    Identifier id;
+};
+
+// The span covers 'extern' to ';', the header span the proc or func header
+class ExternDeclaration : public Node {
+  public:
+    ExternDeclaration(Kind k, Span s, Span h, TypeName type, Identifier name,
+        llvm::ArrayRef<Param*> p, bool ellipsis)
+      : Node(k, s), header(h), t(type), id(name), params(p), variadic(ellipsis) {}
+    static bool classof(const Node* n) { return n->kind == Kind::ExternProcedure || n->kind == Kind::ExternFunction; }
+
+    Span header;
+    TypeName t;    // NONE for a procedure
+    Identifier id;
+    llvm::ArrayRef<Param*> params;
+    bool variadic;
+};
+
+// A procedure or function definition
+class Routine : public Node {
+  public:
+    Routine(Kind k, Span s, Span h, TypeName type, Identifier name, llvm::ArrayRef<Param*> p, Block* body)
+      : Node(k, s), header(h), t(type), id(name), params(p), b(body) {}
+    static bool classof(const Node* n) { return n->kind == Kind::Procedure || n->kind == Kind::Function; }
+
+    Span header;
+    TypeName t;    // NONE for a procedure
+    Identifier id;
+    llvm::ArrayRef<Param*> params;
+    Block* b;
+};
+
+class CompilationUnit : public Node {
+  public:
+    CompilationUnit(Span s, llvm::ArrayRef<Node*> c) : Node(Kind::CompilationUnit, s), components(c) {}
+    static bool classof(const Node* n) { return n->kind == Kind::CompilationUnit; }
+
+    llvm::ArrayRef<Node*> components;
+};
+
+/**
+ * @brief Owns the nodes, identifiers and strings of one compilation
+ *  unit. Everything is freed at once when the tree is destroyed.
+ */
+class Tree {
+  public:
+    // A tree with identifiers of its own
+    Tree() : names(std::make_shared<NameTable>()) {}
+    // A tree whose identifiers are shared with other trees, so that
+    // symbols keyed on them work across all of them
+    explicit Tree(std::shared_ptr<NameTable> table) : names(std::move(table)) {}
+    Tree(const Tree&) = delete;
+    Tree& operator=(const Tree&) = delete;
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+      static_assert(std::is_trivially_destructible<T>::value, "AST nodes are never destroyed");
+      T* node = new (allocator.Allocate<T>()) T(std::forward<Args>(args)...);
+      node->index = nodeCount++;
+      return node;
+    }
+
+    // Copy a list of children into the tree
+    template <typename T>
+    llvm::ArrayRef<T> copy(llvm::ArrayRef<T> items) {
+      if (items.empty()) {
+        return {};
+      }
+      T* data = allocator.Allocate<T>(items.size());
+      std::uninitialized_copy(items.begin(), items.end(), data);
+      return llvm::ArrayRef<T>(data, items.size());
+    }
+
+    Identifier intern(llvm::StringRef name) { return names->intern(name); }
+    llvm::StringRef save(llvm::StringRef text);
+
+    CompilationUnit* root = nullptr;
+    uint32_t size() const { return nodeCount; }
+    uint32_t identifierCount() const { return names->size(); }
+    size_t bytesAllocated() const { return allocator.getTotalMemory() + names->bytesAllocated(); }
+
+  private:
+    llvm::BumpPtrAllocator allocator;
+    std::shared_ptr<NameTable> names;
+    uint32_t nodeCount = 0;
+};
+
+// The source text of an expression without whitespace, as getText() gives it
+std::string getText(const Expr* e);
+
+// The children of a node in source order
+void children(Node* n, llvm::SmallVectorImpl<Node*>& out);
+
+// The i-th operand of an expression in source order, or nullptr past the
+// last one. Lets the expression walks keep their place on a work stack.
+Expr* operand(const Expr* e, size_t i);
+
+} // namespace ast
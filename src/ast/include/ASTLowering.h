@@ -0,0 +1,56 @@
+/**
+ * @file ASTLowering.h
+ * @author nllopez
+ * @brief Lowers the parse tree built by WPLParser (or WPLFastParser)
+ *  into the AST. The AST copies everything it needs out of the contexts
+ *  and tokens, so they may be freed as soon as lower() returns.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "AST.h"
+#include "WPLParser.h"
+#include <memory>
+
+class ASTLowering {
+  public:
+    // Identifiers are interned into names, or into a table of the tree's
+    // own if there is none. When the token indexes are byte offsets into
+    // source, identifiers are interned straight from its bytes instead of
+    // from a copy of the token text.
+    static std::unique_ptr<ast::Tree> lower(WPLParser::CompilationUnitContext* ctx,
+        std::shared_ptr<ast::NameTable> names = nullptr, llvm::StringRef source = {});
+    // One compilation unit from the parse trees of consecutive slices of
+    // the input, in source order
+    static std::unique_ptr<ast::Tree> lower(llvm::ArrayRef<WPLParser::CompilationUnitContext*> units,
+        std::shared_ptr<ast::NameTable> names = nullptr, llvm::StringRef source = {});
+
+  private:
+    ASTLowering(ast::Tree& t, llvm::StringRef s) : tree(t), source(s) {}
+
+    ast::Node* component(WPLParser::CuComponentContext* ctx);
+    ast::Node* varDeclaration(WPLParser::VarDeclarationContext* ctx);
+    ast::ScalarDeclaration* scalarDeclaration(WPLParser::ScalarDeclarationContext* ctx);
+    ast::ArrayDeclaration* arrayDeclaration(WPLParser::ArrayDeclarationContext* ctx);
+    ast::ExternDeclaration* externDeclaration(WPLParser::ExternDeclarationContext* ctx);
+    ast::Routine* procedure(WPLParser::ProcedureContext* ctx);
+    ast::Routine* function(WPLParser::FunctionContext* ctx);
+    llvm::ArrayRef<ast::Param*> params(WPLParser::ParamsContext* ctx);
+    ast::Block* block(WPLParser::BlockContext* ctx);
+    ast::Node* statement(WPLParser::StatementContext* ctx);
+    ast::Node* assignment(WPLParser::AssignmentContext* ctx);
+    ast::Select* select(WPLParser::SelectContext* ctx);
+    ast::Call* call(WPLParser::CallContext* ctx);
+    ast::SubscriptExpr* arrayIndex(WPLParser::ArrayIndexContext* ctx);
+    ast::Constant* constant(WPLParser::ConstantContext* ctx);
+    ast::Expr* expr(WPLParser::ExprContext* ctx);
+    ast::Expr* exprNode(WPLParser::ExprContext* ctx, ast::Kind kind, llvm::ArrayRef<ast::Expr*> operands);
+    llvm::ArrayRef<ast::Expr*> exprs(const std::vector<WPLParser::ExprContext*>& ctxs);
+
+    static ast::Span span(antlr4::ParserRuleContext* ctx);
+    static ast::TypeName typeName(WPLParser::TypeContext* ctx);
+    ast::Identifier identifier(antlr4::Token* token);
+
+    ast::Tree& tree;
+    llvm::StringRef source;
+};
@@ -0,0 +1,174 @@
+/**
+ * @file ASTVisitor.h
+ * @author nllopez
+ * @brief Base class for the visitors that walk the AST. A visitor
+ *  derives from ASTVisitor<Derived, RetTy> and hides the visit methods
+ *  it cares about; visit() switches on the node kind and calls the
+ *  Derived method directly, so there is no virtual call and no
+ *  std::any on the way back. Like the ANTLR generated base visitor,
+ *  the default visit methods visit the children and return the result
+ *  of the last one. Expressions are the exception: see visitExpr().
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "AST.h"
+
+template <typename Derived, typename RetTy>
+class ASTVisitor {
+  public:
+    RetTy visit(ast::Node* n) {
+      Derived* d = static_cast<Derived*>(this);
+      switch (n->kind) {
+        case ast::Kind::CompilationUnit: return d->visitCompilationUnit(llvm::cast<ast::CompilationUnit>(n));
+        case ast::Kind::ScalarDeclaration: return d->visitScalarDeclaration(llvm::cast<ast::ScalarDeclaration>(n));
+        case ast::Kind::Scalar: return d->visitScalar(llvm::cast<ast::Scalar>(n));
+        case ast::Kind::ArrayDeclaration: return d->visitArrayDeclaration(llvm::cast<ast::ArrayDeclaration>(n));
+        case ast::Kind::ExternProcedure:
+        case ast::Kind::ExternFunction: return d->visitExternDeclaration(llvm::cast<ast::ExternDeclaration>(n));
+        case ast::Kind::Procedure: return d->visitProcedure(llvm::cast<ast::Routine>(n));
+        case ast::Kind::Function: return d->visitFunction(llvm::cast<ast::Routine>(n));
+        case ast::Kind::Param: return d->visitParam(llvm::cast<ast::Param>(n));
+        case ast::Kind::Block: return d->visitBlock(llvm::cast<ast::Block>(n));
+        case ast::Kind::Assignment: return d->visitAssignment(llvm::cast<ast::Assignment>(n));
+        case ast::Kind::ArrayAssignment: return d->visitArrayAssignment(llvm::cast<ast::ArrayAssignment>(n));
+        case ast::Kind::Loop: return d->visitLoop(llvm::cast<ast::Loop>(n));
+        case ast::Kind::Conditional: return d->visitConditional(llvm::cast<ast::Conditional>(n));
+        case ast::Kind::Select: return d->visitSelect(llvm::cast<ast::Select>(n));
+        case ast::Kind::SelectAlt: return d->visitSelectAlt(llvm::cast<ast::SelectAlt>(n));
+        case ast::Kind::Call: return d->visitCall(llvm::cast<ast::Call>(n));
+        case ast::Kind::Return: return d->visitReturn(llvm::cast<ast::Return>(n));
+        case ast::Kind::CallExpr:
+        case ast::Kind::SubscriptExpr:
+        case ast::Kind::UMinusExpr:
+        case ast::Kind::NotExpr:
+        case ast::Kind::MultExpr:
+        case ast::Kind::AddExpr:
+        case ast::Kind::RelExpr:
+        case ast::Kind::EqExpr:
+        case ast::Kind::AndExpr:
+        case ast::Kind::OrExpr:
+        case ast::Kind::ParenExpr:
+        case ast::Kind::ArrayLengthExpr:
+        case ast::Kind::IDExpr:
+        case ast::Kind::Constant: return visitExpr(llvm::cast<ast::Expr>(n));
+      }
+      return RetTy();
+    }
+
+    /**
+     * Visit an expression with a work stack of its own instead of the C++
+     * stack, so that how deep expressions nest is limited by memory only.
+     * Derived::enterExpr() sees each expression before its operands and
+     * may give its result right away, in which case the operands are
+     * skipped. Otherwise the operands are visited left to right and the
+     * visit method of the expression gets their results. Either way
+     * Derived::leaveExpr() then sees the result of the expression.
+     */
+    RetTy visitExpr(ast::Expr* root) {
+      Derived* d = static_cast<Derived*>(this);
+      struct Pending {
+        ast::Expr* e;
+        size_t next;        // the operand to visit next
+        size_t results;     // where the results of its operands start
+      };
+      llvm::SmallVector<Pending, 16> work;
+      llvm::SmallVector<RetTy, 16> results;
+      auto enter = [&](ast::Expr* e) {
+        RetTy result = RetTy();
+        if (d->enterExpr(e, result)) {
+          work.push_back({e, 0, results.size()});
+        } else {
+          d->leaveExpr(e, result);
+          results.push_back(result);
+        }
+      };
+      enter(root);
+      while (!work.empty()) {
+        Pending& p = work.back();
+        if (ast::Expr* next = ast::operand(p.e, p.next)) {
+          p.next++;
+          enter(next);
+          continue;
+        }
+        RetTy result = exitExpr(p.e, llvm::makeArrayRef(results).drop_front(p.results));
+        d->leaveExpr(p.e, result);
+        results.truncate(p.results);
+        work.pop_back();
+        results.push_back(result);
+      }
+      return results.back();
+    }
+
+    RetTy visitChildren(ast::Node* n) {
+      llvm::SmallVector<ast::Node*, 8> nodes;
+      ast::children(n, nodes);
+      RetTy result = RetTy();
+      for (ast::Node* c : nodes) {
+        result = visit(c);
+      }
+      return result;
+    }
+
+    RetTy visitCompilationUnit(ast::CompilationUnit* n) { return visitChildren(n); }
+    RetTy visitScalarDeclaration(ast::ScalarDeclaration* n) { return visitChildren(n); }
+    RetTy visitScalar(ast::Scalar* n) { return visitChildren(n); }
+    RetTy visitArrayDeclaration(ast::ArrayDeclaration* n) { return visitChildren(n); }
+    RetTy visitExternDeclaration(ast::ExternDeclaration* n) { return visitChildren(n); }
+    RetTy visitProcedure(ast::Routine* n) { return visitChildren(n); }
+    RetTy visitFunction(ast::Routine* n) { return visitChildren(n); }
+    RetTy visitParam(ast::Param* n) { return visitChildren(n); }
+    RetTy visitBlock(ast::Block* n) { return visitChildren(n); }
+    RetTy visitAssignment(ast::Assignment* n) { return visitChildren(n); }
+    RetTy visitArrayAssignment(ast::ArrayAssignment* n) { return visitChildren(n); }
+    RetTy visitLoop(ast::Loop* n) { return visitChildren(n); }
+    RetTy visitConditional(ast::Conditional* n) { return visitChildren(n); }
+    RetTy visitSelect(ast::Select* n) { return visitChildren(n); }
+    RetTy visitSelectAlt(ast::SelectAlt* n) { return visitChildren(n); }
+    RetTy visitCall(ast::Call* n) { return visitChildren(n); }
+    RetTy visitReturn(ast::Return* n) { return visitChildren(n); }
+
+    // An expression's operands have been visited by the time its visit
+    // method is called. By default the result is that of the last operand.
+    bool enterExpr(ast::Expr* n, RetTy& result) { return true; }
+    void leaveExpr(ast::Expr* n, const RetTy& result) {}
+    RetTy visitFuncProcCallExpr(ast::CallExpr* n, llvm::ArrayRef<RetTy> args) {
+      return args.empty() ? RetTy() : args.back();
+    }
+    RetTy visitSubscriptExpr(ast::SubscriptExpr* n, RetTy subscript) { return subscript; }
+    RetTy visitUMinusExpr(ast::UnaryExpr* n, RetTy e) { return e; }
+    RetTy visitNotExpr(ast::UnaryExpr* n, RetTy e) { return e; }
+    RetTy visitMultExpr(ast::BinaryExpr* n, RetTy left, RetTy right) { return right; }
+    RetTy visitAddExpr(ast::BinaryExpr* n, RetTy left, RetTy right) { return right; }
+    RetTy visitRelExpr(ast::BinaryExpr* n, RetTy left, RetTy right) { return right; }
+    RetTy visitEqExpr(ast::BinaryExpr* n, RetTy left, RetTy right) { return right; }
+    RetTy visitAndExpr(ast::BinaryExpr* n, RetTy left, RetTy right) { return right; }
+    RetTy visitOrExpr(ast::BinaryExpr* n, RetTy left, RetTy right) { return right; }
+    RetTy visitParenExpr(ast::ParenExpr* n, RetTy e) { return e; }
+    RetTy visitArrayLengthExpr(ast::ArrayLengthExpr* n) { return RetTy(); }
+    RetTy visitIDExpr(ast::IDExpr* n) { return RetTy(); }
+    RetTy visitConstant(ast::Constant* n) { return RetTy(); }
+
+  private:
+    // Hand the results of its operands to the visit method of an expression
+    RetTy exitExpr(ast::Expr* n, llvm::ArrayRef<RetTy> operands) {
+      Derived* d = static_cast<Derived*>(this);
+      switch (n->kind) {
+        case ast::Kind::CallExpr: return d->visitFuncProcCallExpr(llvm::cast<ast::CallExpr>(n), operands);
+        case ast::Kind::SubscriptExpr: return d->visitSubscriptExpr(llvm::cast<ast::SubscriptExpr>(n), operands[0]);
+        case ast::Kind::UMinusExpr: return d->visitUMinusExpr(llvm::cast<ast::UnaryExpr>(n), operands[0]);
+        case ast::Kind::NotExpr: return d->visitNotExpr(llvm::cast<ast::UnaryExpr>(n), operands[0]);
+        case ast::Kind::MultExpr: return d->visitMultExpr(llvm::cast<ast::BinaryExpr>(n), operands[0], operands[1]);
+        case ast::Kind::AddExpr: return d->visitAddExpr(llvm::cast<ast::BinaryExpr>(n), operands[0], operands[1]);
+        case ast::Kind::RelExpr: return d->visitRelExpr(llvm::cast<ast::BinaryExpr>(n), operands[0], operands[1]);
+        case ast::Kind::EqExpr: return d->visitEqExpr(llvm::cast<ast::BinaryExpr>(n), operands[0], operands[1]);
+        case ast::Kind::AndExpr: return d->visitAndExpr(llvm::cast<ast::BinaryExpr>(n), operands[0], operands[1]);
+        case ast::Kind::OrExpr: return d->visitOrExpr(llvm::cast<ast::BinaryExpr>(n), operands[0], operands[1]);
+        case ast::Kind::ParenExpr: return d->visitParenExpr(llvm::cast<ast::ParenExpr>(n), operands[0]);
+        case ast::Kind::ArrayLengthExpr: return d->visitArrayLengthExpr(llvm::cast<ast::ArrayLengthExpr>(n));
+        case ast::Kind::IDExpr: return d->visitIDExpr(llvm::cast<ast::IDExpr>(n));
+        case ast::Kind::Constant: return d->visitConstant(llvm::cast<ast::Constant>(n));
+        default: return RetTy();
+      }
+    }
+};
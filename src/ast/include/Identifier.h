@@ -0,0 +1,56 @@
+/**
+ * @file Identifier.h
+ * @author nllopez
+ * @brief Interned identifiers. Every spelling is stored once in a
+ *  NameTable and gets a small id, in the order the spellings are first
+ *  seen. The symbol table and code generator key on the id, so they
+ *  neither copy nor compare the text of an identifier.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
+#include <cstdint>
+
+namespace ast {
+
+/**
+ * @brief An identifier interned by a NameTable. Two identifiers with the
+ *  same spelling in one table are the same entry, so they compare by
+ *  pointer, and each has an id that is unique within the table.
+ */
+class Identifier {
+  public:
+    Identifier() = default;
+    explicit Identifier(const llvm::StringMapEntry<uint32_t>* e) : entry(e) {}
+
+    llvm::StringRef text() const { return entry->getKey(); }
+    uint32_t id() const { return entry->getValue(); }
+    bool operator==(Identifier other) const { return entry == other.entry; }
+    bool operator!=(Identifier other) const { return entry != other.entry; }
+
+  private:
+    const llvm::StringMapEntry<uint32_t>* entry = nullptr;
+};
+
+/**
+ * @brief The identifiers of one compile. Not thread-safe; the trees that
+ *  share a table are lowered one after the other.
+ */
+class NameTable {
+  public:
+    Identifier intern(llvm::StringRef name) {
+      auto entry = names.try_emplace(name, names.size()).first;
+      return Identifier(&*entry);
+    }
+
+    uint32_t size() const { return names.size(); }
+    size_t bytesAllocated() const { return names.getAllocator().getTotalMemory(); }
+
+  private:
+    llvm::StringMap<uint32_t, llvm::BumpPtrAllocator> names;
+};
+
+}
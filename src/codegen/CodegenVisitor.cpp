@@ -11,8 +11,8 @@
  * 
  */
 #include "CodegenVisitor.h"
-#include <any>
 #include <string>
+#include "llvm/Support/TimeProfiler.h"
 
 // #define _TRACE_
 
@@ -29,38 +29,116 @@ void trace(std::string message, Value *v = nullptr) {
 #endif // _TRACE_
 }
 
-std::any CodegenVisitor::visitCompilationUnit(WPLParser::CompilationUnitContext *ctx) {
+Value* CodegenVisitor::visitCompilationUnit(ast::CompilationUnit *ctx) {
+  beginModule();
+
+  // Generate code for all expressions
+  for (auto e : ctx->components) {
+    if (errors.full()) {
+      break;
+    }
+    visitComponent(e);
+  }
+
+  return nullptr;
+}
+
+void CodegenVisitor::beginModule() {
   // External functions
   auto printf_prototype = FunctionType::get(i8p, true);
-  auto printf_fn = Function::Create(printf_prototype, Function::ExternalLinkage, "printf", module);
+  Function::Create(printf_prototype, Function::ExternalLinkage, "printf", module);
+}
 
-  FunctionCallee printExpr(printf_prototype, printf_fn);
+/**
+ * @brief The function a call refers to. The module is searched by name
+ *  the first time an identifier is called and the result is kept by the
+ *  identifier's id, so later calls skip the string lookup.
+ */
+Function* CodegenVisitor::lookupFunction(ast::Identifier id) {
+  auto cached = functions.find(id.id());
+  if (cached != functions.end()) {
+    return cached->second;
+  }
+  Function* func = module->getFunction(id.text());
+  if (func != nullptr) {
+    functions[id.id()] = func;
+  }
+  return func;
+}
 
-  // Generate code for all expressions
-  for (auto e : ctx->components) {
-    if (e->varDeclaration() && e->varDeclaration()->scalarDeclaration())
+/**
+ * @brief Generate the code of one top-level component. Globals are
+ *  looked up by name, so nothing refers back to the component's AST
+ *  once this returns.
+ */
+void CodegenVisitor::visitComponent(ast::Node *e) {
+  if (ast::ScalarDeclaration* sdctx = dyn_cast<ast::ScalarDeclaration>(e))
+  {
+    Type* t = llvmTypeFromWPLType(sdctx->t);
+    for (ast::Scalar* sctx : sdctx->scalars)
     {
-      WPLParser::ScalarDeclarationContext* sdctx = e->varDeclaration()->scalarDeclaration();
-      Type* t = llvmTypeFromWPLType(sdctx->t);
-      for (WPLParser::ScalarContext* sctx : sdctx->scalars)
-      {
-        module->getOrInsertGlobal(sctx->id->getText(), t);
-      }
+      module->getOrInsertGlobal(sctx->id.text(), t);
     }
-    else
+  }
+  else if (calls && isa<ast::Routine>(e) && !calls->isReachable(cast<ast::Routine>(e)->id))
+  {
+    if (keepUnusedDeclarations)
     {
-      e->accept(this);
+      declareComponent(e);
     }
   }
+  else if (reusedComponents.count(e))
+  {
+    declareComponent(e);
+  }
+  else
+  {
+    visit(e);
+  }
+}
 
-  return nullptr;
+void CodegenVisitor::removeUnused(const CallGraph *graph, bool keepUnused)
+{
+  // Only unreachable functions call unreachable functions, so once they
+  // have no bodies nothing refers to them
+  std::vector<Function*> unused;
+  for (ast::Identifier id : graph->getRoutines())
+  {
+    Function* f = module->getFunction(id.text());
+    if (f && !graph->isReachable(id))
+    {
+      f->deleteBody();
+      unused.push_back(f);
+    }
+  }
+  if (!keepUnused)
+  {
+    for (Function* f : unused)
+    {
+      f->eraseFromParent();
+    }
+  }
+  // And so are the string constants only they used
+  std::vector<GlobalVariable*> strings;
+  for (GlobalVariable &gv : module->globals())
+  {
+    gv.removeDeadConstantUsers();
+    if (gv.hasPrivateLinkage() && gv.use_empty())
+    {
+      strings.push_back(&gv);
+    }
+  }
+  for (GlobalVariable* gv : strings)
+  {
+    gv->eraseFromParent();
+  }
 }
 
-Type* CodegenVisitor::llvmTypeFromWPLType(WPLParser::TypeContext* tctx)
+Type* CodegenVisitor::llvmTypeFromWPLType(ast::TypeName t)
 {
-      if (tctx->BOOL()) return Int1Ty;
-      if (tctx->INT()) return Int32Ty;
-      if (tctx->STR()) return i8p;
+      if (t == ast::TypeName::BOOL) return Int1Ty;
+      if (t == ast::TypeName::INT) return Int32Ty;
+      if (t == ast::TypeName::STR) return i8p;
       return VoidTy;
 }
 
@@ -72,11 +150,42 @@ Type* CodegenVisitor::llvmTypeFromSymType(SymType t)
       return VoidTy;
 }
 
-std::any CodegenVisitor::visitFunction(WPLParser::FunctionContext *ctx) {
+Function* CodegenVisitor::declareFunction(std::string name, Type* returntype, ArrayRef<ast::Param*> p)
+{
+  std::vector<Type*> argtypes;
+  for (ast::Param* param : p)
+  {
+    argtypes.push_back(llvmTypeFromWPLType(param->t));
+  }
+
+  FunctionType *funcType = FunctionType::get(returntype, argtypes, false);
+  return Function::Create(funcType, GlobalValue::ExternalLinkage, name, module);
+}
+
+void CodegenVisitor::declareComponent(ast::Node *ctx)
+{
+  if (ctx->kind == ast::Kind::Procedure)
+  {
+    ast::Routine* ph = cast<ast::Routine>(ctx);
+    declareFunction(ph->id.text().str(), VoidTy, ph->params);
+  }
+  else if (ctx->kind == ast::Kind::Function)
+  {
+    ast::Routine* fh = cast<ast::Routine>(ctx);
+    declareFunction(fh->id.text().str(), llvmTypeFromWPLType(fh->t), fh->params);
+  }
+  else
+  {
+    visit(ctx);
+  }
+}
+
+Value* CodegenVisitor::visitFunction(ast::Routine *ctx) {
   Value *v;
   Function* func;
 
-  std::string funcName = ctx->fh->id->getText();
+  std::string funcName = ctx->id.text().str();
+  TimeTraceScope timeScope("Codegen function", funcName);
   // if (funcName == "programNAH") //TODO: semantic check that this function exists
   // {
   //   FunctionType *mainFuncType = FunctionType::get(Int32Ty, {Int32Ty, Int8PtrPtrTy}, false);
@@ -85,18 +194,7 @@ std::any CodegenVisitor::visitFunction(WPLParser::FunctionContext *ctx) {
   // }
   // else
   // {
-  Type* returntype = llvmTypeFromWPLType(ctx->fh->t);
-  std::vector<Type*> argtypes;
-  if (ctx->fh->p)
-  {
-    for (WPLParser::TypeContext* tctx : ctx->fh->p->types)
-    {
-      argtypes.push_back(llvmTypeFromWPLType(tctx));
-    }
-  }
-
-  FunctionType *funcType = FunctionType::get(returntype, argtypes, false);
-  func = Function::Create(funcType, GlobalValue::ExternalLinkage, funcName, module);
+  func = declareFunction(funcName, llvmTypeFromWPLType(ctx->t), ctx->params);
   // }
 
   BasicBlock *bBlock = BasicBlock::Create(module->getContext(), "entry", func);
@@ -104,102 +202,76 @@ std::any CodegenVisitor::visitFunction(WPLParser::FunctionContext *ctx) {
   builder->SetInsertPoint(bBlock);
 
   // attach arg values to arg symbols
-  if (ctx->fh->p)
+  Function::arg_iterator argiterator = func->arg_begin();
+  for (ast::Param* param : ctx->params)
   {
-    Function::arg_iterator argiterator = func->arg_begin();
-    for (unsigned long i = 0; i < ctx->fh->p->ids.size(); i++)
+    Symbol* symbol = props->getBinding(param);
+    if (symbol == nullptr)
     {
-      std::string id = ctx->fh->p->ids[i]->getText();
-      Symbol* symbol = props->getBinding(ctx->fh->p->ids[i]);
-      if (symbol == nullptr)
-      {
-        errors.addCodegenError(ctx->getStart(), "No symbol created for " + id);
-        return v;
-      }
-
-      Type* type = llvmTypeFromSymType(symbol->type);
-      Value* alloc = builder->CreateAlloca(type, 0, symbol->identifier);
-      symbol->val = alloc;
-      builder->CreateStore(argiterator++, symbol->val); 
+      addError(ctx, ErrCode::NO_SYMBOL, param->id);
+      return v;
     }
+
+    Type* type = llvmTypeFromSymType(symbol->type);
+    Value* alloc = builder->CreateAlloca(type, 0, symbol->identifier.text());
+    symbol->val = alloc;
+    builder->CreateStore(argiterator++, symbol->val); 
   }
 
-  ctx->b->accept(this);
+  visit(ctx->b);
 
   return v;
 }
 
-std::any CodegenVisitor::visitProcedure(WPLParser::ProcedureContext *ctx) {
+Value* CodegenVisitor::visitProcedure(ast::Routine *ctx) {
   Value *v;
 
-  std::string procName = ctx->ph->id->getText();
-  std::vector<Type*> argtypes;
-  if (ctx->ph->p)
-  {
-    for (WPLParser::TypeContext* tctx : ctx->ph->p->types)
-    {
-      argtypes.push_back(llvmTypeFromWPLType(tctx));
-    }
-  }
-
-  FunctionType *procType = FunctionType::get(VoidTy, argtypes, false);
-  Function *proc = Function::Create(procType, GlobalValue::ExternalLinkage, procName, module);
+  std::string procName = ctx->id.text().str();
+  TimeTraceScope timeScope("Codegen procedure", procName);
+  Function *proc = declareFunction(procName, VoidTy, ctx->params);
 
   BasicBlock *bBlock = BasicBlock::Create(module->getContext(), "entry", proc);
 
   builder->SetInsertPoint(bBlock);
 
   // attach arg values to arg symbols
-  if (ctx->ph->p)
+  Function::arg_iterator argiterator = proc->arg_begin();
+  for (ast::Param* param : ctx->params)
   {
-    Function::arg_iterator argiterator = proc->arg_begin();
-    for (unsigned long i = 0; i < ctx->ph->p->ids.size(); i++)
+    Symbol* symbol = props->getBinding(param);
+    if (symbol == nullptr)
     {
-      std::string id = ctx->ph->p->ids[i]->getText();
-      Symbol* symbol = props->getBinding(ctx->ph->p->ids[i]);
-      if (symbol == nullptr)
-      {
-        errors.addCodegenError(ctx->getStart(), "No symbol created for " + id);
-        return v;
-      }
-
-      Type* type = llvmTypeFromSymType(symbol->type);
-      Value* alloc = builder->CreateAlloca(type, 0, symbol->identifier);
-      symbol->val = alloc;
-      builder->CreateStore(argiterator++, symbol->val); 
+      addError(ctx, ErrCode::NO_SYMBOL, param->id);
+      return v;
     }
+
+    Type* type = llvmTypeFromSymType(symbol->type);
+    Value* alloc = builder->CreateAlloca(type, 0, symbol->identifier.text());
+    symbol->val = alloc;
+    builder->CreateStore(argiterator++, symbol->val); 
   }
 
-  ctx->b->accept(this);
+  visit(ctx->b);
 
   builder->CreateRet((Value*)nullptr);
 
   return v;
 }
 
-std::any CodegenVisitor::visitExternDeclaration(WPLParser::ExternDeclarationContext *ctx) { 
+Value* CodegenVisitor::visitExternDeclaration(ast::ExternDeclaration *ctx) { 
   Value* v = Int32Zero;
-  std::string procName;
-  std::vector<WPLParser::TypeContext*> parserargtypes;
+  std::string procName = ctx->id.text().str();
   std::vector<Type*> llvmargtypes;
-  Type* returntype;
+  Type* returntype = VoidTy;
 
-  if (ctx->externProcHeader())
-  {
-    if (ctx->externProcHeader()->params()) parserargtypes = ctx->externProcHeader()->params()->types;
-    procName = ctx->externProcHeader()->id->getText();
-    returntype = VoidTy;
-  }
-  else if (ctx->externFuncHeader())
+  if (ctx->kind == ast::Kind::ExternFunction)
   {
-    if (ctx->externFuncHeader()->params()) parserargtypes = ctx->externFuncHeader()->params()->types;
-    procName = ctx->externFuncHeader()->id->getText();
-    returntype = llvmTypeFromWPLType(ctx->externFuncHeader()->t);
+    returntype = llvmTypeFromWPLType(ctx->t);
   }
 
-  for (WPLParser::TypeContext* tctx : parserargtypes)
+  for (ast::Param* param : ctx->params)
   {
-    llvmargtypes.push_back(llvmTypeFromWPLType(tctx));
+    llvmargtypes.push_back(llvmTypeFromWPLType(param->t));
   }
 
   auto exproc_prototype = FunctionType::get(returntype, llvmargtypes, false);
@@ -209,16 +281,16 @@ std::any CodegenVisitor::visitExternDeclaration(WPLParser::ExternDeclarationCont
   return v;
 }
 
-std::any CodegenVisitor::visitScalarDeclaration(WPLParser::ScalarDeclarationContext *ctx) {
-  for (WPLParser::ScalarContext* sctx : ctx->scalars)
+Value* CodegenVisitor::visitScalarDeclaration(ast::ScalarDeclaration *ctx) {
+  for (ast::Scalar* sctx : ctx->scalars)
   {
     Symbol* symbol = props->getBinding(sctx);
     Type* type = llvmTypeFromSymType(symbol->type);
-    Value* alloc = builder->CreateAlloca(type, 0, symbol->identifier);
+    Value* alloc = builder->CreateAlloca(type, 0, symbol->identifier.text());
     symbol->val = alloc;
     if (sctx->vi)
     {
-      Value* v = std::any_cast<Value *>(sctx->vi->c->accept(this));
+      Value* v = visit(sctx->vi);
       builder->CreateStore(v, symbol->val); 
       symbol->defined = true;
     }
@@ -226,96 +298,93 @@ std::any CodegenVisitor::visitScalarDeclaration(WPLParser::ScalarDeclarationCont
   return (Value*) Int32Zero;
 }
 
-std::any CodegenVisitor::visitAssignment(WPLParser::AssignmentContext *ctx) {
+Value* CodegenVisitor::visitAssignment(ast::Assignment *ctx) {
   Value* v = Int32Zero;
   for (unsigned long i = 0; i < ctx->exprs.size(); i++)
   {
     Symbol* symbol = props->getBinding(ctx);
-    Value* v = std::any_cast<Value *>(ctx->exprs[i]->accept(this));
+    Value* v = visit(ctx->exprs[i]);
     builder->CreateStore(v, symbol->val);
     symbol->defined = true;
   }
   return v;
 }
 
-std::any CodegenVisitor::visitIDExpr(WPLParser::IDExprContext *ctx) {
+Value* CodegenVisitor::visitIDExpr(ast::IDExpr *ctx) {
   Value* v = Int32Zero;
   Symbol* symbol = props->getBinding(ctx); 
   if (!symbol)
   {
-    errors.addCodegenError(ctx->getStart(), "Cannot find associated symbol for \"" + ctx->getText() + "\"");
+    addError(ctx, ErrCode::NO_BINDING, ctx->id);
     return v;
   }
-  Type* type = llvmTypeFromSymType(symbol->type);
+  // A variable declared without a type gets one from its first
+  // assignment, which may come after this use
+  SymType t = props->getType(ctx);
+  Type* type = llvmTypeFromSymType(t != SymType::UNDEFINED ? t : symbol->type);
   if (!symbol->defined)
   {
-    errors.addCodegenError(ctx->getStart(), "Symbol " + symbol->identifier + " has not been defined.");
+    addError(ctx, ErrCode::NOT_DEFINED, symbol->identifier);
     return v;
   }
   if (!symbol->val)
   {
-    errors.addCodegenError(ctx->getStart(), "No llvm value for symbol " + symbol->identifier);
+    addError(ctx, ErrCode::NO_VALUE, symbol->identifier);
     return v;
   }
-  v = builder->CreateLoad(type, symbol->val, symbol->identifier);
+  v = builder->CreateLoad(type, symbol->val, symbol->identifier.text());
   return v;
 }
 
-// std::any CodegenVisitor::visitArrayDeclaration(WPLParser::ArrayDeclarationContext *ctx) {
-//   return SymType::UNDEFINED;
-// }
-
-std::any CodegenVisitor::visitCall(WPLParser::CallContext *ctx) {
+Value* CodegenVisitor::visitCall(ast::Call *ctx) {
   Value* v = Int32Zero;
-  std::string id = ctx->id->getText();
-
-  Function* called_func = module->getFunction(id);
+  Function* called_func = lookupFunction(ctx->id);
   if (!called_func)
   {
-    errors.addCodegenError(ctx->getStart(), "No definition found for function " + id);
+    addError(ctx, ErrCode::NO_FUNCTION, ctx->id);
     return v;
   }
 
   std::vector<Value *> args;
-  if (ctx->arguments())
+  for (ast::Expr* arg : ctx->args)
   {
-    for (WPLParser::ArgContext* arg : ctx->arguments()->args)
-    {
-      std::any v = arg->accept(this);
-      args.push_back(std::any_cast<Value *>(v));
-    }
+    args.push_back(visit(arg));
   }
 
   v = builder->CreateCall(called_func, args);
   return v;
 }
 
-std::any CodegenVisitor::visitFuncProcCallExpr(WPLParser::FuncProcCallExprContext *ctx) {
-  Value* v = Int32Zero;
-  std::string id = ctx->fpname->getText();
-
-  Function* called_func = module->getFunction(id);
-  if (!called_func)
+// No code is generated for the arguments of a call to an unknown
+// function or for arrays
+bool CodegenVisitor::enterExpr(ast::Expr *ctx, Value *&result) {
+  if (ast::CallExpr* call = dyn_cast<ast::CallExpr>(ctx))
   {
-    errors.addCodegenError(ctx->getStart(), "No definition found for function " + id);
-    return v;
+    if (!lookupFunction(call->id))
+    {
+      addError(ctx, ErrCode::NO_FUNCTION, call->id);
+      result = Int32Zero;
+      return false;
+    }
   }
-
-  std::vector<Value *> args;
-  for (WPLParser::ExprContext* arg : ctx->args)
+  else if (isa<ast::SubscriptExpr>(ctx))
   {
-    args.push_back(std::any_cast<Value *>(arg->accept(this)));
+    addError(ctx, ErrCode::ARRAYS_NOT_SUPPORTED, ast::Identifier(), ctx);
+    result = Int32Zero;
+    return false;
   }
+  return true;
+}
 
-  v = builder->CreateCall(called_func, args);
-  return v;
+Value* CodegenVisitor::visitFuncProcCallExpr(ast::CallExpr *ctx, ArrayRef<Value*> args) {
+  return builder->CreateCall(lookupFunction(ctx->id), args);
 }
 
-std::any CodegenVisitor::visitReturn(WPLParser::ReturnContext *ctx) {
+Value* CodegenVisitor::visitReturn(ast::Return *ctx) {
   Value* v = Int32Zero;
-  if (ctx->expr())
+  if (ctx->e)
   {
-    v = std::any_cast<Value *>(ctx->expr()->accept(this)); 
+    v = visit(ctx->e); 
   }
   else 
   {
@@ -324,11 +393,23 @@ std::any CodegenVisitor::visitReturn(WPLParser::ReturnContext *ctx) {
   return builder->CreateRet(v);
 }
 
-std::any CodegenVisitor::visitConstant(WPLParser::ConstantContext *ctx) {
+Value* CodegenVisitor::visitConstant(ast::Constant *ctx) {
   Value* v = Int32Zero;
-  if (ctx->BOOLEAN())
+  int32_t value;
+  if (ctx->constantKind != ast::ConstantKind::STRING && props->getConstant(ctx, value))
   {
-    if (ctx->getText() == "true")
+    if (ctx->constantKind == ast::ConstantKind::BOOLEAN)
+    {
+      v = builder->getInt1(value);
+    }
+    else
+    {
+      v = builder->getInt32(value);
+    }
+  }
+  else if (ctx->constantKind == ast::ConstantKind::BOOLEAN)
+  {
+    if (ctx->text == "true")
     {
       v = builder->getInt1(1);
     }
@@ -337,15 +418,15 @@ std::any CodegenVisitor::visitConstant(WPLParser::ConstantContext *ctx) {
       v = builder->getInt1(0);
     }
   }
-  else if (ctx->INTEGER())
+  else if (ctx->constantKind == ast::ConstantKind::INTEGER)
   {
-    int i = stoi(ctx->getText());
+    int i = stoi(ctx->text.str());
     v = builder->getInt32(i);
   }
-  else if (ctx->STRING())
+  else if (ctx->constantKind == ast::ConstantKind::STRING)
   {
-    std::string s = ctx->getText();
-    // remove quotations added by getText()
+    std::string s = ctx->text.str();
+    // remove the quotations
     s.erase(s.length()-1, 1);
     s.erase(0, 1);
     
@@ -364,11 +445,9 @@ std::any CodegenVisitor::visitConstant(WPLParser::ConstantContext *ctx) {
   return v;
 }
 
-std::any CodegenVisitor::visitEqExpr(WPLParser::EqExprContext *ctx) {
-  Value *lVal = std::any_cast<Value *>(ctx->left->accept(this));
-  Value *rVal = std::any_cast<Value *>(ctx->right->accept(this));
+Value* CodegenVisitor::visitEqExpr(ast::BinaryExpr *ctx, Value *lVal, Value *rVal) {
   Value *v;
-  if (ctx->EQUAL()) {
+  if (ctx->op == ast::Operator::EQUAL) {
     v = builder->CreateICmpEQ(lVal, rVal);
   } else {
     v = builder->CreateICmpNE(lVal, rVal);
@@ -376,86 +455,74 @@ std::any CodegenVisitor::visitEqExpr(WPLParser::EqExprContext *ctx) {
   return v;
 }
 
-std::any CodegenVisitor::visitRelExpr(WPLParser::RelExprContext *ctx) {
-  Value *lVal = std::any_cast<Value *>(ctx->left->accept(this));
-  Value *rVal = std::any_cast<Value *>(ctx->right->accept(this));
+Value* CodegenVisitor::visitRelExpr(ast::BinaryExpr *ctx, Value *lVal, Value *rVal) {
   Value *v;
-  if (ctx->LESS())
+  if (ctx->op == ast::Operator::LESS)
   {
     v = builder->CreateICmpSLT(lVal, rVal);
   }
-  else if (ctx->LEQ())
+  else if (ctx->op == ast::Operator::LEQ)
   {
     v = builder->CreateICmpSLE(lVal, rVal);
   }
-  else if (ctx->GTR())
+  else if (ctx->op == ast::Operator::GTR)
   {
     v = builder->CreateICmpSGT(lVal, rVal);
   }
-  else if (ctx->GEQ())
+  else if (ctx->op == ast::Operator::GEQ)
   {
     v = builder->CreateICmpSGE(lVal, rVal);
   }
   return v;
 }
 
-std::any CodegenVisitor::visitAndExpr(WPLParser::AndExprContext *ctx) {
-  Value *lVal = std::any_cast<Value *>(ctx->left->accept(this));
-  Value *rVal = std::any_cast<Value *>(ctx->right->accept(this));
+Value* CodegenVisitor::visitAndExpr(ast::BinaryExpr *ctx, Value *lVal, Value *rVal) {
   Value *v = builder->CreateAnd(lVal, rVal);
   return v;
 }
 
-std::any CodegenVisitor::visitOrExpr(WPLParser::OrExprContext *ctx) {
-  Value *lVal = std::any_cast<Value *>(ctx->left->accept(this));
-  Value *rVal = std::any_cast<Value *>(ctx->right->accept(this));
+Value* CodegenVisitor::visitOrExpr(ast::BinaryExpr *ctx, Value *lVal, Value *rVal) {
   Value *v = builder->CreateOr(lVal, rVal);
   return v;
 }
 
-std::any CodegenVisitor::visitNotExpr(WPLParser::NotExprContext *ctx) {
-  Value *e = std::any_cast<Value *>(ctx->e->accept(this));
+Value* CodegenVisitor::visitNotExpr(ast::UnaryExpr *ctx, Value *e) {
   Value *v = builder->CreateNot(e);
   return v;
 }
 
-std::any CodegenVisitor::visitMultExpr(WPLParser::MultExprContext *ctx) {
-  Value *lVal = std::any_cast<Value *>(ctx->left->accept(this));
-  Value *rVal = std::any_cast<Value *>(ctx->right->accept(this));
+Value* CodegenVisitor::visitMultExpr(ast::BinaryExpr *ctx, Value *lVal, Value *rVal) {
   Value *v;
-  if (ctx->MUL())
+  if (ctx->op == ast::Operator::MUL)
   {
     v = builder->CreateNSWMul(lVal, rVal);
   }
-  if (ctx->DIV())
+  if (ctx->op == ast::Operator::DIV)
   {
     v = builder->CreateSDiv(lVal, rVal);
   }
   return v;
 }
 
-std::any CodegenVisitor::visitAddExpr(WPLParser::AddExprContext *ctx) {
-  Value *lVal = std::any_cast<Value *>(ctx->left->accept(this));
-  Value *rVal = std::any_cast<Value *>(ctx->right->accept(this));
+Value* CodegenVisitor::visitAddExpr(ast::BinaryExpr *ctx, Value *lVal, Value *rVal) {
   Value *v;
-  if (ctx->PLUS())
+  if (ctx->op == ast::Operator::PLUS)
   {
     v = builder->CreateNSWAdd(lVal, rVal);
   }
-  if (ctx->MINUS())
+  if (ctx->op == ast::Operator::MINUS)
   {
     v = builder->CreateNSWSub(lVal, rVal);
   }
   return v;
 }
 
-std::any CodegenVisitor::visitUMinusExpr(WPLParser::UMinusExprContext *ctx) {
-  Value *e = std::any_cast<Value *>(ctx->e->accept(this));
+Value* CodegenVisitor::visitUMinusExpr(ast::UnaryExpr *ctx, Value *e) {
   Value *v = builder->CreateNSWSub(Int32Zero, e);
   return v;
 }
 
-std::any CodegenVisitor::visitConditional(WPLParser::ConditionalContext *ctx) {
+Value* CodegenVisitor::visitConditional(ast::Conditional *ctx) {
   Value* v = Int32Zero;
   
   Function* func = builder->GetInsertBlock()->getParent(); 
@@ -471,7 +538,7 @@ std::any CodegenVisitor::visitConditional(WPLParser::ConditionalContext *ctx) {
 
   // continue block
   BasicBlock *continueblock = BasicBlock::Create(module->getContext(), "bContinue", func);
-  Value* eresult = std::any_cast<Value*>(ctx->e->accept(this));
+  Value* eresult = visit(ctx->e);
   if (falseblock == nullptr)
   {
     builder->CreateCondBr(eresult, trueblock, continueblock);
@@ -483,7 +550,7 @@ std::any CodegenVisitor::visitConditional(WPLParser::ConditionalContext *ctx) {
 
   // true block code
   builder->SetInsertPoint(trueblock);
-  Value *yesblocresult = std::any_cast<Value*>(ctx->yesblock->accept(this));
+  Value *yesblocresult = visit(ctx->yesblock);
   if (yesblocresult != Int32One) // no return
   {
     builder->CreateBr(continueblock); // go to the continuation
@@ -493,7 +560,7 @@ std::any CodegenVisitor::visitConditional(WPLParser::ConditionalContext *ctx) {
   if (ctx->noblock)
   {
     builder->SetInsertPoint(falseblock);
-    Value *noblocresult = std::any_cast<Value*>(ctx->noblock->accept(this));
+    Value *noblocresult = visit(ctx->noblock);
     if (noblocresult != Int32One) // no return
     {
       builder->CreateBr(continueblock); // go to the continuation
@@ -505,7 +572,7 @@ std::any CodegenVisitor::visitConditional(WPLParser::ConditionalContext *ctx) {
   return v;
 }
 
-std::any CodegenVisitor::visitSelect(WPLParser::SelectContext *ctx) {
+Value* CodegenVisitor::visitSelect(ast::Select *ctx) {
   Value* v = Int32Zero;
 
   Function* func = builder->GetInsertBlock()->getParent(); 
@@ -513,12 +580,12 @@ std::any CodegenVisitor::visitSelect(WPLParser::SelectContext *ctx) {
   std::vector<BasicBlock*> yesblocs;
   std::vector<BasicBlock*> condblocs;
 
-  for (unsigned long i = 0; i < ctx->selectAlt().size(); i++)
+  for (unsigned long i = 0; i < ctx->alts.size(); i++)
   {
-    WPLParser::SelectAltContext* alt = ctx->selectAlt()[i];
+    ast::SelectAlt* alt = ctx->alts[i];
     yesblocs.push_back(BasicBlock::Create(module->getContext(), "selectbloc", func));
     condblocs.push_back(BasicBlock::Create(module->getContext(), "condbloc", func));
-    Value* eresult = std::any_cast<Value*>(alt->e->accept(this));
+    Value* eresult = visit(alt->e);
 
     builder->CreateCondBr(eresult, yesblocs[i], condblocs[i]);
     builder->SetInsertPoint(condblocs[i]);
@@ -528,11 +595,11 @@ std::any CodegenVisitor::visitSelect(WPLParser::SelectContext *ctx) {
   BasicBlock *continueblock = BasicBlock::Create(module->getContext(), "continue", func);
   builder->CreateBr(continueblock); // last false case, go to continue block
 
-  for (unsigned long i = 0; i < ctx->selectAlt().size(); i++)
+  for (unsigned long i = 0; i < ctx->alts.size(); i++)
   {
-    WPLParser::SelectAltContext* alt = ctx->selectAlt()[i];
+    ast::SelectAlt* alt = ctx->alts[i];
     builder->SetInsertPoint(yesblocs[i]);
-    Value* blocresult = std::any_cast<Value*>(alt->s->accept(this));
+    Value* blocresult = visitStatement(alt->s);
     if (blocresult != Int32One) // no return statement
     {
       builder->CreateBr(continueblock);
@@ -544,7 +611,7 @@ std::any CodegenVisitor::visitSelect(WPLParser::SelectContext *ctx) {
   return v;
 }
 
-std::any CodegenVisitor::visitLoop(WPLParser::LoopContext *ctx) {
+Value* CodegenVisitor::visitLoop(ast::Loop *ctx) {
   Value* v = Int32Zero;
 
   Function* func = builder->GetInsertBlock()->getParent(); 
@@ -555,12 +622,12 @@ std::any CodegenVisitor::visitLoop(WPLParser::LoopContext *ctx) {
 
   builder->CreateBr(condblock);
   builder->SetInsertPoint(condblock);
-  Value* eresult = std::any_cast<Value*>(ctx->e->accept(this));
+  Value* eresult = visit(ctx->e);
   builder->CreateCondBr(eresult, loopblock, continueblock);
 
   // loop block code
   builder->SetInsertPoint(loopblock);
-  Value *loopblocresult = std::any_cast<Value*>(ctx->b->accept(this));
+  Value *loopblocresult = visit(ctx->b);
   if (loopblocresult != Int32One) // no return in bloc
   {
     builder->CreateBr(condblock);   // go back to the condition
@@ -570,71 +637,47 @@ std::any CodegenVisitor::visitLoop(WPLParser::LoopContext *ctx) {
   return v;
 }
 
-// std::any CodegenVisitor::visitSubscriptExpr(WPLParser::SubscriptExprContext *ctx) {
-//   return SymType::UNDEFINED;
-// }
-
-// std::any CodegenVisitor::visitArrayLengthExpr(WPLParser::ArrayLengthExprContext *ctx) {
-//   return SymType::UNDEFINED;
-// }
+Value* CodegenVisitor::visitArrayDeclaration(ast::ArrayDeclaration *ctx) {
+  return (Value*) Int32Zero;
+}
 
-// std::any CodegenVisitor::visitArrayIndex(WPLParser::ArrayIndexContext *ctx) {
-//   return SymType::UNDEFINED;
-// }
+Value* CodegenVisitor::visitArrayAssignment(ast::ArrayAssignment *ctx) {
+  return (Value*) Int32Zero;
+}
 
-std::any CodegenVisitor::visitParenExpr(WPLParser::ParenExprContext *ctx) {
-  return std::any_cast<Value *>(ctx->expr()->accept(this));
+Value* CodegenVisitor::visitArrayLengthExpr(ast::ArrayLengthExpr *ctx) {
+  addError(ctx, ErrCode::ARRAYS_NOT_SUPPORTED, ast::Identifier(), ctx);
+  return (Value*) Int32Zero;
 }
 
-std::any CodegenVisitor::visitBlock(WPLParser::BlockContext *ctx) {
+Value* CodegenVisitor::visitBlock(ast::Block *ctx) {
   Value* v = Int32Zero;
-  for (WPLParser::StatementContext* sctx : ctx->statement())
+  for (ast::Node* sctx : ctx->statements)
   {
-    if (sctx->return_())
+    if (sctx->kind == ast::Kind::Return)
     {
       v = Int32One;
     }
-    sctx->accept(this);
+    visitStatement(sctx);
   }
   return v;
 }
 
-std::any CodegenVisitor::visitStatement(WPLParser::StatementContext *ctx) {
+Value* CodegenVisitor::visitStatement(ast::Node *ctx) {
   Value* v = Int32Zero;
-  if (ctx->assignment())
-  {
-    ctx->assignment()->accept(this);
-  }
-  else if (ctx->loop())
-  {
-    ctx->loop()->accept(this);
-  }
-  else if (ctx->select())
-  {
-    ctx->select()->accept(this);
-  }
-  else if (ctx->conditional())
-  {
-    ctx->conditional()->accept(this);
-  }
-  else if (ctx->call())
-  {
-    ctx->call()->accept(this);
-  }
-  else if (ctx->block())
+  if (ctx->kind == ast::Kind::Block)
   {
-    v = std::any_cast<Value*>(ctx->block()->accept(this));
+    v = visit(ctx);
   }
-  else if (ctx->return_())
+  else if (ctx->kind == ast::Kind::Return)
   {
-    ctx->return_()->accept(this);
+    visit(ctx);
     v = Int32One; // this is bad but it is part of how the compiler knows a statement has returned
                   // so that it removes redundant branching to get rid of expected instruction number llvm errors
   }
-  else if (ctx->varDeclaration())
+  else
   {
-    ctx->varDeclaration()->accept(this);
+    visit(ctx);
   }
   return v;
-}
-
+}
\ No newline at end of file
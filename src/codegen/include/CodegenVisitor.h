@@ -6,21 +6,22 @@
  * @date 2022-08-06
  */
 #pragma once
-#include "antlr4-runtime.h"
-#include "WPLBaseVisitor.h"
+#include "ASTVisitor.h"
 // #include "STManager.h"
 #include "PropertyManager.h"
 #include "WPLErrorHandler.h"
 #include "SemanticVisitor.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/IR/NoFolder.h"
+#include <set>
 
 using namespace llvm;
-class CodegenVisitor : WPLBaseVisitor
+class CodegenVisitor : public ASTVisitor<CodegenVisitor, Value*>
 {
 public:
   // Pass in the appropriate elements
@@ -44,57 +45,104 @@ public:
     ReturningBlockIndicator = Type::getPPC_FP128Ty(module->getContext());
   }
 
-  // Code generation functions
-  std::any visitCompilationUnit(WPLParser::CompilationUnitContext *ctx) override;
-
-  std::any visitFunction(WPLParser::FunctionContext *ctx) override;
-  std::any visitProcedure(WPLParser::ProcedureContext *ctx) override;
-  std::any visitFuncProcCallExpr(WPLParser::FuncProcCallExprContext *ctx) override;
-  std::any visitCall(WPLParser::CallContext *ctx) override;
-  std::any visitReturn(WPLParser::ReturnContext *ctx) override;
-
-  std::any visitScalarDeclaration(WPLParser::ScalarDeclarationContext *ctx) override;
-  std::any visitAssignment(WPLParser::AssignmentContext *ctx) override;
-  std::any visitExternDeclaration(WPLParser::ExternDeclarationContext *ctx) override;
-
-  std::any visitConstant(WPLParser::ConstantContext *ctx) override;
-  std::any visitIDExpr(WPLParser::IDExprContext *ctx) override;
-
-  std::any visitRelExpr(WPLParser::RelExprContext *ctx) override;
-  std::any visitNotExpr(WPLParser::NotExprContext *ctx) override;
-  std::any visitAndExpr(WPLParser::AndExprContext *ctx) override;
-  std::any visitOrExpr(WPLParser::OrExprContext *ctx) override;
-  std::any visitEqExpr(WPLParser::EqExprContext *ctx) override;
-
-  std::any visitUMinusExpr(WPLParser::UMinusExprContext *ctx) override;
-  std::any visitMultExpr(WPLParser::MultExprContext *ctx) override;
-  std::any visitAddExpr(WPLParser::AddExprContext *ctx) override;
-
-  std::any visitConditional(WPLParser::ConditionalContext *ctx) override;
-  std::any visitSelect(WPLParser::SelectContext *ctx) override;
-  std::any visitLoop(WPLParser::LoopContext *ctx) override;
+  // Each visitor owns its LLVMContext, so release it with the module
+  ~CodegenVisitor()
+  {
+    delete builder;
+    delete module;
+    delete context;
+  }
 
-  // std::any visitArrayDeclaration(WPLParser::ArrayDeclarationContext *ctx) override;
-  // std::any visitArrayIndex(WPLParser::ArrayIndexContext *ctx) override;
-  // std::any visitSubscriptExpr(WPLParser::SubscriptExprContext *ctx) override;
-  // std::any visitArrayLengthExpr(WPLParser::ArrayLengthExprContext *ctx) override;
+  // Code generation functions
+  Value* visitCompilationUnit(ast::CompilationUnit *ctx);
+
+  Value* visitFunction(ast::Routine *ctx);
+  Value* visitProcedure(ast::Routine *ctx);
+  Value* visitFuncProcCallExpr(ast::CallExpr *ctx, ArrayRef<Value*> args);
+  Value* visitCall(ast::Call *ctx);
+  Value* visitReturn(ast::Return *ctx);
+
+  Value* visitScalarDeclaration(ast::ScalarDeclaration *ctx);
+  Value* visitAssignment(ast::Assignment *ctx);
+  Value* visitExternDeclaration(ast::ExternDeclaration *ctx);
+
+  // Calls to unknown functions and array elements have no operands visited
+  bool enterExpr(ast::Expr *ctx, Value *&result);
+  Value* visitConstant(ast::Constant *ctx);
+  Value* visitIDExpr(ast::IDExpr *ctx);
+
+  Value* visitRelExpr(ast::BinaryExpr *ctx, Value *lVal, Value *rVal);
+  Value* visitNotExpr(ast::UnaryExpr *ctx, Value *e);
+  Value* visitAndExpr(ast::BinaryExpr *ctx, Value *lVal, Value *rVal);
+  Value* visitOrExpr(ast::BinaryExpr *ctx, Value *lVal, Value *rVal);
+  Value* visitEqExpr(ast::BinaryExpr *ctx, Value *lVal, Value *rVal);
+
+  Value* visitUMinusExpr(ast::UnaryExpr *ctx, Value *e);
+  Value* visitMultExpr(ast::BinaryExpr *ctx, Value *lVal, Value *rVal);
+  Value* visitAddExpr(ast::BinaryExpr *ctx, Value *lVal, Value *rVal);
+
+  Value* visitConditional(ast::Conditional *ctx);
+  Value* visitSelect(ast::Select *ctx);
+  Value* visitLoop(ast::Loop *ctx);
+
+  // Arrays are parsed but no code is generated for them
+  Value* visitArrayDeclaration(ast::ArrayDeclaration *ctx);
+  Value* visitArrayAssignment(ast::ArrayAssignment *ctx);
+  Value* visitArrayLengthExpr(ast::ArrayLengthExpr *ctx);
+
+  Value* visitBlock(ast::Block *ctx);
+  // Int32One if the statement is a return or a block that returns
+  Value* visitStatement(ast::Node *ctx);
+
+  // A compile that streams the components calls beginModule() once and
+  // then visitComponent() for each one in source order
+  void beginModule();
+  void visitComponent(ast::Node *ctx);
+
+  // Generate no code for the procedures and functions the call graph
+  // does not reach, or only a declaration with keepUnused
+  void setCallGraph(const CallGraph *graph, bool keepUnused) {
+    calls = graph;
+    keepUnusedDeclarations = keepUnused;
+  }
+  // The same for a module whose code was generated before the graph
+  // was complete, as in a streaming compile
+  void removeUnused(const CallGraph *graph, bool keepUnused);
 
-  std::any visitBlock(WPLParser::BlockContext *ctx) override;
-  std::any visitParenExpr(WPLParser::ParenExprContext *ctx) override;
-  std::any visitStatement(WPLParser::StatementContext *ctx) override;
+  // Procedures and functions that only get a declaration; their
+  // definitions are linked in from an earlier compile.
+  void setReusedComponents(std::set<ast::Node*> reused) { reusedComponents = reused; }
+  void declareComponent(ast::Node *ctx);
 
   std::string getErrors() { return errors.errorList(); }
+  // Stop once this many errors are found (0 = never)
+  void setErrorLimit(size_t n) { errors.setLimit(n); }
+  bool errorLimitReached() const { return errors.full(); }
+  // Turn the errors found so far into text before their tree goes
+  void keepErrorText() { errors.keepText(); }
   PropertyManager *getProperties() { return props; }
   bool hasErrors() { return errors.hasErrors(); }
   llvm::Module *getModule() { return module; }
   void modPrint() { module -> print(llvm::outs(), nullptr); }
 
-  Type* llvmTypeFromWPLType(WPLParser::TypeContext* tctx);
+  Type* llvmTypeFromWPLType(ast::TypeName t);
   Type* llvmTypeFromSymType(SymType tctx);
+  Function* declareFunction(std::string name, Type* returntype, llvm::ArrayRef<ast::Param*> p);
+  Function* lookupFunction(ast::Identifier id);
 
 private:
+  void addError(ast::Node *ctx, ErrCode code, ast::Identifier id = ast::Identifier(),
+      const ast::Node *node = nullptr) {
+    errors.addCodegenError(ctx, code, id, node);
+  }
+
   PropertyManager *props;
   WPLErrorHandler errors;
+  std::set<ast::Node*> reusedComponents;
+  const CallGraph *calls = nullptr;
+  bool keepUnusedDeclarations = false;
+  // Called functions by identifier id, filled by lookupFunction()
+  llvm::DenseMap<uint32_t, Function*> functions;
 
   // LLVM items
   LLVMContext *context;
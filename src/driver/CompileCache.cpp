@@ -0,0 +1,190 @@
+/**
+ * @file CompileCache.cpp
+ * @author nllopez
+ * @brief Implementation of the content addressed IR cache.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "CompileCache.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+
+// Set by the build to a hash of the compiler sources (see
+// src/driver/CMakeLists.txt). Without it a cache would keep serving IR
+// generated by an older compiler.
+#ifndef WPLC_COMPILER_STAMP
+#error "WPLC_COMPILER_STAMP must be defined by the build"
+#endif
+
+namespace fs = llvm::sys::fs;
+
+static const char* COMPILER_STAMP = WPLC_COMPILER_STAMP;
+
+/**
+ * @brief The cache key for compiling source with the job's options.
+ *  The output location (-o, -nocode, -p) does not change the IR, so it
+ *  is not part of the key. Options that change the generated IR must
+ *  be added here.
+ */
+std::string CompileCache::key(llvm::StringRef source, const CompileJob& job) {
+  llvm::SHA1 hash;
+  hash.update(COMPILER_STAMP);
+  hash.update(llvm::StringRef("\0", 1));
+  if (job.keepUnused) {
+    hash.update(llvm::StringRef("keep-unused\0", 12));
+  }
+  if (job.optLevel != OptLevel::O0) {
+    hash.update("O" + std::to_string(static_cast<uint32_t>(job.optLevel)));
+    hash.update(llvm::StringRef("\0", 1));
+  }
+  hash.update(source);
+  return llvm::toHex(hash.final(), true);
+}
+
+/**
+ * @brief The environment is the hash of the declarations that come
+ *  before the component, so a changed signature invalidates every
+ *  component that could see it. No job options are part of the key:
+ *  components are cached as generated, before -O and the removal of
+ *  unused functions, which are applied to the whole module afterwards.
+ */
+std::string CompileCache::componentKey(const std::string& environment, const std::string& text) {
+  llvm::SHA1 hash;
+  hash.update(COMPILER_STAMP);
+  hash.update(llvm::StringRef("\0component\0", 11));
+  hash.update(environment);
+  hash.update(llvm::StringRef("\0", 1));
+  hash.update(text);
+  return llvm::toHex(hash.final(), true);
+}
+
+std::string CompileCache::entryPath(const std::string& key) {
+  llvm::SmallString<256> path(cacheDir);
+  llvm::sys::path::append(path, key + ".ll");
+  return std::string(path);
+}
+
+bool CompileCache::lookup(const std::string& key, std::string& ir) {
+  int fd;
+  if (fs::openFileForRead(entryPath(key), fd)) {
+    return false;
+  }
+  auto buffer = llvm::MemoryBuffer::getOpenFile(fs::convertFDToNativeFile(fd), entryPath(key), -1);
+  if (buffer) {
+    ir = (*buffer)->getBuffer().str();
+    fs::setLastAccessAndModificationTime(fd, std::chrono::system_clock::now());
+  }
+  llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+  return static_cast<bool>(buffer);
+}
+
+/**
+ * @brief Add an entry. It is written to a unique temporary file first and
+ *  then renamed, so other processes only ever see complete entries.
+ */
+void CompileCache::store(const std::string& key, const std::string& ir) {
+  if (fs::create_directories(cacheDir)) {
+    return;
+  }
+  int fd;
+  llvm::SmallString<256> tmpPath;
+  if (fs::createUniqueFile(entryPath(key) + ".tmp-%%%%%%%%", fd, tmpPath)) {
+    return;
+  }
+  {
+    llvm::raw_fd_ostream out(fd, /*shouldClose=*/true);
+    out << ir;
+    out.close();
+    if (out.has_error()) {
+      out.clear_error();
+      fs::remove(tmpPath);
+      return;
+    }
+  }
+  if (fs::rename(tmpPath, entryPath(key))) {
+    fs::remove(tmpPath);
+  }
+}
+
+/**
+ * @brief Remove the least recently used entries until the cache is back
+ *  under 90% of its size limit. Entries that another process removed
+ *  first are skipped.
+ */
+void CompileCache::evict() {
+  struct Entry {
+    std::string path;
+    uint64_t size;
+    llvm::sys::TimePoint<> used;
+  };
+  std::vector<Entry> entries;
+  uint64_t total = 0;
+  std::error_code ec;
+  for (fs::directory_iterator it(cacheDir, ec), end; it != end && !ec; it.increment(ec)) {
+    if (llvm::sys::path::extension(it->path()) != ".ll") {
+      continue;
+    }
+    fs::file_status st;
+    if (fs::status(it->path(), st)) {
+      continue;
+    }
+    entries.push_back({it->path(), st.getSize(), st.getLastModificationTime()});
+    total += st.getSize();
+  }
+  if (total <= sizeLimit) {
+    return;
+  }
+  std::sort(entries.begin(), entries.end(),
+    [](const Entry& a, const Entry& b) { return a.used < b.used; });
+  uint64_t target = sizeLimit / 10 * 9;
+  for (Entry& e : entries) {
+    if (total <= target) {
+      break;
+    }
+    fs::remove(e.path);
+    total -= e.size;
+  }
+}
+
+/**
+ * @brief The totals are kept as one "hits misses" line per run. Each line
+ *  is a single small append, so concurrent runs do not lose counts.
+ */
+void CompileCache::recordStats(unsigned hits, unsigned misses) {
+  if (fs::create_directories(cacheDir)) {
+    return;
+  }
+  llvm::SmallString<256> path(cacheDir);
+  llvm::sys::path::append(path, "stats");
+  std::error_code ec;
+  llvm::raw_fd_ostream out(path, ec, fs::OF_Append);
+  if (!ec) {
+    out << (std::to_string(hits) + " " + std::to_string(misses) + "\n");
+  }
+}
+
+bool CompileCache::totalStats(uint64_t& hits, uint64_t& misses) {
+  llvm::SmallString<256> path(cacheDir);
+  llvm::sys::path::append(path, "stats");
+  std::ifstream in(std::string(path.str()));
+  if (!in) {
+    return false;
+  }
+  hits = misses = 0;
+  uint64_t h, m;
+  while (in >> h >> m) {
+    hits += h;
+    misses += m;
+  }
+  return true;
+}
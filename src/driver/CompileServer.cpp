@@ -0,0 +1,339 @@
+/**
+ * @file CompileServer.cpp
+ * @author nllopez
+ * @brief Implementation of the compile server and its client side.
+ *  Requests and responses are sent as length prefixed fields:
+ *    request:  magic, inputFileName, inputString, outputFileName, printOutput, noCode,
+ *              cacheDir, cacheSizeLimit, incremental, lexer, parser, stream,
+ *              parseThreads, semanticThreads, errorLimit, keepUnused, optLevel
+ *    response: inputName, outputFileName, diagnostics, ir, success, cacheHit,
+ *              reusedComponents, componentCount, phases
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "CompileServer.h"
+#include <iostream>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+
+namespace {
+
+const uint32_t PROTOCOL_MAGIC = 0x57504c44;    // "WPLD"
+// A longer string or phase list means a broken or hostile peer, and
+// allocating for it could throw bad_alloc in a pool thread
+const uint32_t MAX_STRING_LENGTH = 256u << 20;
+const uint32_t MAX_PHASES = 1024;
+// How long a connection may stall a read or write before it is dropped
+const time_t IO_TIMEOUT_SECONDS = 30;
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void requestStop(int) {
+  stopRequested = 1;
+}
+
+bool writeAll(int fd, const char* data, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, data, len);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+bool readAll(int fd, char* data, size_t len) {
+  while (len > 0) {
+    ssize_t n = read(fd, data, len);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+bool writeUInt(int fd, uint32_t v) {
+  return writeAll(fd, reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+bool readUInt(int fd, uint32_t& v) {
+  return readAll(fd, reinterpret_cast<char*>(&v), sizeof(v));
+}
+
+bool writeUInt64(int fd, uint64_t v) {
+  return writeAll(fd, reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+bool readUInt64(int fd, uint64_t& v) {
+  return readAll(fd, reinterpret_cast<char*>(&v), sizeof(v));
+}
+
+bool writeDouble(int fd, double d) {
+  uint64_t v;
+  std::memcpy(&v, &d, sizeof(v));
+  return writeUInt64(fd, v);
+}
+
+bool readDouble(int fd, double& d) {
+  uint64_t v;
+  if (!readUInt64(fd, v)) return false;
+  std::memcpy(&d, &v, sizeof(d));
+  return true;
+}
+
+bool writeString(int fd, const std::string& s) {
+  return writeUInt(fd, s.size()) && writeAll(fd, s.data(), s.size());
+}
+
+bool readString(int fd, std::string& s) {
+  uint32_t len;
+  if (!readUInt(fd, len) || len > MAX_STRING_LENGTH) return false;
+  s.resize(len);
+  return readAll(fd, s.data(), len);
+}
+
+bool writeBool(int fd, bool b) {
+  return writeUInt(fd, b ? 1 : 0);
+}
+
+bool readBool(int fd, bool& b) {
+  uint32_t v;
+  if (!readUInt(fd, v)) return false;
+  b = v != 0;
+  return true;
+}
+
+bool makeAddress(const std::string& socketPath, sockaddr_un& addr) {
+  if (socketPath.size() >= sizeof(addr.sun_path)) {
+    return false;
+  }
+  addr = {};
+  addr.sun_family = AF_UNIX;
+  socketPath.copy(addr.sun_path, socketPath.size());
+  return true;
+}
+
+/**
+ * @brief Whether the process at the other end of the connection runs as
+ *  our user. Both ends check, so another local user can neither submit
+ *  jobs to our server nor stand in for it.
+ */
+bool sameUser(int fd) {
+  ucred peer;
+  socklen_t len = sizeof(peer);
+  return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &len) == 0 && peer.uid == getuid();
+}
+
+void setTimeouts(int fd) {
+  timeval timeout = {};
+  timeout.tv_sec = IO_TIMEOUT_SECONDS;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+bool writePhases(int fd, const std::vector<PhaseStats>& phases) {
+  if (!writeUInt(fd, phases.size())) return false;
+  for (const PhaseStats& p : phases) {
+    if (!writeString(fd, p.name) || !writeDouble(fd, p.seconds)
+        || !writeUInt64(fd, p.allocations) || !writeUInt64(fd, p.bytes)
+        || !writeUInt64(fd, p.processPeakRSS)) return false;
+  }
+  return true;
+}
+
+bool readPhases(int fd, std::vector<PhaseStats>& phases) {
+  uint32_t count;
+  if (!readUInt(fd, count) || count > MAX_PHASES) return false;
+  phases.resize(count);
+  for (PhaseStats& p : phases) {
+    if (!readString(fd, p.name) || !readDouble(fd, p.seconds)
+        || !readUInt64(fd, p.allocations) || !readUInt64(fd, p.bytes)
+        || !readUInt64(fd, p.processPeakRSS)) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Read one request from the connection, compile it and send
+ *  back the result.
+ */
+void handleConnection(int fd) {
+  if (!sameUser(fd)) {
+    close(fd);
+    return;
+  }
+  setTimeouts(fd);
+  uint32_t magic;
+  uint32_t lexer;
+  uint32_t parser;
+  uint32_t optLevel;
+  CompileJob job;
+  if (readUInt(fd, magic) && magic == PROTOCOL_MAGIC
+      && readString(fd, job.inputFileName)
+      && readString(fd, job.inputString)
+      && readString(fd, job.outputFileName)
+      && readBool(fd, job.printOutput)
+      && readBool(fd, job.noCode)
+      && readString(fd, job.cacheDir)
+      && readUInt64(fd, job.cacheSizeLimit)
+      && readBool(fd, job.incremental)
+      && readUInt(fd, lexer)
+      && lexer <= static_cast<uint32_t>(LexerKind::VERIFY)
+      && readUInt(fd, parser)
+      && parser <= static_cast<uint32_t>(ParserKind::VERIFY)
+      && readBool(fd, job.stream)
+      && readUInt(fd, job.parseThreads)
+      && readUInt(fd, job.semanticThreads)
+      && readUInt(fd, job.errorLimit)
+      && readBool(fd, job.keepUnused)
+      && readUInt(fd, optLevel)
+      && optLevel <= static_cast<uint32_t>(OptLevel::O3)) {
+    job.lexer = static_cast<LexerKind>(lexer);
+    job.parser = static_cast<ParserKind>(parser);
+    job.optLevel = static_cast<OptLevel>(optLevel);
+    CompileResult result = WPLCompiler::compile(job);
+    writeString(fd, result.inputName)
+      && writeString(fd, result.outputFileName)
+      && writeString(fd, result.diagnostics)
+      && writeString(fd, result.ir)
+      && writeBool(fd, result.success)
+      && writeBool(fd, result.cacheHit)
+      && writeUInt(fd, result.reusedComponents)
+      && writeUInt(fd, result.componentCount)
+      && writePhases(fd, result.phases);
+  }
+  close(fd);
+}
+
+} // namespace
+
+/**
+ * @brief The per-user runtime directory when there is one, otherwise a
+ *  directory of our own in /tmp that serve() creates with mode 0700.
+ */
+std::string CompileServer::defaultSocketPath() {
+  const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+  if (runtimeDir != nullptr && *runtimeDir != '\0') {
+    return std::string(runtimeDir) + "/wplc.sock";
+  }
+  return "/tmp/wplc-" + std::to_string(getuid()) + "/wplc.sock";
+}
+
+int CompileServer::serve(const std::string& socketPath, unsigned threads) {
+  sockaddr_un addr;
+  if (!makeAddress(socketPath, addr)) {
+    std::cerr << "Socket path too long: " << socketPath << std::endl;
+    return -1;
+  }
+  std::signal(SIGPIPE, SIG_IGN);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    std::cerr << "Cannot create socket: " << std::strerror(errno) << std::endl;
+    return -1;
+  }
+  std::string socketDir(llvm::sys::path::parent_path(socketPath));
+  if (!socketDir.empty() && mkdir(socketDir.c_str(), 0700) < 0 && errno != EEXIST) {
+    std::cerr << "Cannot create " << socketDir << ": " << std::strerror(errno) << std::endl;
+    close(fd);
+    return -1;
+  }
+  unlink(socketPath.c_str());    // remove a stale socket from an earlier server
+  if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0
+      || chmod(socketPath.c_str(), 0600) < 0
+      || listen(fd, SOMAXCONN) < 0) {
+    std::cerr << "Cannot listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+    close(fd);
+    return -1;
+  }
+
+  // Warm up the lexer and parser ATNs and the LLVM state before the first request
+  CompileJob warmup;
+  warmup.inputString = "int func program() { return 0; }";
+  warmup.noCode = true;
+  WPLCompiler::compile(warmup);
+
+  // SIGINT and SIGTERM interrupt accept rather than kill the process,
+  // so the requests in progress finish and the caller can clean up
+  struct sigaction stop = {};
+  stop.sa_handler = requestStop;
+  sigemptyset(&stop.sa_mask);
+  sigaction(SIGINT, &stop, nullptr);
+  sigaction(SIGTERM, &stop, nullptr);
+
+  std::cerr << "wplc: serving on " << socketPath << std::endl;
+  llvm::ThreadPool pool(llvm::hardware_concurrency(threads));
+  int status = 0;
+  while (!stopRequested) {
+    int client = accept(fd, nullptr, nullptr);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      std::cerr << "accept failed: " << std::strerror(errno) << std::endl;
+      status = -1;
+      break;
+    }
+    pool.async([client] { handleConnection(client); });
+  }
+  pool.wait();
+  close(fd);
+  unlink(socketPath.c_str());
+  return status;
+}
+
+bool CompileServer::request(const std::string& socketPath, const CompileJob& job,
+    CompileResult& result) {
+  sockaddr_un addr;
+  if (!makeAddress(socketPath, addr)) {
+    return false;
+  }
+  std::signal(SIGPIPE, SIG_IGN);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || !sameUser(fd)) {
+    close(fd);
+    return false;
+  }
+  bool ok = writeUInt(fd, PROTOCOL_MAGIC)
+    && writeString(fd, job.inputFileName)
+    && writeString(fd, job.inputString)
+    && writeString(fd, job.outputFileName)
+    && writeBool(fd, job.printOutput)
+    && writeBool(fd, job.noCode)
+    && writeString(fd, job.cacheDir)
+    && writeUInt64(fd, job.cacheSizeLimit)
+    && writeBool(fd, job.incremental)
+    && writeUInt(fd, static_cast<uint32_t>(job.lexer))
+    && writeUInt(fd, static_cast<uint32_t>(job.parser))
+    && writeBool(fd, job.stream)
+    && writeUInt(fd, job.parseThreads)
+    && writeUInt(fd, job.semanticThreads)
+    && writeUInt(fd, job.errorLimit)
+    && writeBool(fd, job.keepUnused)
+    && writeUInt(fd, static_cast<uint32_t>(job.optLevel))
+    && readString(fd, result.inputName)
+    && readString(fd, result.outputFileName)
+    && readString(fd, result.diagnostics)
+    && readString(fd, result.ir)
+    && readBool(fd, result.success)
+    && readBool(fd, result.cacheHit)
+    && readUInt(fd, result.reusedComponents)
+    && readUInt(fd, result.componentCount)
+    && readPhases(fd, result.phases);
+  close(fd);
+  return ok;
+}
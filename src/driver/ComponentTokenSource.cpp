@@ -0,0 +1,48 @@
+/**
+ * @file ComponentTokenSource.cpp
+ * @author nllopez
+ * @brief Implementation of the token source that splits the input into
+ *  top-level components.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "ComponentTokenSource.h"
+#include "WPLParser.h"
+
+antlr4::Token* ComponentTokenSource::peek() {
+  if (!lookahead) {
+    lookahead = source->nextToken();
+  }
+  return lookahead.get();
+}
+
+bool ComponentTokenSource::nextComponent() {
+  depth = 0;
+  atEnd = peek()->getType() == antlr4::Token::EOF;
+  return !atEnd;
+}
+
+std::unique_ptr<antlr4::Token> ComponentTokenSource::nextToken() {
+  antlr4::Token* next = peek();
+  if (atEnd || next->getType() == antlr4::Token::EOF) {
+    // The EOF of a component sits where the next token starts
+    return std::unique_ptr<antlr4::Token>(getTokenFactory()->create(
+      { this, getInputStream() }, antlr4::Token::EOF, "<EOF>", antlr4::Token::DEFAULT_CHANNEL,
+      next->getStartIndex(), next->getStartIndex() - 1, next->getLine(), next->getCharPositionInLine()));
+  }
+  switch (next->getType()) {
+    case WPLParser::LBRACE:
+      depth++;
+      break;
+    case WPLParser::RBRACE:
+      if (depth > 0) {
+        depth--;
+      }
+      atEnd = depth == 0;
+      break;
+    case WPLParser::SEMICOLON:
+      atEnd = depth == 0;
+      break;
+  }
+  return std::move(lookahead);
+}
@@ -0,0 +1,739 @@
+/**
+ * @file DFACache.cpp
+ * @author nllopez
+ * @brief Implementation of the persistent DFA cache. A DFA state keeps
+ *  the ATN configurations it was built from, because the simulators
+ *  extend the DFA from them, so the configurations are written together
+ *  with the prediction contexts, semantic contexts and lexer actions
+ *  they refer to. Shared objects are written once into tables, children
+ *  before parents, and referred to by their table index.
+ *
+ *  File layout, all integers little endian:
+ *    magic, grammar hash, lexer section, parser section
+ *  and each section is
+ *    semantic contexts, prediction contexts, lexer action executors, DFAs
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "DFACache.h"
+#include "antlr4-runtime.h"
+#include "WPLLexer.h"
+#include "WPLParser.h"
+#include "atn/ArrayPredictionContext.h"
+#include "atn/LexerATNConfig.h"
+#include "atn/LexerActionExecutor.h"
+#include "atn/LexerIndexedCustomAction.h"
+#include "atn/OrderedATNConfigSet.h"
+#include "atn/SingletonPredictionContext.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+
+namespace atn = antlr4::atn;
+namespace dfa = antlr4::dfa;
+namespace fs = llvm::sys::fs;
+
+static const char DFA_CACHE_MAGIC[] = "WPLDFA01";
+static const uint32_t NIL = 0xffffffff;            // no object
+static const uint32_t ERROR_STATE = 0xfffffffe;    // edge to ATNSimulator::ERROR
+
+enum SemanticTag : uint32_t { SEM_NONE, SEM_PREDICATE, SEM_PRECEDENCE, SEM_AND, SEM_OR };
+enum ContextTag : uint32_t { CTX_EMPTY, CTX_SINGLETON, CTX_ARRAY };
+
+/**
+ * @brief The DFAs are static members of the generated recognizers, so
+ *  they are reached through a lexer and parser that never run.
+ */
+class Recognizers {
+  public:
+    Recognizers() : input(""), lexer(&input), tokens(&lexer), parser(&tokens) {}
+
+    std::vector<dfa::DFA>& lexerDFA() {
+      return lexer.getInterpreter<atn::LexerATNSimulator>()->_decisionToDFA;
+    }
+    std::vector<dfa::DFA>& parserDFA() {
+      return parser.getInterpreter<atn::ParserATNSimulator>()->decisionToDFA;
+    }
+
+    // The DFAs depend on nothing but the ATNs and the runtime that simulates them
+    std::string grammarHash() {
+      llvm::SHA1 hash;
+      hash.update(antlr4::RuntimeMetaData::VERSION);
+      for (antlr4::atn::SerializedATNView view : {lexer.getSerializedATN(), parser.getSerializedATN()}) {
+        hash.update(llvm::StringRef("\0", 1));
+        hash.update(llvm::StringRef(reinterpret_cast<const char*>(view.data()),
+          view.size() * sizeof(*view.data())));
+      }
+      return llvm::toHex(hash.final(), true);
+    }
+
+    antlr4::ANTLRInputStream input;
+    WPLLexer lexer;
+    antlr4::CommonTokenStream tokens;
+    WPLParser parser;
+};
+
+static void put32(std::string& out, uint32_t value) {
+  char bytes[4];
+  llvm::support::endian::write32le(bytes, value);
+  out.append(bytes, 4);
+}
+
+static void put64(std::string& out, uint64_t value) {
+  char bytes[8];
+  llvm::support::endian::write64le(bytes, value);
+  out.append(bytes, 8);
+}
+
+/**
+ * @brief Bounds checked reads from the mapped cache file.
+ */
+class CacheReader {
+  public:
+    CacheReader(llvm::StringRef data) : p(data.begin()), end(data.end()) {}
+
+    bool get32(uint32_t& value) {
+      if (end - p < 4) return false;
+      value = llvm::support::endian::read32le(p);
+      p += 4;
+      return true;
+    }
+
+    bool get64(uint64_t& value) {
+      if (end - p < 8) return false;
+      value = llvm::support::endian::read64le(p);
+      p += 8;
+      return true;
+    }
+
+    bool getBytes(size_t count, llvm::StringRef& bytes) {
+      if (static_cast<size_t>(end - p) < count) return false;
+      bytes = llvm::StringRef(p, count);
+      p += count;
+      return true;
+    }
+
+    bool atEnd() { return p == end; }
+
+  private:
+    const char* p;
+    const char* end;
+};
+
+/******************************************************************
+ * Writing
+ ******************************************************************/
+class SectionWriter {
+  public:
+    SectionWriter(const atn::ATN& a, bool isLexer) : atn(a), lexer(isLexer) {}
+
+    bool write(std::vector<dfa::DFA>& dfas, std::string& out, std::string& error);
+
+  private:
+    uint32_t semantic(const Ref<const atn::SemanticContext>& sc);
+    uint32_t context(const Ref<const atn::PredictionContext>& pc);
+    uint32_t executor(const Ref<const atn::LexerActionExecutor>& e);
+    uint32_t action(const Ref<const atn::LexerAction>& a);
+    void writeState(dfa::DFAState* s);
+
+    const atn::ATN& atn;
+    bool lexer;
+    bool supported = true;
+    std::string unsupported;
+
+    std::map<const atn::SemanticContext*, uint32_t> semanticIndex;
+    std::map<const atn::PredictionContext*, uint32_t> contextIndex;
+    std::map<const atn::LexerActionExecutor*, uint32_t> executorIndex;
+    std::string semantics, contexts, executors, states;
+};
+
+uint32_t SectionWriter::semantic(const Ref<const atn::SemanticContext>& sc) {
+  if (sc == nullptr) {
+    return NIL;
+  }
+  auto found = semanticIndex.find(sc.get());
+  if (found != semanticIndex.end()) {
+    return found->second;
+  }
+  std::string entry;
+  if (sc == atn::SemanticContext::NONE || *sc == *atn::SemanticContext::NONE) {
+    put32(entry, SEM_NONE);
+  } else if (atn::SemanticContext::Predicate::is(*sc)) {
+    const auto& p = static_cast<const atn::SemanticContext::Predicate&>(*sc);
+    put32(entry, SEM_PREDICATE);
+    put64(entry, p.ruleIndex);
+    put64(entry, p.predIndex);
+    put32(entry, p.isCtxDependent);
+  } else if (atn::SemanticContext::PrecedencePredicate::is(*sc)) {
+    put32(entry, SEM_PRECEDENCE);
+    put32(entry, static_cast<const atn::SemanticContext::PrecedencePredicate&>(*sc).precedence);
+  } else {
+    const auto& op = static_cast<const atn::SemanticContext::Operator&>(*sc);
+    std::vector<uint32_t> operands;
+    for (const Ref<const atn::SemanticContext>& operand : op.getOperands()) {
+      operands.push_back(semantic(operand));
+    }
+    put32(entry, atn::SemanticContext::AND::is(*sc) ? SEM_AND : SEM_OR);
+    put32(entry, operands.size());
+    for (uint32_t operand : operands) {
+      put32(entry, operand);
+    }
+  }
+  uint32_t index = semanticIndex.size();
+  semanticIndex[sc.get()] = index;
+  semantics += entry;
+  return index;
+}
+
+uint32_t SectionWriter::context(const Ref<const atn::PredictionContext>& pc) {
+  if (pc == nullptr) {
+    return NIL;
+  }
+  auto found = contextIndex.find(pc.get());
+  if (found != contextIndex.end()) {
+    return found->second;
+  }
+  std::string entry;
+  if (pc == atn::PredictionContext::EMPTY) {
+    put32(entry, CTX_EMPTY);
+  } else {
+    std::vector<std::pair<uint32_t, uint64_t>> links;
+    for (size_t i = 0; i < pc->size(); i++) {
+      links.push_back({context(pc->getParent(i)), pc->getReturnState(i)});
+    }
+    put32(entry, atn::SingletonPredictionContext::is(*pc) ? CTX_SINGLETON : CTX_ARRAY);
+    put32(entry, links.size());
+    for (auto& link : links) {
+      put32(entry, link.first);
+      put64(entry, link.second);
+    }
+  }
+  uint32_t index = contextIndex.size();
+  contextIndex[pc.get()] = index;
+  contexts += entry;
+  return index;
+}
+
+/**
+ * @brief Lexer actions are written as their index in the ATN. Only the
+ *  position of custom actions is not part of the ATN.
+ */
+uint32_t SectionWriter::action(const Ref<const atn::LexerAction>& a) {
+  for (size_t i = 0; i < atn.lexerActions.size(); i++) {
+    if (atn.lexerActions[i] == a || *atn.lexerActions[i] == *a) {
+      return i;
+    }
+  }
+  supported = false;
+  unsupported = "lexer action " + a->toString() + " is not in the ATN";
+  return NIL;
+}
+
+uint32_t SectionWriter::executor(const Ref<const atn::LexerActionExecutor>& e) {
+  if (e == nullptr) {
+    return NIL;
+  }
+  auto found = executorIndex.find(e.get());
+  if (found != executorIndex.end()) {
+    return found->second;
+  }
+  put32(executors, e->getLexerActions().size());
+  for (const Ref<const atn::LexerAction>& a : e->getLexerActions()) {
+    if (atn::LexerIndexedCustomAction::is(*a)) {
+      const auto& indexed = static_cast<const atn::LexerIndexedCustomAction&>(*a);
+      put32(executors, static_cast<uint32_t>(indexed.getOffset()));
+      put32(executors, action(indexed.getAction()));
+    } else {
+      put32(executors, NIL);
+      put32(executors, action(a));
+    }
+  }
+  uint32_t index = executorIndex.size();
+  executorIndex[e.get()] = index;
+  return index;
+}
+
+void SectionWriter::writeState(dfa::DFAState* s) {
+  put32(states, static_cast<uint32_t>(s->stateNumber));
+  put32(states, (s->isAcceptState ? 1 : 0) | (s->requiresFullContext ? 2 : 0));
+  put64(states, s->prediction);
+  put32(states, executor(s->lexerActionExecutor));
+  put32(states, s->predicates.size());
+  for (dfa::DFAState::PredPrediction& p : s->predicates) {
+    put32(states, semantic(p.pred));
+    put32(states, static_cast<uint32_t>(p.alt));
+  }
+
+  atn::ATNConfigSet* configs = s->configs.get();
+  put32(states, configs != nullptr);
+  if (configs == nullptr) {
+    return;
+  }
+  put32(states, (configs->fullCtx ? 1 : 0) | (configs->hasSemanticContext ? 2 : 0)
+    | (configs->dipsIntoOuterContext ? 4 : 0));
+  put64(states, configs->uniqueAlt);
+  put32(states, configs->conflictingAlts.count());
+  for (size_t i = 0; i < configs->conflictingAlts.size(); i++) {
+    if (configs->conflictingAlts.test(i)) {
+      put32(states, i);
+    }
+  }
+  put32(states, configs->configs.size());
+  for (const Ref<atn::ATNConfig>& c : configs->configs) {
+    put32(states, c->state->stateNumber);
+    put64(states, c->alt);
+    put32(states, context(c->context));
+    put32(states, semantic(c->semanticContext));
+    put64(states, c->reachesIntoOuterContext);
+    if (lexer) {
+      const auto& lc = static_cast<const atn::LexerATNConfig&>(*c);
+      put32(states, executor(lc.getLexerActionExecutor()));
+      put32(states, lc.hasPassedThroughNonGreedyDecision());
+    }
+  }
+}
+
+static void writeEdges(std::string& out, dfa::DFAState* s, std::map<dfa::DFAState*, uint32_t>& index) {
+  std::vector<std::pair<size_t, dfa::DFAState*>> edges(s->edges.begin(), s->edges.end());
+  std::sort(edges.begin(), edges.end(),
+    [](auto& a, auto& b) { return a.first < b.first; });
+  put32(out, edges.size());
+  for (auto& edge : edges) {
+    put64(out, edge.first);
+    put32(out, edge.second == atn::ATNSimulator::ERROR.get() ? ERROR_STATE : index[edge.second]);
+  }
+}
+
+bool SectionWriter::write(std::vector<dfa::DFA>& dfas, std::string& out, std::string& error) {
+  put32(states, dfas.size());
+  for (dfa::DFA& d : dfas) {
+    std::vector<dfa::DFAState*> ordered = d.getStates();    // sorted by state number
+    std::map<dfa::DFAState*, uint32_t> index;
+    for (dfa::DFAState* s : ordered) {
+      index[s] = index.size();
+    }
+    put32(states, d.isPrecedenceDfa());
+    put32(states, ordered.size());
+    for (dfa::DFAState* s : ordered) {
+      writeState(s);
+    }
+    for (dfa::DFAState* s : ordered) {
+      writeEdges(states, s, index);
+    }
+    if (d.isPrecedenceDfa()) {
+      writeEdges(states, d.s0, index);
+    } else {
+      put32(states, d.s0 == nullptr ? NIL : index[d.s0]);
+    }
+  }
+  if (!supported) {
+    error = unsupported;
+    return false;
+  }
+  put32(out, semanticIndex.size());
+  out += semantics;
+  put32(out, contextIndex.size());
+  out += contexts;
+  put32(out, executorIndex.size());
+  out += executors;
+  out += states;
+  return true;
+}
+
+/******************************************************************
+ * Reading. Everything is read and checked before the shared DFAs
+ * are touched.
+ ******************************************************************/
+class SectionReader {
+  public:
+    SectionReader(const atn::ATN& a, bool isLexer) : atn(a), lexer(isLexer) {}
+    ~SectionReader();
+
+    bool read(CacheReader& in, std::vector<dfa::DFA>& dfas);
+    void install(std::vector<dfa::DFA>& dfas);
+
+  private:
+    struct LoadedDFA {
+      std::vector<dfa::DFAState*> states;
+      uint32_t s0 = NIL;
+      std::vector<std::pair<size_t, dfa::DFAState*>> precedenceStarts;
+    };
+
+    bool readSemantics(CacheReader& in);
+    bool readContexts(CacheReader& in);
+    bool readExecutors(CacheReader& in);
+    bool readState(CacheReader& in, dfa::DFAState*& s);
+    bool readEdges(CacheReader& in, LoadedDFA& d, std::vector<std::pair<size_t, dfa::DFAState*>>& edges);
+    atn::ATNState* nonGreedyDecision();
+
+    template <typename T>
+    bool lookup(std::vector<T>& table, uint32_t index, T& value) {
+      if (index == NIL) {
+        value = nullptr;
+        return true;
+      }
+      if (index >= table.size()) return false;
+      value = table[index];
+      return true;
+    }
+
+    const atn::ATN& atn;
+    bool lexer;
+    std::vector<Ref<const atn::SemanticContext>> semantics;
+    std::vector<Ref<const atn::PredictionContext>> contexts;
+    std::vector<Ref<const atn::LexerActionExecutor>> executors;
+    std::vector<LoadedDFA> loaded;
+    bool installed = false;
+};
+
+SectionReader::~SectionReader() {
+  if (installed) {
+    return;
+  }
+  for (LoadedDFA& d : loaded) {
+    for (dfa::DFAState* s : d.states) {
+      delete s;
+    }
+  }
+}
+
+bool SectionReader::readSemantics(CacheReader& in) {
+  uint32_t count;
+  if (!in.get32(count)) return false;
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t tag;
+    if (!in.get32(tag)) return false;
+    if (tag == SEM_NONE) {
+      semantics.push_back(atn::SemanticContext::NONE);
+    } else if (tag == SEM_PREDICATE) {
+      uint64_t ruleIndex, predIndex;
+      uint32_t ctxDependent;
+      if (!in.get64(ruleIndex) || !in.get64(predIndex) || !in.get32(ctxDependent)) return false;
+      semantics.push_back(std::make_shared<atn::SemanticContext::Predicate>(ruleIndex, predIndex, ctxDependent != 0));
+    } else if (tag == SEM_PRECEDENCE) {
+      uint32_t precedence;
+      if (!in.get32(precedence)) return false;
+      semantics.push_back(std::make_shared<atn::SemanticContext::PrecedencePredicate>(static_cast<int>(precedence)));
+    } else if (tag == SEM_AND || tag == SEM_OR) {
+      uint32_t operands;
+      if (!in.get32(operands) || operands == 0) return false;
+      Ref<const atn::SemanticContext> sc;
+      for (uint32_t j = 0; j < operands; j++) {
+        uint32_t index;
+        Ref<const atn::SemanticContext> operand;
+        if (!in.get32(index) || index >= i || !lookup(semantics, index, operand)) return false;
+        if (sc == nullptr) {
+          sc = operand;
+        } else if (tag == SEM_AND) {
+          sc = atn::SemanticContext::And(sc, operand);
+        } else {
+          sc = atn::SemanticContext::Or(sc, operand);
+        }
+      }
+      semantics.push_back(sc);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SectionReader::readContexts(CacheReader& in) {
+  uint32_t count;
+  if (!in.get32(count)) return false;
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t tag;
+    if (!in.get32(tag)) return false;
+    if (tag == CTX_EMPTY) {
+      contexts.push_back(atn::PredictionContext::EMPTY);
+      continue;
+    }
+    uint32_t size;
+    if (!in.get32(size) || size == 0) return false;
+    std::vector<Ref<const atn::PredictionContext>> parents;
+    std::vector<size_t> returnStates;
+    for (uint32_t j = 0; j < size; j++) {
+      uint32_t parent;
+      uint64_t returnState;
+      Ref<const atn::PredictionContext> pc;
+      if (!in.get32(parent) || !in.get64(returnState)) return false;
+      if (parent != NIL && parent >= i) return false;
+      if (!lookup(contexts, parent, pc)) return false;
+      parents.push_back(pc);
+      returnStates.push_back(returnState);
+    }
+    if (tag == CTX_SINGLETON && size == 1) {
+      contexts.push_back(atn::SingletonPredictionContext::create(parents[0], returnStates[0]));
+    } else if (tag == CTX_ARRAY) {
+      contexts.push_back(std::make_shared<atn::ArrayPredictionContext>(std::move(parents), std::move(returnStates)));
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SectionReader::readExecutors(CacheReader& in) {
+  uint32_t count;
+  if (!in.get32(count)) return false;
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t size;
+    if (!in.get32(size)) return false;
+    std::vector<Ref<const atn::LexerAction>> actions;
+    for (uint32_t j = 0; j < size; j++) {
+      uint32_t offset, index;
+      if (!in.get32(offset) || !in.get32(index) || index >= atn.lexerActions.size()) return false;
+      if (offset == NIL) {
+        actions.push_back(atn.lexerActions[index]);
+      } else {
+        actions.push_back(std::make_shared<atn::LexerIndexedCustomAction>(static_cast<int>(offset),
+          atn.lexerActions[index]));
+      }
+    }
+    executors.push_back(std::make_shared<atn::LexerActionExecutor>(std::move(actions)));
+  }
+  return true;
+}
+
+/**
+ * @brief LexerATNConfig only sets its non-greedy flag when it is derived
+ *  from a configuration in a non-greedy decision, so a restored
+ *  configuration that had passed one is derived from such a state.
+ */
+atn::ATNState* SectionReader::nonGreedyDecision() {
+  for (atn::ATNState* state : atn.states) {
+    if (atn::DecisionState::is(state) && static_cast<atn::DecisionState*>(state)->nonGreedy) {
+      return state;
+    }
+  }
+  return nullptr;
+}
+
+bool SectionReader::readState(CacheReader& in, dfa::DFAState*& s) {
+  uint32_t stateNumber, flags, executor, predicates, hasConfigs;
+  uint64_t prediction;
+  if (!in.get32(stateNumber) || !in.get32(flags) || !in.get64(prediction)
+      || !in.get32(executor) || !in.get32(predicates)) return false;
+  std::unique_ptr<dfa::DFAState> state = std::make_unique<dfa::DFAState>(static_cast<int>(stateNumber));
+  state->isAcceptState = flags & 1;
+  state->requiresFullContext = flags & 2;
+  state->prediction = prediction;
+  if (!lookup(executors, executor, state->lexerActionExecutor)) return false;
+  for (uint32_t i = 0; i < predicates; i++) {
+    uint32_t pred, alt;
+    Ref<const atn::SemanticContext> sc;
+    if (!in.get32(pred) || !in.get32(alt) || !lookup(semantics, pred, sc) || sc == nullptr) return false;
+    state->predicates.emplace_back(sc, static_cast<int>(alt));
+  }
+
+  if (!in.get32(hasConfigs)) return false;
+  if (hasConfigs) {
+    uint32_t setFlags, conflicts, count;
+    uint64_t uniqueAlt;
+    if (!in.get32(setFlags) || !in.get64(uniqueAlt) || !in.get32(conflicts)) return false;
+    std::unique_ptr<atn::ATNConfigSet> configs;
+    if (lexer) {
+      configs = std::make_unique<atn::OrderedATNConfigSet>();
+    } else {
+      configs = std::make_unique<atn::ATNConfigSet>((setFlags & 1) != 0);
+    }
+    for (uint32_t i = 0; i < conflicts; i++) {
+      uint32_t alt;
+      if (!in.get32(alt) || alt >= configs->conflictingAlts.size()) return false;
+      configs->conflictingAlts.set(alt);
+    }
+    if (!in.get32(count)) return false;
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t atnState, context, semantic;
+      uint64_t alt, reaches;
+      Ref<const atn::PredictionContext> pc;
+      Ref<const atn::SemanticContext> sc;
+      if (!in.get32(atnState) || !in.get64(alt) || !in.get32(context) || !in.get32(semantic)
+          || !in.get64(reaches)) return false;
+      if (atnState >= atn.states.size() || !lookup(contexts, context, pc) || !lookup(semantics, semantic, sc)
+          || sc == nullptr) return false;
+      Ref<atn::ATNConfig> config;
+      if (lexer) {
+        uint32_t configExecutor, nonGreedy;
+        Ref<const atn::LexerActionExecutor> e;
+        if (!in.get32(configExecutor) || !in.get32(nonGreedy) || !lookup(executors, configExecutor, e)) return false;
+        if (nonGreedy) {
+          atn::ATNState* decision = nonGreedyDecision();
+          if (decision == nullptr) return false;
+          atn::LexerATNConfig seed(decision, static_cast<int>(alt), pc, e);
+          atn::LexerATNConfig passed(seed, decision);
+          config = std::make_shared<atn::LexerATNConfig>(passed, atn.states[atnState]);
+        } else {
+          config = std::make_shared<atn::LexerATNConfig>(atn.states[atnState], static_cast<int>(alt), pc, e);
+        }
+      } else {
+        config = std::make_shared<atn::ATNConfig>(atn.states[atnState], alt, pc, sc);
+      }
+      config->reachesIntoOuterContext = reaches;
+      configs->add(config);
+    }
+    configs->uniqueAlt = uniqueAlt;
+    configs->hasSemanticContext = (setFlags & 2) != 0;
+    configs->dipsIntoOuterContext = (setFlags & 4) != 0;
+    configs->setReadonly(true);
+    state->configs = std::move(configs);
+  }
+  s = state.release();
+  return true;
+}
+
+bool SectionReader::readEdges(CacheReader& in, LoadedDFA& d,
+    std::vector<std::pair<size_t, dfa::DFAState*>>& edges) {
+  uint32_t count;
+  if (!in.get32(count)) return false;
+  for (uint32_t i = 0; i < count; i++) {
+    uint64_t symbol;
+    uint32_t target;
+    if (!in.get64(symbol) || !in.get32(target)) return false;
+    if (target == ERROR_STATE) {
+      edges.push_back({symbol, atn::ATNSimulator::ERROR.get()});
+    } else if (target < d.states.size()) {
+      edges.push_back({symbol, d.states[target]});
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SectionReader::read(CacheReader& in, std::vector<dfa::DFA>& dfas) {
+  if (!readSemantics(in) || !readContexts(in) || !readExecutors(in)) return false;
+  uint32_t count;
+  if (!in.get32(count) || count != dfas.size()) return false;
+  loaded.resize(count);
+  for (uint32_t i = 0; i < count; i++) {
+    LoadedDFA& d = loaded[i];
+    uint32_t precedence, states;
+    if (!in.get32(precedence) || (precedence != 0) != dfas[i].isPrecedenceDfa() || !in.get32(states)) return false;
+    for (uint32_t j = 0; j < states; j++) {
+      dfa::DFAState* s;
+      if (!readState(in, s)) return false;
+      d.states.push_back(s);
+    }
+    for (dfa::DFAState* s : d.states) {
+      std::vector<std::pair<size_t, dfa::DFAState*>> edges;
+      if (!readEdges(in, d, edges)) return false;
+      s->edges.insert(edges.begin(), edges.end());
+    }
+    if (precedence) {
+      if (!readEdges(in, d, d.precedenceStarts)) return false;
+    } else if (!in.get32(d.s0) || (d.s0 != NIL && d.s0 >= d.states.size())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SectionReader::install(std::vector<dfa::DFA>& dfas) {
+  for (size_t i = 0; i < loaded.size(); i++) {
+    for (dfa::DFAState* s : loaded[i].states) {
+      dfas[i].states.insert(s);
+    }
+    if (dfas[i].isPrecedenceDfa()) {
+      dfas[i].s0->edges.insert(loaded[i].precedenceStarts.begin(), loaded[i].precedenceStarts.end());
+    } else if (loaded[i].s0 != NIL) {
+      dfas[i].s0 = loaded[i].states[loaded[i].s0];
+    }
+  }
+  installed = true;
+}
+
+/******************************************************************
+ * DFACache
+ ******************************************************************/
+static size_t countStates(std::vector<dfa::DFA>& dfas) {
+  size_t count = 0;
+  for (dfa::DFA& d : dfas) {
+    count += d.states.size();
+  }
+  return count;
+}
+
+size_t DFACache::stateCount() {
+  Recognizers recognizers;
+  return countStates(recognizers.lexerDFA()) + countStates(recognizers.parserDFA());
+}
+
+bool DFACache::load(const std::string& path, std::string& error) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> file = llvm::MemoryBuffer::getFile(path, false, false);
+  if (!file) {
+    error = "cannot read " + path + ": " + file.getError().message();
+    return false;
+  }
+  Recognizers recognizers;
+  if (countStates(recognizers.lexerDFA()) + countStates(recognizers.parserDFA()) != 0) {
+    error = "the DFAs are already in use";
+    return false;
+  }
+
+  CacheReader in((*file)->getBuffer());
+  llvm::StringRef magic, hash;
+  std::string expected = recognizers.grammarHash();
+  if (!in.getBytes(sizeof(DFA_CACHE_MAGIC) - 1, magic) || magic != DFA_CACHE_MAGIC) {
+    error = path + " is not a DFA cache";
+    return false;
+  }
+  if (!in.getBytes(expected.size(), hash) || hash != expected) {
+    error = path + " was written for another grammar";
+    return false;
+  }
+  SectionReader lexerSection(recognizers.lexer.getATN(), true);
+  SectionReader parserSection(recognizers.parser.getATN(), false);
+  if (!lexerSection.read(in, recognizers.lexerDFA()) || !parserSection.read(in, recognizers.parserDFA())
+      || !in.atEnd()) {
+    error = path + " is damaged";
+    return false;
+  }
+  lexerSection.install(recognizers.lexerDFA());
+  parserSection.install(recognizers.parserDFA());
+  return true;
+}
+
+bool DFACache::save(const std::string& path, std::string& error) {
+  Recognizers recognizers;
+  std::string contents = DFA_CACHE_MAGIC;
+  contents += recognizers.grammarHash();
+  SectionWriter lexerSection(recognizers.lexer.getATN(), true);
+  SectionWriter parserSection(recognizers.parser.getATN(), false);
+  if (!lexerSection.write(recognizers.lexerDFA(), contents, error)
+      || !parserSection.write(recognizers.parserDFA(), contents, error)) {
+    return false;
+  }
+
+  // Write a temporary file and rename it so that readers never see half a cache
+  int fd;
+  llvm::SmallString<256> tmpPath;
+  if (std::error_code ec = fs::createUniqueFile(path + ".tmp-%%%%%%%%", fd, tmpPath)) {
+    error = "cannot write " + path + ": " + ec.message();
+    return false;
+  }
+  {
+    llvm::raw_fd_ostream out(fd, /*shouldClose=*/true);
+    out << contents;
+    out.close();
+    if (out.has_error()) {
+      error = "cannot write " + path + ": " + out.error().message();
+      out.clear_error();
+      fs::remove(tmpPath);
+      return false;
+    }
+  }
+  if (std::error_code ec = fs::rename(tmpPath, path)) {
+    error = "cannot write " + path + ": " + ec.message();
+    fs::remove(tmpPath);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,213 @@
+/**
+ * @file IncrementalBuild.cpp
+ * @author nllopez
+ * @brief Implementation of function granularity recompilation.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "IncrementalBuild.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+
+/**
+ * @brief The source text of a node, including whitespace and comments.
+ */
+static std::string sourceText(antlr4::CharStream* input, const ast::Span& span) {
+  return input->getText(antlr4::misc::Interval(static_cast<size_t>(span.begin), static_cast<size_t>(span.end) - 1));
+}
+
+/**
+ * @brief Copy a function into a module of its own that declares the
+ *  functions and globals it refers to. Private globals such as string
+ *  constants are copied with their initializers.
+ */
+static std::unique_ptr<llvm::Module> extractFunction(llvm::Function* f) {
+  auto m = std::make_unique<llvm::Module>(f->getParent()->getModuleIdentifier(), f->getContext());
+  llvm::ValueToValueMapTy vmap;
+  llvm::Function* nf = llvm::Function::Create(f->getFunctionType(), f->getLinkage(), f->getName(), m.get());
+  vmap[f] = nf;
+  llvm::Function::arg_iterator newArg = nf->arg_begin();
+  for (llvm::Argument& arg : f->args()) {
+    newArg->setName(arg.getName());
+    vmap[&arg] = &*newArg++;
+  }
+
+  std::vector<llvm::Value*> worklist;
+  std::set<llvm::Value*> seen;
+  for (llvm::Instruction& i : llvm::instructions(f)) {
+    for (llvm::Value* op : i.operands()) {
+      worklist.push_back(op);
+    }
+  }
+  while (!worklist.empty()) {
+    llvm::Value* v = worklist.back();
+    worklist.pop_back();
+    if (!seen.insert(v).second) {
+      continue;
+    }
+    if (llvm::Function* callee = llvm::dyn_cast<llvm::Function>(v)) {
+      if (callee != f) {
+        vmap[callee] = llvm::Function::Create(callee->getFunctionType(),
+          llvm::GlobalValue::ExternalLinkage, callee->getName(), m.get());
+      }
+    } else if (llvm::GlobalVariable* gv = llvm::dyn_cast<llvm::GlobalVariable>(v)) {
+      llvm::GlobalVariable* ngv = new llvm::GlobalVariable(*m, gv->getValueType(),
+        gv->isConstant(), gv->getLinkage(), nullptr, gv->getName());
+      ngv->copyAttributesFrom(gv);
+      if (gv->hasLocalLinkage() && gv->hasInitializer()) {
+        ngv->setInitializer(gv->getInitializer());
+      } else {
+        ngv->setLinkage(llvm::GlobalValue::ExternalLinkage);
+      }
+      vmap[gv] = ngv;
+    } else if (llvm::ConstantExpr* ce = llvm::dyn_cast<llvm::ConstantExpr>(v)) {
+      for (llvm::Value* op : ce->operands()) {
+        worklist.push_back(op);
+      }
+    }
+  }
+
+  llvm::SmallVector<llvm::ReturnInst*, 8> returns;
+  llvm::CloneFunctionInto(nf, f, vmap, llvm::CloneFunctionChangeType::DifferentModule, returns);
+  // Cloning into another module adds an empty debug info list we do not use
+  llvm::NamedMDNode* cu = m->getNamedMetadata("llvm.dbg.cu");
+  if (cu && cu->getNumOperands() == 0) {
+    m->eraseNamedMetadata(cu);
+  }
+  return m;
+}
+
+/**
+ * @brief Whether the body of a routine assigns to any of the names. A
+ *  local of the same name counts too, which only costs a reuse.
+ */
+static bool assignsAny(ast::Routine* routine, const llvm::DenseSet<uint32_t>& names) {
+  llvm::SmallVector<ast::Node*, 64> work{routine->b};
+  llvm::SmallVector<ast::Node*, 8> below;
+  while (!work.empty()) {
+    ast::Node* n = work.pop_back_val();
+    if (ast::Assignment* assignment = llvm::dyn_cast<ast::Assignment>(n)) {
+      for (ast::Identifier id : assignment->targets) {
+        if (names.count(id.id())) {
+          return true;
+        }
+      }
+    }
+    below.clear();
+    ast::children(n, below);
+    work.append(below.begin(), below.end());
+  }
+  return false;
+}
+
+void IncrementalBuild::fingerprint(antlr4::CharStream* input, ast::CompilationUnit* tree) {
+  std::string environment;
+  // Globals declared with var and no initializer, which get their type
+  // from the first body that assigns to them
+  llvm::DenseSet<uint32_t> untyped;
+  for (ast::Node* e : tree->components) {
+    std::string signature;
+    if (ast::Routine* routine = llvm::dyn_cast<ast::Routine>(e)) {
+      Component c;
+      c.ctx = e;
+      c.name = routine->id.text().str();
+      // A body that may type a global is part of what later ones depend on
+      signature = sourceText(input, assignsAny(routine, untyped) ? e->span : routine->header);
+      c.key = CompileCache::componentKey(environment, sourceText(input, e->span));
+      c.reused = cache->lookup(c.key, c.ir);
+      components.push_back(c);
+      declarationOrder.push_back(c.name);
+    } else {
+      signature = sourceText(input, e->span);
+      if (ast::ScalarDeclaration* decl = llvm::dyn_cast<ast::ScalarDeclaration>(e)) {
+        for (ast::Scalar* scalar : decl->scalars) {
+          if (decl->t == ast::TypeName::NONE && scalar->vi == nullptr) {
+            untyped.insert(scalar->id.id());
+          }
+        }
+      }
+      if (ast::ExternDeclaration* decl = llvm::dyn_cast<ast::ExternDeclaration>(e)) {
+        declarationOrder.push_back(decl->id.text().str());
+      }
+    }
+    // Chain the signatures so each key depends on every earlier declaration
+    llvm::SHA1 hash;
+    hash.update(environment);
+    hash.update(signature);
+    environment = llvm::toHex(hash.final(), true);
+  }
+}
+
+std::set<ast::Node*> IncrementalBuild::reusedComponents() {
+  std::set<ast::Node*> reused;
+  for (Component& c : components) {
+    if (c.reused) {
+      reused.insert(c.ctx);
+    }
+  }
+  return reused;
+}
+
+unsigned IncrementalBuild::reusedCount() {
+  return reusedComponents().size();
+}
+
+/**
+ * @brief Link the cached definitions over the declarations that codegen
+ *  emitted, then put the functions back in source order.
+ */
+bool IncrementalBuild::splice(llvm::Module* module, const CallGraph* calls, std::string& error) {
+  bool linked = false;
+  for (Component& c : components) {
+    if (!c.reused || (calls && !calls->isReachable(llvm::cast<ast::Routine>(c.ctx)->id))) {
+      continue;
+    }
+    llvm::SMDiagnostic err;
+    std::unique_ptr<llvm::Module> cached = llvm::parseAssemblyString(c.ir, err, module->getContext());
+    if (!cached) {
+      error = "cannot parse the cached IR of " + c.name + ": " + err.getMessage().str();
+      return false;
+    }
+    if (llvm::Linker::linkModules(*module, std::move(cached))) {
+      error = "cannot link the cached IR of " + c.name;
+      return false;
+    }
+    linked = true;
+  }
+  if (linked) {
+    llvm::Module::FunctionListType& functions = module->getFunctionList();
+    for (std::string& name : declarationOrder) {
+      llvm::Function* f = module->getFunction(name);
+      if (f) {
+        functions.splice(functions.end(), functions, f->getIterator());
+      }
+    }
+  }
+  return true;
+}
+
+void IncrementalBuild::store(llvm::Module* module) {
+  for (Component& c : components) {
+    if (c.reused) {
+      continue;
+    }
+    llvm::Function* f = module->getFunction(c.name);
+    if (f == nullptr || f->isDeclaration()) {
+      continue;
+    }
+    std::string ir;
+    llvm::raw_string_ostream irStream(ir);
+    extractFunction(f)->print(irStream, nullptr);
+    irStream.flush();
+    cache->store(c.key, ir);
+  }
+}
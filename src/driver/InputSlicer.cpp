@@ -0,0 +1,183 @@
+/**
+ * @file InputSlicer.cpp
+ * @author nllopez
+ * @brief Implementation of the split of the source into slices of
+ *  top-level components.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "InputSlicer.h"
+#include <cctype>
+
+namespace {
+
+/**
+ * @brief Walks the source a byte at a time, keeping count of the line
+ *  and column the way the lexer does.
+ */
+struct Cursor {
+  llvm::StringRef data;
+  size_t pos = 0;
+  size_t line = 1;
+  size_t column = 0;
+
+  bool atEnd() const { return pos >= data.size(); }
+  char peek(size_t ahead = 0) const {
+    return pos + ahead < data.size() ? data[pos + ahead] : '\0';
+  }
+  void advance() {
+    if (data[pos] == '\n') {
+      line++;
+      column = 0;
+    } else {
+      column++;
+    }
+    pos++;
+  }
+};
+
+// '#' to the end of the line. False if the source ends first.
+bool skipLineComment(Cursor& c) {
+  while (!c.atEnd() && c.peek() != '\n') {
+    c.advance();
+  }
+  return !c.atEnd();
+}
+
+// '(*' to the matching '*)'; these comments nest. False if the source
+// ends first.
+bool skipBlockComment(Cursor& c) {
+  size_t level = 0;
+  do {
+    if (c.peek() == '(' && c.peek(1) == '*') {
+      level++;
+      c.advance();
+    } else if (c.peek() == '*' && c.peek(1) == ')') {
+      level--;
+      c.advance();
+    }
+    c.advance();
+  } while (level > 0 && !c.atEnd());
+  return level == 0;
+}
+
+// A string ends at the next unescaped '"' and cannot span lines. False
+// if it is not closed.
+bool skipString(Cursor& c) {
+  c.advance();
+  while (!c.atEnd() && c.peek() != '"' && c.peek() != '\n') {
+    if (c.peek() == '\\' && c.peek(1) != '\n') {
+      c.advance();
+    }
+    c.advance();
+  }
+  if (c.peek() == '"') {
+    c.advance();
+    return true;
+  }
+  return false;
+}
+
+struct ScanState {
+  size_t depth = 0;        // braces open
+  bool content = false;    // more than whitespace and comments since the last cut
+  bool open = false;       // inside a comment or string
+};
+
+// Scan the source and call cut() at the end of every top-level
+// component. When cut() returns true the content flag starts over.
+template <typename Cut>
+ScanState scan(Cursor& c, Cut cut) {
+  ScanState state;
+  while (!c.atEnd()) {
+    char ch = c.peek();
+    if (ch == '#') {
+      state.open = !skipLineComment(c);
+      continue;
+    }
+    if (ch == '(' && c.peek(1) == '*') {
+      state.open = !skipBlockComment(c);
+      continue;
+    }
+    if (ch == '"') {
+      state.open = !skipString(c);
+      continue;
+    }
+    c.advance();
+    state.open = false;
+    state.content = state.content || !std::isspace(static_cast<unsigned char>(ch));
+    bool componentEnd = false;
+    if (ch == '{') {
+      state.depth++;
+    } else if (ch == '}' && state.depth > 0) {
+      state.depth--;
+      componentEnd = state.depth == 0;
+    } else if (ch == ';') {
+      componentEnd = state.depth == 0;
+    }
+    if (componentEnd && cut(c)) {
+      state.content = false;
+    }
+  }
+  return state;
+}
+
+}
+
+std::vector<InputSlice> InputSlicer::split(llvm::StringRef source, size_t count) {
+  std::vector<InputSlice> slices;
+  size_t target = source.size() / std::max<size_t>(count, 1) + 1;
+  Cursor c;
+  c.data = source;
+  InputSlice slice;
+  ScanState end = scan(c, [&](const Cursor& c) {
+    if (c.pos - slice.begin < target || slices.size() + 1 >= count) {
+      return false;
+    }
+    slice.end = c.pos;
+    slices.push_back(slice);
+    slice.begin = c.pos;
+    slice.line = c.line;
+    slice.column = c.column;
+    return true;
+  });
+  // Whatever follows the last boundary goes into the last slice, or
+  // into the one before if it is only whitespace and comments
+  if (!end.content && !slices.empty()) {
+    slices.back().end = source.size();
+  } else {
+    slice.end = source.size();
+    slices.push_back(slice);
+  }
+  return slices;
+}
+
+bool InputSlicer::closes(llvm::StringRef source) {
+  Cursor c;
+  c.data = source;
+  ScanState end = scan(c, [](const Cursor&) { return true; });
+  return end.depth == 0 && !end.content && !end.open;
+}
+
+bool InputSlicer::blank(llvm::StringRef source) {
+  Cursor c;
+  c.data = source;
+  return !scan(c, [](const Cursor&) { return false; }).content;
+}
+
+std::unique_ptr<antlr4::Token> SliceTokenSource::nextToken() {
+  std::unique_ptr<antlr4::Token> token = source->nextToken();
+  if (token->getType() == antlr4::Token::EOF) {
+    boundary = slice.end == size;
+    return token;
+  }
+  if (token->getStartIndex() < slice.end) {
+    lastStop = token->getStopIndex() + 1;
+    return token;
+  }
+  // The token belongs to the next slice
+  boundary = lastStop == slice.end;
+  return std::unique_ptr<antlr4::Token>(getTokenFactory()->create(
+    { this, getInputStream() }, antlr4::Token::EOF, "<EOF>", antlr4::Token::DEFAULT_CHANNEL,
+    slice.end, slice.end - 1, token->getLine(), token->getCharPositionInLine()));
+}
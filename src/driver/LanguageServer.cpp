@@ -0,0 +1,216 @@
+/**
+ * @file LanguageServer.cpp
+ * @author nllopez
+ * @brief Implementation of the language server.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "LanguageServer.h"
+#include "OpenDocument.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+#include <string>
+
+namespace {
+
+/**
+ * @brief Read the next message, a header of lines ended by an empty
+ *  line and then Content-Length bytes of JSON. False at the end of the
+ *  input.
+ */
+bool readMessage(std::istream& in, std::string& body) {
+  size_t length = 0;
+  std::string line;
+  for (;;) {
+    if (!std::getline(in, line)) {
+      return false;
+    }
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty()) {
+      if (length > 0) {
+        break;
+      }
+      continue;
+    }
+    llvm::StringRef field(line);
+    if (field.consume_front("Content-Length:")) {
+      field.trim().getAsInteger(10, length);
+    }
+  }
+  body.resize(length);
+  return static_cast<bool>(in.read(&body[0], length));
+}
+
+void writeMessage(std::ostream& out, llvm::json::Value message) {
+  std::string body;
+  llvm::raw_string_ostream stream(body);
+  stream << message;
+  stream.flush();
+  out << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+  out.flush();
+}
+
+llvm::json::Object position(size_t line, size_t character) {
+  return llvm::json::Object{{"line", int64_t(line)}, {"character", int64_t(character)}};
+}
+
+using Clock = std::chrono::steady_clock;
+
+class Server {
+  public:
+    Server(std::ostream& o, bool l) : out(o), log(l) {}
+
+    // False once the client has sent exit
+    bool handle(const llvm::json::Object& message);
+    int exitCode() const { return shutdown ? 0 : 1; }
+
+  private:
+    void respond(const llvm::json::Value& id, llvm::json::Value result);
+    void fail(const llvm::json::Value& id, int code, llvm::StringRef message);
+    void notify(llvm::StringRef method, llvm::json::Value params);
+    void publish(llvm::StringRef uri, OpenDocument* document, Clock::time_point start);
+    void change(OpenDocument& document, const llvm::json::Array& changes);
+
+    std::ostream& out;
+    bool log;
+    bool shutdown = false;
+    llvm::StringMap<std::unique_ptr<OpenDocument>> documents;
+};
+
+void Server::respond(const llvm::json::Value& id, llvm::json::Value result) {
+  writeMessage(out, llvm::json::Object{{"jsonrpc", "2.0"}, {"id", id}, {"result", std::move(result)}});
+}
+
+void Server::fail(const llvm::json::Value& id, int code, llvm::StringRef message) {
+  writeMessage(out, llvm::json::Object{{"jsonrpc", "2.0"}, {"id", id},
+    {"error", llvm::json::Object{{"code", code}, {"message", message}}}});
+}
+
+void Server::notify(llvm::StringRef method, llvm::json::Value params) {
+  writeMessage(out, llvm::json::Object{{"jsonrpc", "2.0"}, {"method", method}, {"params", std::move(params)}});
+}
+
+/**
+ * @brief Send the diagnostics of a document, or none for a closed one.
+ *  A diagnostic covers the character at its position. The update is
+ *  timed from when its message was read.
+ */
+void Server::publish(llvm::StringRef uri, OpenDocument* document, Clock::time_point start) {
+  llvm::json::Array diagnostics;
+  if (document != nullptr) {
+    for (const Diagnostic& d : document->diagnostics()) {
+      size_t line = d.line > 0 ? d.line - 1 : 0;
+      diagnostics.push_back(llvm::json::Object{
+        {"range", llvm::json::Object{{"start", position(line, d.column)}, {"end", position(line, d.column + 1)}}},
+        {"severity", 1},
+        {"source", "wplc"},
+        {"message", d.message}});
+    }
+  }
+  if (log && document != nullptr) {
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    llvm::errs() << llvm::format("%s: %.2f ms, %zu components, %zu reparsed, %zu bodies checked, %zu diagnostics\n",
+      uri.str().c_str(), elapsed.count(), document->componentCount(), document->reparsedCount(),
+      document->recheckedCount(), diagnostics.size());
+  }
+  notify("textDocument/publishDiagnostics", llvm::json::Object{{"uri", uri}, {"diagnostics", std::move(diagnostics)}});
+}
+
+// A change with a range replaces that range, one without the whole text
+void Server::change(OpenDocument& document, const llvm::json::Array& changes) {
+  for (const llvm::json::Value& c : changes) {
+    const llvm::json::Object* edit = c.getAsObject();
+    if (edit == nullptr) {
+      continue;
+    }
+    llvm::Optional<llvm::StringRef> text = edit->getString("text");
+    if (!text) {
+      continue;
+    }
+    const llvm::json::Object* range = edit->getObject("range");
+    if (range == nullptr) {
+      document.setText(text->str());
+      continue;
+    }
+    const llvm::json::Object* start = range->getObject("start");
+    const llvm::json::Object* end = range->getObject("end");
+    if (start == nullptr || end == nullptr) {
+      continue;
+    }
+    size_t begin = document.offset(start->getInteger("line").getValueOr(0),
+      start->getInteger("character").getValueOr(0));
+    size_t finish = document.offset(end->getInteger("line").getValueOr(0),
+      end->getInteger("character").getValueOr(0));
+    document.edit(begin, std::max(begin, finish), *text);
+  }
+}
+
+bool Server::handle(const llvm::json::Object& message) {
+  llvm::StringRef method = message.getString("method").getValueOr("");
+  const llvm::json::Value* id = message.get("id");
+  const llvm::json::Object* params = message.getObject("params");
+  const llvm::json::Object* textDocument = params ? params->getObject("textDocument") : nullptr;
+  llvm::StringRef uri = textDocument ? textDocument->getString("uri").getValueOr("") : "";
+  Clock::time_point start = Clock::now();
+
+  // initialize and shutdown are requests, but one sent without an id
+  // gets no answer rather than taking the server down
+  if (method == "initialize") {
+    if (id != nullptr) {
+      respond(*id, llvm::json::Object{
+        {"capabilities", llvm::json::Object{
+          {"textDocumentSync", llvm::json::Object{{"openClose", true}, {"change", 2}}}}},
+        {"serverInfo", llvm::json::Object{{"name", "wplc"}}}});
+    }
+  } else if (method == "shutdown") {
+    shutdown = true;
+    if (id != nullptr) {
+      respond(*id, nullptr);
+    }
+  } else if (method == "exit") {
+    return false;
+  } else if (method == "textDocument/didOpen" && textDocument) {
+    std::string text = textDocument->getString("text").getValueOr("").str();
+    std::unique_ptr<OpenDocument>& document = documents[uri];
+    document = std::make_unique<OpenDocument>(std::move(text));
+    publish(uri, document.get(), start);
+  } else if (method == "textDocument/didChange" && textDocument) {
+    auto document = documents.find(uri);
+    const llvm::json::Array* changes = params->getArray("contentChanges");
+    if (document != documents.end() && changes != nullptr) {
+      change(*document->second, *changes);
+      publish(uri, document->second.get(), start);
+    }
+  } else if (method == "textDocument/didClose" && textDocument) {
+    documents.erase(uri);
+    publish(uri, nullptr, start);
+  } else if (id != nullptr) {
+    fail(*id, -32601, "method not found: " + method.str());
+  }
+  // Other notifications need no answer
+  return true;
+}
+
+}
+
+int LanguageServer::serve(std::istream& in, std::ostream& out, bool log) {
+  Server server(out, log);
+  std::string body;
+  while (readMessage(in, body)) {
+    llvm::Expected<llvm::json::Value> message = llvm::json::parse(body);
+    if (!message) {
+      llvm::consumeError(message.takeError());
+      continue;
+    }
+    const llvm::json::Object* object = message->getAsObject();
+    if (object != nullptr && !server.handle(*object)) {
+      return server.exitCode();
+    }
+  }
+  return 1;
+}
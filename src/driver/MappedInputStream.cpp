@@ -0,0 +1,72 @@
+/**
+ * @file MappedInputStream.cpp
+ * @author nllopez
+ * @brief Implementation of the byte oriented character stream. It
+ *  follows ANTLRInputStream so the lexer sees the same stream.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "MappedInputStream.h"
+
+/**
+ * @brief True if every byte is 7-bit ASCII. The loop has no early exit
+ *  so that the compiler can vectorize it.
+ */
+bool MappedInputStream::isASCII(llvm::StringRef buffer) {
+  unsigned char bits = 0;
+  for (char c : buffer) {
+    bits |= static_cast<unsigned char>(c);
+  }
+  return bits < 0x80;
+}
+
+void MappedInputStream::consume() {
+  if (p >= data.size()) {
+    throw antlr4::IllegalStateException("cannot consume EOF");
+  }
+  p++;
+}
+
+size_t MappedInputStream::LA(ssize_t i) {
+  if (i == 0) {
+    return 0;    // undefined
+  }
+  ssize_t position = static_cast<ssize_t>(p);
+  if (i < 0) {
+    i++;    // e.g., translate LA(-1) to use offset i=0; then data[p+0-1]
+    if (position + i - 1 < 0) {
+      return antlr4::IntStream::EOF;
+    }
+  }
+  if (position + i - 1 >= static_cast<ssize_t>(data.size())) {
+    return antlr4::IntStream::EOF;
+  }
+  return static_cast<unsigned char>(data[position + i - 1]);
+}
+
+void MappedInputStream::seek(size_t index) {
+  p = std::min(index, data.size());
+}
+
+std::string MappedInputStream::getSourceName() const {
+  if (name.empty()) {
+    return antlr4::IntStream::UNKNOWN_SOURCE_NAME;
+  }
+  return name;
+}
+
+std::string MappedInputStream::getText(const antlr4::misc::Interval& interval) {
+  if (interval.a < 0 || interval.b < 0) {
+    return "";
+  }
+  size_t start = static_cast<size_t>(interval.a);
+  size_t stop = static_cast<size_t>(interval.b);
+  if (stop >= data.size()) {
+    stop = data.size() - 1;
+  }
+  if (start >= data.size()) {
+    return "";
+  }
+  // Same unsigned arithmetic as ANTLRInputStream for reversed intervals
+  return data.substr(start, stop - start + 1).str();
+}
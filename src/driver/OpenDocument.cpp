@@ -0,0 +1,349 @@
+/**
+ * @file OpenDocument.cpp
+ * @author nllopez
+ * @brief Implementation of the incremental reparse and check of a
+ *  document open in the language server.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "OpenDocument.h"
+#include "InputSlicer.h"
+#include "SemanticVisitor.h"
+#include "STManager.h"
+#include "PropertyManager.h"
+#include "llvm/ADT/STLExtras.h"
+#include <cstdint>
+
+namespace {
+
+size_t countNonASCII(llvm::StringRef s) {
+  return llvm::count_if(s, [](char ch) { return static_cast<unsigned char>(ch) > 127; });
+}
+
+}
+
+OpenDocument::OpenDocument(std::string source) {
+  job.lexer = LexerKind::FAST;
+  job.parser = ParserKind::FAST;
+  job.noCode = true;
+  setText(std::move(source));
+}
+
+void OpenDocument::setText(std::string source) {
+  text = std::move(source);
+  lineStarts.assign(1, 0);
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] == '\n') {
+      lineStarts.push_back(i + 1);
+    }
+  }
+  nonASCII = countNonASCII(text);
+  reparseAll();
+}
+
+/**
+ * @brief Replace part of the text and reparse the components the edit
+ *  touches. A component that only ends or begins where the edit is
+ *  counts as touched, since the edit may join it to its neighbour.
+ */
+void OpenDocument::edit(size_t begin, size_t end, llvm::StringRef newText) {
+  end = std::min(end, text.size());
+  begin = std::min(begin, end);
+  nonASCII = nonASCII - countNonASCII(llvm::StringRef(text).slice(begin, end)) + countNonASCII(newText);
+
+  // The components from first to last are touched
+  size_t first = llvm::partition_point(components, [&](const Component& c) { return c.end < begin; })
+    - components.begin();
+  size_t last = llvm::partition_point(components, [&](const Component& c) { return c.begin <= end; })
+    - components.begin();
+
+  text.replace(begin, end - begin, newText.data(), newText.size());
+  ptrdiff_t delta = static_cast<ptrdiff_t>(newText.size()) - static_cast<ptrdiff_t>(end - begin);
+
+  // Lines that started inside the replaced bytes go, those of the new
+  // text come in and those after it move
+  size_t line = std::upper_bound(lineStarts.begin(), lineStarts.end(), begin) - lineStarts.begin();
+  size_t after = std::upper_bound(lineStarts.begin(), lineStarts.end(), end) - lineStarts.begin();
+  lineStarts.erase(lineStarts.begin() + line, lineStarts.begin() + after);
+  for (size_t i = line; i < lineStarts.size(); i++) {
+    lineStarts[i] += delta;
+  }
+  std::vector<size_t> added;
+  for (size_t i = 0; i < newText.size(); i++) {
+    if (newText[i] == '\n') {
+      added.push_back(begin + i + 1);
+    }
+  }
+  lineStarts.insert(lineStarts.begin() + line, added.begin(), added.end());
+
+  dirty = true;
+  if (whole || nonASCII > 0 || first >= last) {
+    reparseAll();
+    return;
+  }
+  last--;
+  for (size_t i = last + 1; i < components.size(); i++) {
+    components[i].begin += delta;
+    components[i].end += delta;
+  }
+  components[last].end += delta;
+
+  // Widen the text to parse until it ends on a component boundary and
+  // holds at least one component
+  size_t regionBegin = components[first].begin;
+  size_t regionEnd = components[last].end;
+  for (;;) {
+    llvm::StringRef region = llvm::StringRef(text).slice(regionBegin, regionEnd);
+    bool blank = InputSlicer::blank(region);
+    if (blank && first > 0) {
+      regionBegin = components[--first].begin;
+    } else if ((blank || !InputSlicer::closes(region)) && last + 1 < components.size()) {
+      regionEnd = components[++last].end;
+    } else {
+      break;
+    }
+  }
+  if (!reparse(first, last - first + 1, regionBegin, regionEnd)) {
+    reparseAll();
+  }
+}
+
+void OpenDocument::reparseAll() {
+  components.clear();
+  names = std::make_shared<ast::NameTable>();
+  dirty = true;
+  whole = nonASCII > 0;
+  if (!whole && !reparse(0, 0, 0, text.size())) {
+    whole = true;
+    components.clear();
+  }
+}
+
+/**
+ * @brief Parse the text from begin to end into components that take the
+ *  place of count components from first. False if the lexer does not
+ *  end a component where the slicer does.
+ */
+bool OpenDocument::reparse(size_t first, size_t count, size_t begin, size_t end) {
+  std::vector<Component> parsed;
+  llvm::StringRef region = llvm::StringRef(text).slice(begin, end);
+  if (!InputSlicer::blank(region)) {
+    for (const InputSlice& s : InputSlicer::split(region, SIZE_MAX)) {
+      InputSlice slice;
+      slice.begin = begin + s.begin;
+      slice.end = begin + s.end;
+      size_t line = lineOf(slice.begin);
+      slice.line = line + 1;
+      slice.column = slice.begin - lineStarts[line];
+      Component c;
+      c.begin = slice.begin;
+      c.end = slice.end;
+      c.parsedLine = slice.line;
+      c.parsedColumn = slice.column;
+      c.tree = WPLCompiler::parseComponent(job, text, slice, names, c.syntaxErrors);
+      if (!c.tree && c.syntaxErrors.empty()) {
+        return false;
+      }
+      parsed.push_back(std::move(c));
+    }
+  }
+  reparsed += parsed.size();
+  components.erase(components.begin() + first, components.begin() + first + count);
+  components.insert(components.begin() + first,
+    std::make_move_iterator(parsed.begin()), std::make_move_iterator(parsed.end()));
+  return true;
+}
+
+size_t OpenDocument::lineOf(size_t offset) const {
+  return std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin() - 1;
+}
+
+size_t OpenDocument::offset(size_t line, size_t character) const {
+  if (line >= lineStarts.size()) {
+    return text.size();
+  }
+  size_t p = lineStarts[line];
+  size_t units = 0;
+  while (units < character && p < text.size() && text[p] != '\n') {
+    unsigned char lead = text[p];
+    size_t length = lead < 0x80 ? 1 : lead < 0xe0 ? 2 : lead < 0xf0 ? 3 : 4;
+    units += length == 4 ? 2 : 1;    // UTF-16 needs a surrogate pair
+    p += length;
+  }
+  return std::min(p, text.size());
+}
+
+const std::vector<Diagnostic>& OpenDocument::diagnostics() {
+  if (dirty) {
+    current.clear();
+    rechecked = 0;
+    check();
+    lastReparsed = reparsed;
+    reparsed = 0;
+    dirty = false;
+  }
+  return current;
+}
+
+// Move a position in the tree of a component to where it is now
+void OpenDocument::report(const Component& c, size_t line, size_t column, const std::string& message) {
+  size_t now = lineOf(c.begin);
+  Diagnostic d;
+  d.line = line - c.parsedLine + now + 1;
+  d.column = line == c.parsedLine ? column - c.parsedColumn + (c.begin - lineStarts[now]) : column;
+  d.message = message;
+  current.push_back(d);
+}
+
+/**
+ * @brief Report the syntax errors if there are any, as wplc does, and
+ *  otherwise declare the globals and check the bodies that need it.
+ */
+void OpenDocument::check() {
+  if (whole) {
+    compileWhole();
+    return;
+  }
+  bool syntaxErrors = false;
+  for (const Component& c : components) {
+    for (const SyntaxError& e : c.syntaxErrors) {
+      report(c, e.line, e.column, e.message);
+      syntaxErrors = true;
+    }
+  }
+  if (syntaxErrors) {
+    return;
+  }
+
+  STManager globals;
+  PropertyManager properties;
+  SemanticVisitor declarer(&globals, &properties);
+  declarer.beginCompilationUnit();
+  std::vector<size_t> visible(components.size());
+  std::vector<size_t> declarationErrors(components.size() + 1, 0);
+  for (size_t i = 0; i < components.size(); i++) {
+    visible[i] = globals.declarationCount();
+    declarer.declareComponent(components[i].node());
+    declarationErrors[i + 1] = declarer.getErrorList().size();
+  }
+
+  STManager bodies;
+  std::vector<ast::Identifier> uses;
+  bodies.setGlobalUses(&uses);
+  SemanticVisitor checker(&bodies, &properties);
+  STManager probe;
+  for (size_t i = 0; i < components.size(); i++) {
+    Component& c = components[i];
+    ast::Routine* routine = llvm::dyn_cast<ast::Routine>(c.node());
+    if (routine == nullptr) {
+      continue;
+    }
+    probe.setGlobals(&globals, visible[i]);
+    for (const GlobalUse& use : c.uses) {
+      Symbol* symbol = probe.findSymbol(use.id);
+      if ((symbol != nullptr) != use.found || (symbol != nullptr && symbol->type != use.type)) {
+        c.checked = false;
+        break;
+      }
+    }
+    if (c.checked) {
+      continue;
+    }
+    bodies.setGlobals(&globals, visible[i]);
+    uses.clear();
+    size_t errorsBefore = checker.getErrorList().size();
+    checker.checkBody(routine);
+    if (checker.needsSequentialCheck()) {
+      checkInOrder();
+      return;
+    }
+    c.bodyErrors.clear();
+    for (size_t e = errorsBefore; e < checker.getErrorList().size(); e++) {
+      const WPLError& error = checker.getErrorList()[e];
+      c.bodyErrors.push_back({error.line, error.column, error.message()});
+    }
+    llvm::sort(uses, [](ast::Identifier a, ast::Identifier b) { return a.id() < b.id(); });
+    uses.erase(std::unique(uses.begin(), uses.end()), uses.end());
+    c.uses.clear();
+    for (ast::Identifier id : uses) {
+      Symbol* symbol = probe.findSymbol(id);
+      c.uses.push_back({id, symbol != nullptr, symbol != nullptr ? symbol->type : SymType::UNDEFINED});
+    }
+    c.checked = true;
+    rechecked++;
+  }
+
+  // The errors of a body come before those of its declaration
+  for (size_t i = 0; i < components.size(); i++) {
+    Component& c = components[i];
+    for (const SyntaxError& e : c.bodyErrors) {
+      report(c, e.line, e.column, e.message);
+    }
+    for (size_t e = declarationErrors[i]; e < declarationErrors[i + 1]; e++) {
+      const WPLError& error = declarer.getErrorList()[e];
+      report(c, error.line, error.column, error.message());
+    }
+  }
+}
+
+/**
+ * @brief Check the components one after the other, for a unit where a
+ *  body gives a global its type. Nothing is kept for the next update.
+ */
+void OpenDocument::checkInOrder() {
+  current.clear();
+  STManager stm;
+  PropertyManager properties;
+  SemanticVisitor sv(&stm, &properties);
+  sv.beginCompilationUnit();
+  size_t reported = 0;
+  for (Component& c : components) {
+    c.checked = false;
+    sv.visitComponent(c.node());
+    for (; reported < sv.getErrorList().size(); reported++) {
+      const WPLError& error = sv.getErrorList()[reported];
+      report(c, error.line, error.column, error.message());
+    }
+    rechecked++;
+  }
+}
+
+/**
+ * @brief Compile the whole text as wplc does and keep the syntax and
+ *  semantic errors it reports.
+ */
+void OpenDocument::compileWhole() {
+  CompileJob single = job;
+  single.inputFileName = "-";
+  single.inputString = text;
+  CompileResult result = WPLCompiler::compile(single);
+  llvm::StringRef diagnostics = result.diagnostics;
+  while (!diagnostics.empty()) {
+    llvm::StringRef line;
+    std::tie(line, diagnostics) = diagnostics.split('\n');
+    Diagnostic d;
+    llvm::StringRef message;
+    // "SEMANTIC: [line,column]: message" or "line line:column message"
+    if (line.consume_front("SEMANTIC: [")) {
+      llvm::StringRef position;
+      std::tie(position, message) = line.split("]: ");
+      llvm::StringRef l, c;
+      std::tie(l, c) = position.split(',');
+      if (l.getAsInteger(10, d.line) || c.getAsInteger(10, d.column)) {
+        continue;
+      }
+    } else if (line.consume_front("line ")) {
+      llvm::StringRef position;
+      std::tie(position, message) = line.split(' ');
+      llvm::StringRef l, c;
+      std::tie(l, c) = position.split(':');
+      if (l.getAsInteger(10, d.line) || c.getAsInteger(10, d.column)) {
+        continue;
+      }
+    } else {
+      continue;
+    }
+    d.message = message.str();
+    current.push_back(d);
+  }
+}
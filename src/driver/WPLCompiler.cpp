@@ -0,0 +1,862 @@
+/**
+ * @file WPLCompiler.cpp
+ * @author nllopez
+ * @brief Implementation of the single input compilation pipeline.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "WPLCompiler.h"
+#include "CompileCache.h"
+#include "MemoryAccounting.h"
+#include "IncrementalBuild.h"
+#include "MappedInputStream.h"
+#include "WPLFastLexer.h"
+#include "WPLFastParser.h"
+#include "ASTLowering.h"
+#include "ComponentTokenSource.h"
+#include "InputSlicer.h"
+#include <chrono>
+#include <memory>
+#include "antlr4-runtime.h"
+#include "WPLLexer.h"
+#include "WPLParser.h"
+#include "WPLSyntaxErrorListener.h"
+#include "SemanticVisitor.h"
+#include "CodegenVisitor.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+
+/**
+ * @brief The name of the .ll file for the job. Unless -o was given it is
+ *  the input file name with its extension replaced by .ll
+ */
+std::string WPLCompiler::irFileName(const CompileJob& job) {
+  if (job.outputFileName != "-") {
+    return job.outputFileName;
+  }
+  return job.inputFileName.substr(0, job.inputFileName.find_last_of('.')) + ".ll";
+}
+
+/**
+ * @brief Measures one phase of the pipeline for -time-report and
+ *  -mem-report, and records it as a span for -time-trace. A phase that
+ *  hands work to a thread pool adds what the pool threads allocated.
+ */
+class PhaseTimer {
+  public:
+    PhaseTimer(CompileResult& r, const char* phase)
+      : result(r), name(phase), trace(phase, r.inputName),
+        startCounts(MemoryAccounting::threadCounts()),
+        start(std::chrono::steady_clock::now()) {}
+
+    ~PhaseTimer() {
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      AllocationCounts counts = MemoryAccounting::threadCounts();
+      PhaseStats stats;
+      stats.name = name;
+      stats.seconds = elapsed.count();
+      stats.allocations = counts.allocations - startCounts.allocations + workerCounts.allocations;
+      stats.bytes = counts.bytes - startCounts.bytes + workerCounts.bytes;
+      stats.processPeakRSS = MemoryAccounting::peakRSS();
+      result.phases.push_back(stats);
+    }
+
+    // Allocations made for the phase on other threads
+    void addWorkerCounts(const AllocationCounts& counts) { workerCounts.add(counts); }
+
+  private:
+    CompileResult& result;
+    const char* name;
+    llvm::TimeTraceScope trace;
+    AllocationCounts startCounts;
+    AllocationCounts workerCounts;
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @brief The time trace profiler is per thread. A worker thread starts
+ *  its own and hands it over to the main thread's trace when it is done.
+ */
+class ThreadTimeTrace {
+  public:
+    ThreadTimeTrace(const CompileJob& job) {
+      if (job.timeTrace && !llvm::timeTraceProfilerEnabled()) {
+        llvm::timeTraceProfilerInitialize(job.timeTraceGranularity, "wplc");
+        owner = true;
+      }
+    }
+
+    ~ThreadTimeTrace() {
+      if (owner) {
+        llvm::timeTraceProfilerFinishThread();
+      }
+    }
+
+  private:
+    bool owner = false;
+};
+
+/**
+ * @brief Print the IR and write the output file for a successful compile.
+ */
+static void emitOutput(const CompileJob& job, const std::string& ir, CompileResult& result) {
+  if (job.printOutput) {
+    result.ir = ir;
+  }
+  if (!job.noCode) {
+    result.outputFileName = WPLCompiler::irFileName(job);
+    std::error_code ec;
+    llvm::raw_fd_ostream irFileStream(result.outputFileName, ec);
+    if (ec) {
+      result.diagnostics = "cannot write " + result.outputFileName + ": " + ec.message();
+      return;
+    }
+    irFileStream << ir;
+    irFileStream.flush();
+  }
+  result.success = true;
+}
+
+/**
+ * @brief How a token is shown in a -lexer=verify mismatch.
+ */
+static std::string describeToken(antlr4::Token* token, const antlr4::dfa::Vocabulary& vocabulary) {
+  std::string type = token->getType() == antlr4::Token::EOF ? "EOF"
+    : std::string(vocabulary.getDisplayName(token->getType()));
+  return type + " at " + std::to_string(token->getLine()) + ":"
+    + std::to_string(token->getCharPositionInLine()) + " (characters "
+    + std::to_string(token->getStartIndex()) + " to "
+    + std::to_string(static_cast<long long>(token->getStopIndex())) + ")";
+}
+
+/**
+ * @brief Lex the input again with the ANTLR lexer and compare it with
+ *  the tokens and errors of the fast lexer. Returns a description of
+ *  the first difference, or an empty string if there is none.
+ */
+static std::string compareLexers(WPLLexer& lexer, WPLSyntaxErrorListener& lexerErrors,
+    antlr4::CommonTokenStream& tokens, WPLSyntaxErrorListener& fastErrors) {
+  const antlr4::dfa::Vocabulary& vocabulary = lexer.getVocabulary();
+  std::vector<antlr4::Token*> fast = tokens.getTokens();
+  for (size_t i = 0;; i++) {
+    std::unique_ptr<antlr4::Token> expected = lexer.nextToken();
+    if (i == fast.size()) {
+      return "lexer mismatch: the fast lexer stops before " + describeToken(expected.get(), vocabulary);
+    }
+    antlr4::Token* actual = fast[i];
+    if (actual->getType() != expected->getType()
+        || actual->getStartIndex() != expected->getStartIndex()
+        || actual->getStopIndex() != expected->getStopIndex()
+        || actual->getLine() != expected->getLine()
+        || actual->getCharPositionInLine() != expected->getCharPositionInLine()) {
+      return "lexer mismatch at token " + std::to_string(i) + ": the fast lexer gives "
+        + describeToken(actual, vocabulary) + ", the ANTLR lexer gives "
+        + describeToken(expected.get(), vocabulary);
+    }
+    if (expected->getType() == antlr4::Token::EOF) {
+      break;
+    }
+  }
+  if (fastErrors.errorList() != lexerErrors.errorList()) {
+    return "lexer mismatch in the errors:\nfast lexer:\n" + fastErrors.errorList()
+      + "ANTLR lexer:\n" + lexerErrors.errorList();
+  }
+  return "";
+}
+
+/**
+ * @brief Parse in two stages. The SLL prediction of the first stage is
+ *  much cheaper on long expressions but may fail on input that full LL
+ *  accepts, so it bails out at the first error and the input is parsed
+ *  again with full LL prediction and the default error recovery. Only
+ *  the second stage reports syntax errors, so the messages are the same
+ *  as those of a single LL parse. With -parser=fast the hand-written
+ *  parser takes the place of the first stage. A profiled parse skips
+ *  the first stage, so that the profile shows which decisions need
+ *  full LL prediction.
+ */
+static WPLParser::CompilationUnitContext* parseCompilationUnit(WPLParser& parser,
+    WPLSyntaxErrorListener& syntaxErrors, ParserKind kind, bool profile) {
+  antlr4::atn::ParserATNSimulator* interpreter = parser.getInterpreter<antlr4::atn::ParserATNSimulator>();
+  if (profile) {
+    // The profiling simulator shares the DFA of the one it replaces.
+    // Parser::setProfile() would leak the old one.
+    antlr4::atn::ParserATNSimulator* plain = interpreter;
+    interpreter = new antlr4::atn::ProfilingATNSimulator(&parser);
+    parser.setInterpreter(interpreter);
+    delete plain;
+  } else if (kind != ParserKind::ANTLR) {
+    llvm::TimeTraceScope scope("Parse fast");
+    WPLParser::CompilationUnitContext* tree = WPLFastParser(parser).compilationUnit();
+    if (tree) {
+      return tree;
+    }
+  } else {
+    interpreter->setPredictionMode(antlr4::atn::PredictionMode::SLL);
+    parser.setErrorHandler(std::make_shared<antlr4::BailErrorStrategy>());
+    try {
+      llvm::TimeTraceScope scope("Parse SLL");
+      return parser.compilationUnit();
+    } catch (antlr4::ParseCancellationException& e) {
+      // Fall through to the full LL parse
+    }
+  }
+  llvm::TimeTraceScope scope("Parse LL");
+  parser.reset();
+  interpreter->setPredictionMode(antlr4::atn::PredictionMode::LL);
+  parser.setErrorHandler(std::make_shared<antlr4::DefaultErrorStrategy>());
+  parser.addErrorListener(&syntaxErrors);
+  return parser.compilationUnit();
+}
+
+/**
+ * @brief How a parse tree node is shown in a -parser=verify mismatch.
+ */
+static std::string describeNode(antlr4::tree::ParseTree* node, WPLParser& parser) {
+  if (auto* terminal = dynamic_cast<antlr4::tree::TerminalNode*>(node)) {
+    return describeToken(terminal->getSymbol(), parser.getVocabulary());
+  }
+  auto* rule = static_cast<antlr4::ParserRuleContext*>(node);
+  antlr4::Token* start = rule->getStart();
+  return "rule " + parser.getRuleNames()[rule->getRuleIndex()] + " at "
+    + std::to_string(start->getLine()) + ":" + std::to_string(start->getCharPositionInLine())
+    + " with " + std::to_string(rule->children.size()) + " children";
+}
+
+static ssize_t tokenIndex(antlr4::Token* token) {
+  return token ? static_cast<ssize_t>(token->getTokenIndex()) : -1;
+}
+
+/**
+ * @brief Whether two parse tree nodes match, not counting their children.
+ *  Comparing the context classes also compares the labelled alternative
+ *  of a rule.
+ */
+static bool sameNode(antlr4::tree::ParseTree* a, antlr4::tree::ParseTree* b) {
+  if (typeid(*a) != typeid(*b) || a->children.size() != b->children.size()) {
+    return false;
+  }
+  if (auto* terminal = dynamic_cast<antlr4::tree::TerminalNode*>(a)) {
+    return tokenIndex(terminal->getSymbol())
+      == tokenIndex(static_cast<antlr4::tree::TerminalNode*>(b)->getSymbol());
+  }
+  auto* ra = static_cast<antlr4::ParserRuleContext*>(a);
+  auto* rb = static_cast<antlr4::ParserRuleContext*>(b);
+  return tokenIndex(ra->getStart()) == tokenIndex(rb->getStart())
+    && tokenIndex(ra->getStop()) == tokenIndex(rb->getStop());
+}
+
+/**
+ * @brief Parse the tokens again with the ANTLR parser and compare its
+ *  tree with the one of the fast parser, node by node in source order.
+ *  Returns a description of the first difference, or an empty string
+ *  if there is none.
+ */
+static std::string compareParsers(WPLParser::CompilationUnitContext* fast,
+    antlr4::CommonTokenStream& tokens) {
+  tokens.seek(0);
+  WPLParser parser(&tokens);
+  parser.removeErrorListeners();
+  WPLSyntaxErrorListener errors;
+  WPLParser::CompilationUnitContext* expected = parseCompilationUnit(parser, errors, ParserKind::ANTLR, false);
+  if (errors.hasErrors()) {
+    return "parser mismatch: the fast parser accepts the input, the ANTLR parser reports\n"
+      + errors.errorList();
+  }
+  // As deep as the nesting of the input, so walked without recursion
+  std::vector<std::pair<antlr4::tree::ParseTree*, antlr4::tree::ParseTree*>> work{{fast, expected}};
+  while (!work.empty()) {
+    auto [a, b] = work.back();
+    work.pop_back();
+    if (!sameNode(a, b)) {
+      return "parser mismatch: the fast parser gives " + describeNode(a, parser)
+        + ", the ANTLR parser gives " + describeNode(b, parser);
+    }
+    for (size_t i = a->children.size(); i-- > 0;) {
+      work.emplace_back(a->children[i], b->children[i]);
+    }
+  }
+  return "";
+}
+
+/**
+ * @brief Add the decisions profiled by a parser to the profile of the
+ *  compile. Every WPLParser numbers its decisions the same way, so the
+ *  profiles of several parsers add up decision by decision.
+ */
+static void addParserProfile(WPLParser& parser, std::vector<DecisionProfile>& profile) {
+  auto* profiler = dynamic_cast<antlr4::atn::ProfilingATNSimulator*>(
+    parser.getInterpreter<antlr4::atn::ParserATNSimulator>());
+  if (profiler == nullptr) {
+    return;
+  }
+  const antlr4::atn::ATN& atn = parser.getATN();
+  profile.resize(atn.getNumberOfDecisions());
+  for (const antlr4::atn::DecisionInfo& info : profiler->getDecisionInfo()) {
+    DecisionProfile d;
+    d.invocations = info.invocations;
+    d.llFallbacks = info.LL_Fallback;
+    d.ambiguities = info.ambiguities.size();
+    d.contextSensitivities = info.contextSensitivities.size();
+    d.sllLookahead = info.SLL_TotalLook;
+    d.llLookahead = info.LL_TotalLook;
+    d.sllMaxLookahead = info.SLL_MaxLook;
+    d.llMaxLookahead = info.LL_MaxLook;
+    d.nanoseconds = info.timeInPrediction;
+    DecisionProfile& total = profile[info.decision];
+    total.decision = info.decision;
+    total.rule = parser.getRuleNames()[atn.getDecisionState(info.decision)->ruleIndex];
+    total.add(d);
+  }
+}
+
+/**
+ * @brief The lexer, tokens and parse tree of one slice of the input.
+ *  The parse tree points into the rest, so they live as long as it does.
+ */
+struct ParsedSlice {
+  std::unique_ptr<MappedInputStream> input;
+  std::unique_ptr<WPLLexer> lexer;
+  std::unique_ptr<WPLFastLexer> fastLexer;
+  std::unique_ptr<SliceTokenSource> tokenSource;
+  std::unique_ptr<antlr4::CommonTokenStream> tokens;
+  std::unique_ptr<WPLParser> parser;
+  WPLSyntaxErrorListener syntaxErrors;
+  WPLParser::CompilationUnitContext* tree = nullptr;
+};
+
+/**
+ * @brief Parse one slice with a lexer and parser of its own. Runs on a
+ *  worker thread; the parsers of all slices share the ATN and DFA of
+ *  WPLParser, which ANTLR guards with its own locks. False if the slice
+ *  has a syntax error or does not end on a token boundary.
+ */
+static bool parseSlice(const CompileJob& job, llvm::StringRef source, const InputSlice& slice,
+    ParsedSlice& parsed) {
+  ThreadTimeTrace threadTrace(job);
+  llvm::TimeTraceScope scope("Parse slice", job.inputFileName);
+  parsed.input = std::make_unique<MappedInputStream>(source, job.inputFileName);
+  parsed.lexer = std::make_unique<WPLLexer>(parsed.input.get());
+  parsed.lexer->removeErrorListeners();
+  antlr4::TokenSource* tokenSource = parsed.lexer.get();
+  if (job.lexer == LexerKind::FAST) {
+    parsed.fastLexer = std::make_unique<WPLFastLexer>(source, parsed.input.get(), parsed.lexer->getVocabulary());
+    parsed.fastLexer->seek(slice.begin, slice.line, slice.column);
+    parsed.fastLexer->addErrorListener(&parsed.syntaxErrors);
+    tokenSource = parsed.fastLexer.get();
+  } else {
+    parsed.input->seek(slice.begin);
+    parsed.lexer->setLine(slice.line);
+    parsed.lexer->setCharPositionInLine(slice.column);
+    parsed.lexer->addErrorListener(&parsed.syntaxErrors);
+  }
+  parsed.tokenSource = std::make_unique<SliceTokenSource>(tokenSource, slice, source.size());
+  parsed.tokens = std::make_unique<antlr4::CommonTokenStream>(parsed.tokenSource.get());
+  parsed.parser = std::make_unique<WPLParser>(parsed.tokens.get());
+  parsed.parser->removeErrorListeners();
+  parsed.tree = parseCompilationUnit(*parsed.parser, parsed.syntaxErrors, job.parser, job.profileParser);
+  return !parsed.syntaxErrors.hasErrors() && parsed.tokenSource->endsOnTokenBoundary();
+}
+
+std::unique_ptr<ast::Tree> WPLCompiler::parseComponent(const CompileJob& job, llvm::StringRef source,
+    const InputSlice& slice, std::shared_ptr<ast::NameTable> names,
+    std::vector<SyntaxError>& syntaxErrors) {
+  ParsedSlice parsed;
+  if (!parseSlice(job, source, slice, parsed)) {
+    std::vector<SyntaxError>& found = parsed.syntaxErrors.getErrors();
+    syntaxErrors.insert(syntaxErrors.end(), found.begin(), found.end());
+    return nullptr;
+  }
+  return ASTLowering::lower(parsed.tree, std::move(names), source);
+}
+
+/**
+ * @brief Split ASCII input into slices of whole components, parse them
+ *  on a thread pool and lower the parse trees to one AST in source
+ *  order. Tokens keep their positions in the whole input, so spans and
+ *  error positions are the same as for a parse in one piece. Returns
+ *  nullptr if the input is too small to split or any slice fails; the
+ *  caller then parses it in one piece, which reports any syntax errors.
+ */
+static std::unique_ptr<ast::Tree> parseSlices(const CompileJob& job, CompileResult& result,
+    llvm::StringRef source) {
+  std::vector<ParsedSlice> parsed;
+  {
+    PhaseTimer timer(result, "Parse slices");
+    llvm::ThreadPool pool(llvm::hardware_concurrency(job.parseThreads));
+    // A few slices per thread even out components of different sizes
+    std::vector<InputSlice> slices = InputSlicer::split(source, pool.getThreadCount() * 4);
+    if (slices.size() < 2) {
+      return nullptr;
+    }
+    parsed.resize(slices.size());
+    std::vector<char> ok(slices.size());
+    std::vector<AllocationCounts> sliceCounts(slices.size());
+    for (size_t i = 0; i < slices.size(); i++) {
+      pool.async([&, i] {
+        AllocationCounts start = MemoryAccounting::threadCounts();
+        ok[i] = parseSlice(job, source, slices[i], parsed[i]);
+        sliceCounts[i] = MemoryAccounting::threadCountsSince(start);
+      });
+    }
+    pool.wait();
+    for (AllocationCounts& counts : sliceCounts) {
+      timer.addWorkerCounts(counts);
+    }
+    for (char sliceOk : ok) {
+      if (!sliceOk) {
+        return nullptr;
+      }
+    }
+  }
+  if (job.profileParser) {
+    for (ParsedSlice& p : parsed) {
+      addParserProfile(*p.parser, result.parserProfile);
+    }
+  }
+  PhaseTimer timer(result, "Lower");
+  std::vector<WPLParser::CompilationUnitContext*> units;
+  for (ParsedSlice& p : parsed) {
+    units.push_back(p.tree);
+  }
+  return ASTLowering::lower(units, nullptr, source);
+}
+
+/**
+ * @brief Lex and parse the input and lower the parse tree to the AST.
+ *  The lexer, the token stream and the parse tree are local to this
+ *  function, so they are freed as soon as the AST has been built.
+ *  Returns nullptr, with the diagnostics in result, if the input has a
+ *  syntax error.
+ */
+static std::unique_ptr<ast::Tree> parse(const CompileJob& job, CompileResult& result,
+    llvm::StringRef source, antlr4::CharStream* input, bool ascii) {
+  if (ascii && job.parseThreads != 1 && job.lexer != LexerKind::VERIFY
+      && job.parser != ParserKind::VERIFY) {
+    std::unique_ptr<ast::Tree> tree = parseSlices(job, result, source);
+    if (tree) {
+      return tree;
+    }
+  }
+  WPLSyntaxErrorListener syntaxErrors;
+  WPLSyntaxErrorListener lexerErrors;    // only used by -lexer=verify
+  WPLLexer lexer(input);
+  lexer.removeErrorListeners();
+  std::unique_ptr<WPLFastLexer> fastLexer;
+  if (ascii && job.lexer != LexerKind::ANTLR) {
+    fastLexer = std::make_unique<WPLFastLexer>(source, input, lexer.getVocabulary());
+    fastLexer->addErrorListener(&syntaxErrors);
+    lexer.addErrorListener(&lexerErrors);
+  } else {
+    lexer.addErrorListener(&syntaxErrors);
+  }
+  antlr4::TokenSource* tokenSource = &lexer;
+  if (fastLexer) {
+    tokenSource = fastLexer.get();
+  }
+  antlr4::CommonTokenStream tokens(tokenSource);
+  {
+    // Lex everything up front so that lexing and parsing are timed apart
+    PhaseTimer timer(result, "Lex");
+    tokens.fill();
+  }
+  if (fastLexer && job.lexer == LexerKind::VERIFY) {
+    std::string mismatch = compareLexers(lexer, lexerErrors, tokens, syntaxErrors);
+    if (!mismatch.empty()) {
+      result.diagnostics = mismatch + "\n";
+      return nullptr;
+    }
+  }
+
+  WPLParser parser(&tokens);
+  parser.removeErrorListeners();
+  WPLParser::CompilationUnitContext* tree;
+  {
+    PhaseTimer timer(result, "Parse");
+    tree = parseCompilationUnit(parser, syntaxErrors, job.parser, job.profileParser);
+  }
+  if (job.profileParser) {
+    addParserProfile(parser, result.parserProfile);
+  }
+  if (syntaxErrors.hasErrors()) {
+    result.diagnostics = syntaxErrors.errorList();
+    return nullptr;
+  }
+  if (job.parser == ParserKind::VERIFY) {
+    std::string mismatch = compareParsers(tree, tokens);
+    if (!mismatch.empty()) {
+      result.diagnostics = mismatch + "\n";
+      return nullptr;
+    }
+  }
+
+  // Identifiers are read from the source bytes when the input is ASCII,
+  // where token indexes are byte offsets
+  PhaseTimer timer(result, "Lower");
+  return ASTLowering::lower(tree, nullptr, ascii ? source : llvm::StringRef());
+}
+
+/**
+ * @brief How a streaming compile ended. On SYNTAX_ERROR nothing has been
+ *  reported yet; the whole input is parsed again to report the errors
+ *  with the same messages as a normal compile.
+ */
+enum class StreamStatus {
+  DONE,
+  FAILED,
+  SYNTAX_ERROR
+};
+
+/**
+ * @brief Run the default LLVM pipeline of the level on the module, as
+ *  opt -O1, -O2 or -O3 would. Nothing is run at O0. The passes assume
+ *  valid IR, which the code generator does not build for every program
+ *  that passes the semantic checks, so the module is verified first.
+ *
+ * @return false, with the verifier's complaint in error, if it is invalid
+ */
+static bool optimize(llvm::Module* module, OptLevel level, std::string& error) {
+  if (level == OptLevel::O0) {
+    return true;
+  }
+  llvm::TimeTraceScope timeScope("Optimize");
+  std::string problem;
+  llvm::raw_string_ostream problemStream(problem);
+  if (llvm::verifyModule(*module, &problemStream)) {
+    problemStream.flush();
+    error = "cannot optimize invalid IR: " + llvm::StringRef(problem).rtrim().str();
+    return false;
+  }
+  llvm::LoopAnalysisManager loops;
+  llvm::FunctionAnalysisManager functions;
+  llvm::CGSCCAnalysisManager sccs;
+  llvm::ModuleAnalysisManager modules;
+  llvm::PassBuilder builder;
+  builder.registerModuleAnalyses(modules);
+  builder.registerCGSCCAnalyses(sccs);
+  builder.registerFunctionAnalyses(functions);
+  builder.registerLoopAnalyses(loops);
+  builder.crossRegisterProxies(loops, functions, sccs, modules);
+  llvm::OptimizationLevel o = level == OptLevel::O1 ? llvm::OptimizationLevel::O1
+    : level == OptLevel::O2 ? llvm::OptimizationLevel::O2 : llvm::OptimizationLevel::O3;
+  llvm::ModulePassManager passes = builder.buildPerModuleDefaultPipeline(o);
+  passes.run(*module, modules);
+  return true;
+}
+
+/**
+ * @brief List the procedures and functions of the call graph, for
+ *  -call-graph-report.
+ */
+static void reportCallGraph(const ::CallGraph& calls, CompileResult& result) {
+  for (ast::Identifier id : calls.getRoutines()) {
+    RoutineReach r;
+    r.name = id.text().str();
+    r.reachable = calls.isReachable(id);
+    r.callSites = calls.callSites(id);
+    r.calls = calls.callsFrom(id);
+    result.callGraph.push_back(r);
+  }
+}
+
+/**
+ * @brief The tables that the semantic check fills in for a tree, and the
+ *  code generator that reads them. The code is bound to symbols that
+ *  live in stm, so stm outlives the module.
+ */
+struct Backend {
+  STManager stm;
+  PropertyManager pm;
+  ::CallGraph calls;
+  std::unique_ptr<CodegenVisitor> cv;
+};
+
+/**
+ * @brief Compile ASCII input one top-level component at a time. Each
+ *  component gets its own token stream, parser and AST, which are freed
+ *  once the component has been checked and its code generated, so only
+ *  the global symbols and the module grow with the input. Semantic
+ *  errors stop code generation but not the checking of the remaining
+ *  components, as in a normal compile.
+ */
+static StreamStatus compileStream(const CompileJob& job, CompileResult& result,
+    llvm::StringRef source, antlr4::CharStream* input, std::string& ir) {
+  PhaseTimer timer(result, "Stream");
+  WPLSyntaxErrorListener syntaxErrors;
+  WPLLexer lexer(input);
+  lexer.removeErrorListeners();
+  std::unique_ptr<WPLFastLexer> fastLexer;
+  antlr4::TokenSource* tokenSource = &lexer;
+  if (job.lexer != LexerKind::ANTLR) {
+    fastLexer = std::make_unique<WPLFastLexer>(source, input, lexer.getVocabulary());
+    fastLexer->addErrorListener(&syntaxErrors);
+    tokenSource = fastLexer.get();
+  } else {
+    lexer.addErrorListener(&syntaxErrors);
+  }
+  ComponentTokenSource components(tokenSource);
+
+  STManager stm;
+  PropertyManager pm;
+  SemanticVisitor sv(&stm, &pm);
+  CodegenVisitor cv(&pm, "WPLC.ll");
+  ::CallGraph calls;
+  sv.setCallGraph(&calls);
+  sv.setErrorLimit(job.errorLimit);
+  cv.setErrorLimit(job.errorLimit);
+  sv.beginCompilationUnit();
+  cv.beginModule();
+  // The global symbols outlive the component trees, so all the trees
+  // intern their identifiers in one table
+  std::shared_ptr<ast::NameTable> names = std::make_shared<ast::NameTable>();
+  bool any = false;
+  while (!sv.errorLimitReached() && !cv.errorLimitReached() && components.nextComponent()) {
+    any = true;
+    std::unique_ptr<ast::Tree> tree;
+    {
+      antlr4::CommonTokenStream tokens(&components);
+      WPLParser parser(&tokens);
+      parser.removeErrorListeners();
+      WPLParser::CompilationUnitContext* ctx = parseCompilationUnit(parser, syntaxErrors, job.parser, job.profileParser);
+      if (job.profileParser) {
+        addParserProfile(parser, result.parserProfile);
+      }
+      if (syntaxErrors.hasErrors()) {
+        return StreamStatus::SYNTAX_ERROR;
+      }
+      tree = ASTLowering::lower(ctx, names, source);
+    }
+    ast::Node* component = tree->root->components[0];
+    pm.reserve(tree->size());
+    sv.visitComponent(component);
+    if (!sv.hasErrors()) {
+      cv.visitComponent(component);
+    }
+    // The errors point into the tree, which goes now
+    sv.keepErrorText();
+    cv.keepErrorText();
+    pm.clear();
+  }
+  if (!any) {
+    return StreamStatus::SYNTAX_ERROR;
+  }
+  if (sv.hasErrors()) {
+    result.diagnostics = sv.getErrors();
+    return StreamStatus::FAILED;
+  }
+  if (cv.hasErrors()) {
+    result.diagnostics = cv.getErrors();
+    return StreamStatus::FAILED;
+  }
+  // Which routines program reaches is only known now, so the code of
+  // the others comes out again
+  calls.findReachable();
+  if (job.callGraphReport) {
+    reportCallGraph(calls, result);
+  }
+  cv.removeUnused(&calls, job.keepUnused);
+  if (!optimize(cv.getModule(), job.optLevel, result.diagnostics)) {
+    return StreamStatus::FAILED;
+  }
+  llvm::raw_string_ostream irStream(ir);
+  cv.getModule()->print(irStream, nullptr);
+  irStream.flush();
+  return StreamStatus::DONE;
+}
+
+/**
+ * @brief Store the IR of a successful compile in the cache and write it out.
+ *  The cache is trimmed once here, after this compile's last store.
+ */
+static void finish(const CompileJob& job, CompileResult& result, CompileCache* cache,
+    const std::string& cacheKey, const std::string& ir) {
+  if (cache) {
+    PhaseTimer timer(result, "Cache store");
+    cache->store(cacheKey, ir);
+    cache->evict();
+  }
+  PhaseTimer timer(result, "Write output");
+  emitOutput(job, ir, result);
+}
+
+CompileResult WPLCompiler::compile(const CompileJob& job) {
+  CompileResult result;
+  result.inputName = job.inputFileName;
+  ThreadTimeTrace threadTrace(job);
+  llvm::TimeTraceScope compileScope("Compile", result.inputName);
+
+  // Files are memory-mapped when they are large enough to be worth it
+  std::unique_ptr<llvm::MemoryBuffer> buffer;
+  {
+    PhaseTimer timer(result, "Read source");
+    if (job.inputFileName != "-") {
+      llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> file =
+        llvm::MemoryBuffer::getFile(job.inputFileName, false, false);
+      if (!file) {
+        result.diagnostics = "cannot open input file " + job.inputFileName;
+        return result;
+      }
+      buffer = std::move(*file);
+    } else {
+      buffer = llvm::MemoryBuffer::getMemBuffer(job.inputString, "<string>", false);
+    }
+  }
+  llvm::StringRef source = buffer->getBuffer();
+
+  // A cache hit skips the whole pipeline, so a job that reports the call
+  // graph does not look
+  std::unique_ptr<CompileCache> cache;
+  std::string cacheKey;
+  if (!job.cacheDir.empty()) {
+    PhaseTimer timer(result, "Cache lookup");
+    cache = std::make_unique<CompileCache>(job.cacheDir, job.cacheSizeLimit);
+    cacheKey = CompileCache::key(source, job);
+    std::string ir;
+    if (!job.callGraphReport && cache->lookup(cacheKey, ir)) {
+      result.cacheHit = true;
+      emitOutput(job, ir, result);
+      return result;
+    }
+  }
+
+  /******************************************************************
+   * 1. Create the lexer from the input.
+   * 2. Create the parser with the lexer's token stream as input.
+   * 3. Parse the input and lower the parse tree to the AST.
+   * Syntax errors are gathered rather than printed so that they do
+   * not interleave with those of other inputs. ASCII input is lexed
+   * from the buffer in place, by the fast lexer unless -lexer=antlr;
+   * anything else is decoded by ANTLRInputStream so that token
+   * positions count code points.
+   ******************************************************************/
+  std::unique_ptr<antlr4::CharStream> input;
+  bool ascii = MappedInputStream::isASCII(source);
+  if (ascii) {
+    input = std::make_unique<MappedInputStream>(source, job.inputFileName);
+  } else {
+    input = std::make_unique<antlr4::ANTLRInputStream>(std::string_view(source.data(), source.size()));
+  }
+  // Incremental builds need every component at once, and -lexer=verify
+  // and -parser=verify compare whole token streams and parse trees, so
+  // none of them can stream
+  if (job.stream && ascii && !job.incremental && job.lexer != LexerKind::VERIFY
+      && job.parser != ParserKind::VERIFY) {
+    std::string ir;
+    StreamStatus status = compileStream(job, result, source, input.get(), ir);
+    if (status == StreamStatus::DONE) {
+      finish(job, result, cache.get(), cacheKey, ir);
+      return result;
+    }
+    if (status == StreamStatus::FAILED) {
+      return result;
+    }
+    // The whole input is parsed again to report the syntax errors, and
+    // the ANTLR lexer reads on from wherever streaming stopped
+    input->seek(0);
+  }
+  std::unique_ptr<ast::Tree> tree = parse(job, result, source, input.get(), ascii);
+  if (!tree) {
+    return result;
+  }
+
+  std::unique_ptr<IncrementalBuild> incremental;
+  if (cache && job.incremental) {
+    PhaseTimer timer(result, "Fingerprint");
+    incremental = std::make_unique<IncrementalBuild>(cache.get());
+    incremental->fingerprint(input.get(), tree->root);
+  }
+
+  /******************************************************************
+   * Perform semantic analysis and populate the symbol table
+   * and bind nodes to Symbols using the property manager, then
+   * generate the LLVM IR code. Both run again on the same tree, from
+   * new tables, when the parallel check finds that the unit has to be
+   * checked in order, and when the cached IR of an incremental build
+   * cannot be spliced in. The phases of every run are reported.
+   ******************************************************************/
+  std::unique_ptr<Backend> backend;
+  unsigned semanticThreads = job.semanticThreads;
+  while (true) {
+    backend = std::make_unique<Backend>();
+    backend->pm.reserve(tree->size());
+    SemanticVisitor sv(&backend->stm, &backend->pm);
+    sv.setCallGraph(&backend->calls);
+    if (incremental) {
+      sv.setReusedComponents(incremental->reusedComponents());
+    }
+    sv.setThreads(semanticThreads);
+    sv.setErrorLimit(job.errorLimit);
+    {
+      PhaseTimer timer(result, "Semantic");
+      sv.visitCompilationUnit(tree->root);
+      timer.addWorkerCounts(sv.getWorkerAllocations());
+    }
+    if (sv.needsSequentialCheck()) {
+      semanticThreads = 1;
+      continue;
+    }
+    if (sv.hasErrors()) {
+      result.diagnostics = sv.getErrors();
+      return result;
+    }
+    backend->calls.findReachable();
+    if (job.callGraphReport) {
+      result.callGraph.clear();
+      reportCallGraph(backend->calls, result);
+    }
+
+    backend->cv = std::make_unique<CodegenVisitor>(&backend->pm, "WPLC.ll");
+    CodegenVisitor& cv = *backend->cv;
+    cv.setErrorLimit(job.errorLimit);
+    cv.setCallGraph(&backend->calls, job.keepUnused);
+    if (incremental) {
+      cv.setReusedComponents(incremental->reusedComponents());
+    }
+    {
+      PhaseTimer timer(result, "Codegen");
+      cv.visitCompilationUnit(tree->root);
+    }
+    if (cv.hasErrors()) {
+      result.diagnostics = cv.getErrors();
+      return result;
+    }
+
+    if (incremental) {
+      PhaseTimer timer(result, "Splice");
+      std::string error;
+      if (!incremental->splice(cv.getModule(), &backend->calls, error)) {
+        // The cached IR is unusable, so check and generate everything
+        incremental.reset();
+        continue;
+      }
+      incremental->store(cv.getModule());
+      result.reusedComponents = incremental->reusedCount();
+      result.componentCount = incremental->componentCount();
+    }
+    break;
+  }
+  CodegenVisitor& cv = *backend->cv;
+
+  // After the store, so the cache holds each function as generated;
+  // inlining makes an optimized one depend on its callees
+  if (job.optLevel != OptLevel::O0) {
+    PhaseTimer timer(result, "Optimize");
+    if (!optimize(cv.getModule(), job.optLevel, result.diagnostics)) {
+      return result;
+    }
+  }
+
+  std::string ir;
+  {
+    PhaseTimer timer(result, "Print IR");
+    llvm::raw_string_ostream irStream(ir);
+    cv.getModule()->print(irStream, nullptr);
+    irStream.flush();
+  }
+  finish(job, result, cache.get(), cacheKey, ir);
+  return result;
+}
@@ -0,0 +1,517 @@
+/**
+ * @file WPLFastLexer.cpp
+ * @author nllopez
+ * @brief Implementation of the hand-written WPL lexer.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "WPLFastLexer.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/ErrorHandling.h"
+#include <algorithm>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static bool isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f';
+}
+
+static bool isLetter(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+static bool isIdentifierChar(char c) {
+  return isLetter(c) || isDigit(c) || c == '_';
+}
+
+#ifdef __SSE2__
+// Mask of the bytes of v in [lo, hi]. The input is ASCII, so the signed
+// byte compares are safe.
+static __m128i inRange(__m128i v, char lo, char hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+    _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), v));
+}
+#endif
+
+/**
+ * @brief The first character at or after p that is not whitespace.
+ */
+static const char* skipWhitespace(const char* p, const char* end) {
+#ifdef __SSE2__
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i ws = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+      _mm_or_si128(inRange(v, '\t', '\r'), _mm_cmpeq_epi8(v, _mm_set1_epi8('\f'))));
+    unsigned mask = ~_mm_movemask_epi8(ws) & 0xffff;
+    if (mask) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 16;
+  }
+#endif
+  while (p < end && isWhitespace(*p)) {
+    p++;
+  }
+  return p;
+}
+
+/**
+ * @brief The first character at or after p that cannot be part of an ID.
+ */
+static const char* skipIdentifier(const char* p, const char* end) {
+#ifdef __SSE2__
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i id = _mm_or_si128(
+      _mm_or_si128(inRange(lower, 'a', 'z'), inRange(v, '0', '9')),
+      _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+    unsigned mask = ~_mm_movemask_epi8(id) & 0xffff;
+    if (mask) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 16;
+  }
+#endif
+  while (p < end && isIdentifierChar(*p)) {
+    p++;
+  }
+  return p;
+}
+
+/**
+ * @brief The first occurrence of a, b or c at or after p, or end.
+ */
+static const char* findAny(const char* p, const char* end, char a, char b, char c) {
+#ifdef __SSE2__
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i hit = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(a)), _mm_cmpeq_epi8(v, _mm_set1_epi8(b))),
+      _mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+    unsigned mask = _mm_movemask_epi8(hit);
+    if (mask) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 16;
+  }
+#endif
+  while (p < end && *p != a && *p != b && *p != c) {
+    p++;
+  }
+  return p;
+}
+
+/**
+ * @brief The first occurrence of a or b at or after p, or end.
+ */
+static const char* findAny(const char* p, const char* end, char a, char b) {
+#ifdef __SSE2__
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(a)), _mm_cmpeq_epi8(v, _mm_set1_epi8(b)));
+    unsigned mask = _mm_movemask_epi8(hit);
+    if (mask) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 16;
+  }
+#endif
+  while (p < end && *p != a && *p != b) {
+    p++;
+  }
+  return p;
+}
+
+WPLFastLexer::WPLFastLexer(llvm::StringRef buffer, antlr4::CharStream* input,
+    const antlr4::dfa::Vocabulary& vocabulary)
+  : data(buffer), input(input), tables(tablesFor(vocabulary)) {}
+
+/**
+ * @brief The tables of the only vocabulary there is, WPLLexer's. They
+ *  are built by the first lexer and then shared between threads.
+ */
+const WPLFastLexer::Tables& WPLFastLexer::tablesFor(const antlr4::dfa::Vocabulary& vocabulary) {
+  static const Tables tables(vocabulary);
+  return tables;
+}
+
+WPLFastLexer::Tables::Tables(const antlr4::dfa::Vocabulary& vocabulary) {
+  idType = integerType = booleanType = stringType = antlr4::Token::INVALID_TYPE;
+  for (size_t type = 1; type <= vocabulary.getMaxTokenType(); type++) {
+    std::string symbol(vocabulary.getSymbolicName(type));
+    if (symbol == "ID") {
+      idType = type;
+    } else if (symbol == "INTEGER") {
+      integerType = type;
+    } else if (symbol == "BOOLEAN") {
+      booleanType = type;
+    } else if (symbol == "STRING") {
+      stringType = type;
+    }
+
+    std::string literal(vocabulary.getLiteralName(type));
+    if (literal.size() < 3) {
+      continue;
+    }
+    literal = literal.substr(1, literal.size() - 2);
+    if (isLetter(literal[0]) && std::all_of(literal.begin(), literal.end(), isIdentifierChar)) {
+      keywords.push_back({literal, type});
+    } else if (static_cast<unsigned char>(literal[0]) < 128) {
+      literals[static_cast<unsigned char>(literal[0])].push_back({literal, type});
+    }
+  }
+  // BOOLEAN has two literals, so the vocabulary does not name them
+  keywords.push_back({"true", booleanType});
+  keywords.push_back({"false", booleanType});
+  buildKeywordTable();
+
+  // Maximal munch: try the longer operators first
+  for (std::vector<Literal>& group : literals) {
+    std::stable_sort(group.begin(), group.end(), [](const Literal& a, const Literal& b) {
+      return a.text.size() > b.text.size();
+    });
+  }
+}
+
+/**
+ * @brief The length and the first, second and last characters of a
+ *  candidate keyword, which tell the WPL keywords apart.
+ */
+uint32_t WPLFastLexer::Tables::keywordFeatures(const char* p, size_t length) {
+  return static_cast<uint32_t>(length) ^ (static_cast<uint32_t>(p[0]) << 8) ^
+    (static_cast<uint32_t>(length > 1 ? p[1] : 0) << 16) ^ (static_cast<uint32_t>(p[length - 1]) << 24);
+}
+
+/**
+ * @brief Find a multiplier that sends every keyword to its own slot.
+ *  The table is at least twice as large as the keyword list, so a seed
+ *  is usually found in a few hundred tries.
+ */
+void WPLFastLexer::Tables::buildKeywordTable() {
+  std::vector<Keyword> list;
+  list.swap(keywords);
+  for (unsigned bits = 4; bits <= 16; bits++) {
+    if ((1u << bits) < 2 * list.size()) {
+      continue;
+    }
+    uint32_t seed = 0x9e3779b1;
+    for (unsigned attempt = 0; attempt < 100000; attempt++, seed += 0x6a09e668) {
+      seed |= 1;
+      std::vector<Keyword> table(1u << bits);
+      bool perfect = true;
+      for (Keyword& k : list) {
+        Keyword& slot = table[(keywordFeatures(k.text.data(), k.text.size()) * seed) >> (32 - bits)];
+        if (slot.type != 0) {
+          perfect = false;
+          break;
+        }
+        slot = k;
+      }
+      if (perfect) {
+        keywords.swap(table);
+        keywordSeed = seed;
+        keywordShift = 32 - bits;
+        return;
+      }
+    }
+  }
+  llvm::report_fatal_error("the WPL keywords have no perfect hash");
+}
+
+size_t WPLFastLexer::Tables::keywordType(const char* p, size_t length) const {
+  const Keyword& k = keywords[(keywordFeatures(p, length) * keywordSeed) >> keywordShift];
+  if (k.type != 0 && k.text.size() == length && std::memcmp(k.text.data(), p, length) == 0) {
+    return k.type;
+  }
+  return idType;
+}
+
+/**
+ * @brief Match an operator or delimiter. Returns its length, or 0 and
+ *  sets dieLength to the number of characters that are a prefix of some
+ *  literal, which is where ANTLR would stop.
+ */
+size_t WPLFastLexer::matchLiteral(size_t start, size_t& type, size_t& dieLength) {
+  const std::vector<Literal>& group = tables.literals[static_cast<unsigned char>(data[start])];
+  llvm::StringRef rest = data.substr(start);
+  dieLength = 0;
+  for (const Literal& l : group) {
+    if (rest.startswith(l.text)) {
+      type = l.type;
+      return l.text.size();
+    }
+    size_t common = 0;
+    while (common < rest.size() && common < l.text.size() && rest[common] == l.text[common]) {
+      common++;
+    }
+    dieLength = std::max(dieLength, common);
+  }
+  return 0;
+}
+
+/**
+ * @brief STRING : '"' ('\\'. | ~[\n])*? '"' ;
+ *  The loop is non-greedy and ~[\n] also matches '"' and '\', so a
+ *  string may end at an escaped quote and go on to a later one. The
+ *  ATN configurations are replayed in ANTLR's order: once a config
+ *  reaches the end of the rule, the configs after it that passed
+ *  through the non-greedy loop are dropped. Returns the end of the
+ *  longest accepted string or 0, with dieIndex set to where ANTLR
+ *  would report the error.
+ */
+size_t WPLFastLexer::matchString(size_t start, size_t& dieIndex) {
+  enum Kind : uint8_t { EXIT, ESCAPE, ANY, ESCAPED, ACCEPT };
+  llvm::SmallVector<Kind, 8> configs = {EXIT, ESCAPE, ANY};
+  llvm::SmallVector<Kind, 8> reach;
+  auto add = [&reach](Kind k) {
+    if (std::find(reach.begin(), reach.end(), k) == reach.end()) {
+      reach.push_back(k);
+    }
+  };
+  auto addLoop = [&add]() {
+    add(EXIT);
+    add(ESCAPE);
+    add(ANY);
+  };
+
+  size_t accept = 0;
+  size_t i = start + 1;
+  for (;; i++) {
+    if (configs.size() == 3 && configs[0] == EXIT && configs[1] == ESCAPE && configs[2] == ANY) {
+      // Nothing but '"', '\' and '\n' leaves the loop state
+      i = findAny(data.begin() + i, data.end(), '"', '\\', '\n') - data.begin();
+    }
+    if (i == data.size()) {
+      break;
+    }
+    char c = data[i];
+    reach.clear();
+    bool accepted = false;
+    for (Kind k : configs) {
+      if (accepted) {
+        break;
+      }
+      if (k == EXIT && c == '"') {
+        add(ACCEPT);
+        accepted = true;
+      } else if (k == ESCAPE && c == '\\') {
+        add(ESCAPED);
+      } else if ((k == ANY && c != '\n') || k == ESCAPED) {
+        addLoop();
+      }
+    }
+    if (accepted) {
+      accept = i + 1;
+    }
+    if (reach.empty() || (reach.size() == 1 && accepted)) {
+      break;
+    }
+    configs.swap(reach);
+  }
+  dieIndex = i;
+  return accept;
+}
+
+/**
+ * @brief STD_COMMENT : '(*' (STD_COMMENT | .)*? '*)' ;
+ *  Replays the ATN configurations like matchString, with the nesting
+ *  depth standing in for the rule invocation stack. start is the index
+ *  of the '('. Returns the end of the longest accepted comment or 0.
+ */
+size_t WPLFastLexer::matchComment(size_t start) {
+  // OPEN expects the '*' of '(*', EXIT the '*' of '*)', CLOSE its ')'
+  // NEST the '(' of a nested comment and ANY the loop's wildcard
+  enum Kind : uint8_t { OPEN, EXIT, CLOSE, NEST, ANY, ACCEPT };
+  struct Config {
+    Kind kind;
+    unsigned depth;
+    bool operator==(const Config& other) const { return kind == other.kind && depth == other.depth; }
+  };
+  llvm::SmallVector<Config, 16> configs = {{OPEN, 1}};
+  llvm::SmallVector<Config, 16> reach;
+  auto add = [&reach](Kind k, unsigned depth) {
+    Config config = {k, depth};
+    if (std::find(reach.begin(), reach.end(), config) == reach.end()) {
+      reach.push_back(config);
+    }
+  };
+  auto addLoop = [&add](unsigned depth) {
+    add(EXIT, depth);
+    add(NEST, depth + 1);
+    add(ANY, depth);
+  };
+
+  size_t accept = 0;
+  bool looping = false;
+  for (size_t i = start + 1;; i++) {
+    if (looping) {
+      // Only '*' and '(' change a set of loop states
+      i = findAny(data.begin() + i, data.end(), '*', '(') - data.begin();
+    }
+    if (i == data.size()) {
+      break;
+    }
+    char c = data[i];
+    reach.clear();
+    bool accepted = false;
+    for (const Config& config : configs) {
+      if (accepted) {
+        break;
+      }
+      switch (config.kind) {
+        case OPEN:
+          if (c == '*') {
+            addLoop(config.depth);
+          }
+          break;
+        case EXIT:
+          if (c == '*') {
+            add(CLOSE, config.depth);
+          }
+          break;
+        case CLOSE:
+          if (c == ')') {
+            if (config.depth == 1) {
+              add(ACCEPT, 0);
+              accepted = true;
+            } else {
+              addLoop(config.depth - 1);
+            }
+          }
+          break;
+        case NEST:
+          if (c == '(') {
+            add(OPEN, config.depth);
+          }
+          break;
+        case ANY:
+          addLoop(config.depth);
+          break;
+        case ACCEPT:
+          break;
+      }
+    }
+    if (accepted) {
+      accept = i + 1;
+    }
+    if (reach.empty() || (reach.size() == 1 && accepted)) {
+      break;
+    }
+    configs.swap(reach);
+    looping = std::all_of(configs.begin(), configs.end(), [](const Config& config) {
+      return config.kind == EXIT || config.kind == NEST || config.kind == ANY;
+    });
+  }
+  return accept;
+}
+
+/**
+ * @brief Move to index, keeping the line and column up to date.
+ */
+void WPLFastLexer::advanceTo(size_t index) {
+  const char* p = data.begin() + pos;
+  const char* end = data.begin() + index;
+  while (const void* newline = std::memchr(p, '\n', end - p)) {
+    line++;
+    column = 0;
+    p = static_cast<const char*>(newline) + 1;
+  }
+  column += end - p;
+  pos = index;
+}
+
+/**
+ * @brief Report a token recognition error the way Lexer does and skip
+ *  past the character that could not be matched.
+ */
+void WPLFastLexer::reportError(size_t start, size_t startLine, size_t startColumn, size_t dieIndex) {
+  std::string text = input->getText(antlr4::misc::Interval(start, dieIndex));
+  std::string display;
+  for (char c : text) {
+    switch (c) {
+      case '\n':
+        display += "\\n";
+        break;
+      case '\t':
+        display += "\\t";
+        break;
+      case '\r':
+        display += "\\r";
+        break;
+      default:
+        display += c;
+        break;
+    }
+  }
+  std::string msg = "token recognition error at: '" + display + "'";
+  for (antlr4::ANTLRErrorListener* listener : listeners) {
+    listener->syntaxError(nullptr, nullptr, startLine, startColumn, msg, nullptr);
+  }
+  advanceTo(std::min(dieIndex + 1, data.size()));
+}
+
+std::unique_ptr<antlr4::Token> WPLFastLexer::nextToken() {
+  const char* begin = data.begin();
+  const char* end = data.end();
+  while (pos < data.size()) {
+    size_t start = pos;
+    size_t startLine = line;
+    size_t startColumn = column;
+    char c = data[pos];
+    size_t type = antlr4::Token::INVALID_TYPE;
+    size_t stop = 0;    // one past the token
+    size_t dieIndex = start;
+
+    if (isWhitespace(c)) {
+      advanceTo(skipWhitespace(begin + pos, end) - begin);
+      continue;
+    } else if (isLetter(c)) {
+      stop = skipIdentifier(begin + pos + 1, end) - begin;
+      type = tables.keywordType(begin + start, stop - start);
+    } else if (isDigit(c)) {
+      stop = start + 1;
+      while (stop < data.size() && isDigit(data[stop])) {
+        stop++;
+      }
+      type = tables.integerType;
+    } else if (c == '"') {
+      stop = matchString(start, dieIndex);
+      type = tables.stringType;
+    } else if (c == '#') {
+      // INLINE_COMMENT : '#' .*? ('\n'|EOF)
+      const void* newline = std::memchr(begin + pos, '\n', data.size() - pos);
+      advanceTo(newline ? static_cast<const char*>(newline) - begin + 1 : data.size());
+      continue;
+    } else {
+      if (c == '(' && start + 1 < data.size() && data[start + 1] == '*') {
+        size_t comment = matchComment(start);
+        if (comment != 0) {
+          advanceTo(comment);
+          continue;
+        }
+      }
+      size_t dieLength;
+      size_t length = matchLiteral(start, type, dieLength);
+      stop = length ? start + length : 0;
+      dieIndex = start + dieLength;
+    }
+
+    if (stop == 0) {
+      reportError(start, startLine, startColumn, dieIndex);
+      continue;
+    }
+    advanceTo(stop);
+    return getTokenFactory()->create({this, input}, type, "", antlr4::Token::DEFAULT_CHANNEL,
+      start, stop - 1, startLine, startColumn);
+  }
+  return getTokenFactory()->create({this, input}, antlr4::Token::EOF, "", antlr4::Token::DEFAULT_CHANNEL,
+    pos, pos - 1, line, column);
+}
@@ -0,0 +1,636 @@
+/**
+ * @file WPLFastParser.cpp
+ * @author nllopez
+ * @brief Implementation of the hand-written WPL parser. Each method
+ *  parses one rule of WPL.g4 and fills in the labels of its context the
+ *  way the generated WPLParser does.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "WPLFastParser.h"
+
+using antlr4::ParserRuleContext;
+using antlr4::Token;
+
+/******************************************************************
+ * Precedence of the expr alternatives. ANTLR gives alternative i of
+ * the 14 a precedence of 15 - i. A binary operator of precedence p
+ * applies while p is at least the precedence of the enclosing expr,
+ * and its right operand is parsed at p + 1, or at p for the
+ * <assoc=right> EqExpr. A prefix operator parses its operand at its
+ * own precedence, which is higher than that of every binary operator.
+ ******************************************************************/
+static const int UMINUS_PRECEDENCE = 12;
+static const int NOT_PRECEDENCE = 11;
+static const int MULT_PRECEDENCE = 10;
+static const int ADD_PRECEDENCE = 9;
+static const int REL_PRECEDENCE = 8;
+static const int EQ_PRECEDENCE = 7;
+static const int AND_PRECEDENCE = 6;
+static const int OR_PRECEDENCE = 5;
+
+WPLFastParser::WPLFastParser(WPLParser& parser)
+  : parser(parser), tokens(parser.getTokenStream()), tracker(parser.getTreeTracker()) {
+  const antlr4::dfa::Vocabulary& vocabulary = parser.getVocabulary();
+  for (size_t type = 1; type <= vocabulary.getMaxTokenType(); type++) {
+    if (vocabulary.getLiteralName(type) == "'do'") {
+      doType = type;
+    } else if (vocabulary.getLiteralName(type) == "':'") {
+      colonType = type;
+    }
+  }
+}
+
+WPLParser::CompilationUnitContext* WPLFastParser::compilationUnit() {
+  try {
+    return parseCompilationUnit();
+  } catch (antlr4::ParseCancellationException& e) {
+    return nullptr;
+  }
+}
+
+/******************************************************************
+ * Tree building. As in Parser, a rule context is added to its parent
+ * when it is entered, and an expr context when it is complete.
+ ******************************************************************/
+template <typename T>
+T* WPLFastParser::enter(ParserRuleContext* parent) {
+  T* ctx = tracker.createInstance<T>(parent, antlr4::atn::ATNState::INVALID_STATE_NUMBER);
+  ctx->start = tokens->LT(1);
+  if (parent) {
+    parent->addChild(ctx);
+  }
+  return ctx;
+}
+
+void WPLFastParser::exit(ParserRuleContext* ctx) {
+  ctx->stop = tokens->LT(-1);
+}
+
+/**
+ * @brief A context for one labeled alternative of expr.
+ */
+template <typename T>
+T* WPLFastParser::alternative() {
+  WPLParser::ExprContext ctx;
+  ctx.start = tokens->LT(1);
+  return tracker.createInstance<T>(&ctx);
+}
+
+Token* WPLFastParser::match(ParserRuleContext* ctx, size_t type) {
+  Token* token = tokens->LT(1);
+  if (token->getType() != type) {
+    throw antlr4::ParseCancellationException();
+  }
+  ctx->addChild(parser.createTerminalNode(token));
+  if (type != Token::EOF) {
+    tokens->consume();
+  }
+  return token;
+}
+
+WPLParser::CompilationUnitContext* WPLFastParser::parseCompilationUnit() {
+  WPLParser::CompilationUnitContext* ctx = enter<WPLParser::CompilationUnitContext>(nullptr);
+  do {
+    ctx->cuComponentContext = cuComponent(ctx);
+    ctx->components.push_back(ctx->cuComponentContext);
+  } while (LA(1) != Token::EOF);
+  match(ctx, Token::EOF);
+  ctx->stop = tokens->LT(1);    // EOF is never consumed
+  return ctx;
+}
+
+WPLParser::CuComponentContext* WPLFastParser::cuComponent(ParserRuleContext* parent) {
+  WPLParser::CuComponentContext* ctx = enter<WPLParser::CuComponentContext>(parent);
+  if (LA(1) == WPLParser::PROC) {
+    procedure(ctx);
+  } else if (LA(1) == WPLParser::EXTERN) {
+    externDeclaration(ctx);
+  } else if (isType(LA(1)) && LA(2) == WPLParser::FUNC) {
+    function(ctx);
+  } else {
+    varDeclaration(ctx);
+  }
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::VarDeclarationContext* WPLFastParser::varDeclaration(ParserRuleContext* parent) {
+  WPLParser::VarDeclarationContext* ctx = enter<WPLParser::VarDeclarationContext>(parent);
+  if (isType(LA(1)) && LA(2) == WPLParser::LBRACKET) {
+    arrayDeclaration(ctx);
+  } else {
+    scalarDeclaration(ctx);
+  }
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::ScalarDeclarationContext* WPLFastParser::scalarDeclaration(ParserRuleContext* parent) {
+  WPLParser::ScalarDeclarationContext* ctx = enter<WPLParser::ScalarDeclarationContext>(parent);
+  if (LA(1) == WPLParser::VAR) {
+    match(ctx, WPLParser::VAR);
+  } else {
+    ctx->t = type(ctx);
+  }
+  ctx->scalarContext = scalar(ctx);
+  ctx->scalars.push_back(ctx->scalarContext);
+  while (LA(1) == WPLParser::COMMA) {
+    match(ctx, WPLParser::COMMA);
+    ctx->scalarContext = scalar(ctx);
+    ctx->scalars.push_back(ctx->scalarContext);
+  }
+  match(ctx, WPLParser::SEMICOLON);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::ScalarContext* WPLFastParser::scalar(ParserRuleContext* parent) {
+  WPLParser::ScalarContext* ctx = enter<WPLParser::ScalarContext>(parent);
+  ctx->id = match(ctx, WPLParser::ID);
+  if (LA(1) == WPLParser::ASSIGN) {
+    ctx->vi = varInitializer(ctx);
+  }
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::ArrayDeclarationContext* WPLFastParser::arrayDeclaration(ParserRuleContext* parent) {
+  WPLParser::ArrayDeclarationContext* ctx = enter<WPLParser::ArrayDeclarationContext>(parent);
+  ctx->typename_ = type(ctx);
+  match(ctx, WPLParser::LBRACKET);
+  match(ctx, WPLParser::INTEGER);
+  match(ctx, WPLParser::RBRACKET);
+  match(ctx, WPLParser::ID);
+  match(ctx, WPLParser::SEMICOLON);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::TypeContext* WPLFastParser::type(ParserRuleContext* parent) {
+  WPLParser::TypeContext* ctx = enter<WPLParser::TypeContext>(parent);
+  if (!isType(LA(1))) {
+    throw antlr4::ParseCancellationException();
+  }
+  match(ctx, LA(1));
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::VarInitializerContext* WPLFastParser::varInitializer(ParserRuleContext* parent) {
+  WPLParser::VarInitializerContext* ctx = enter<WPLParser::VarInitializerContext>(parent);
+  match(ctx, WPLParser::ASSIGN);
+  ctx->c = constant(ctx);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::ExternDeclarationContext* WPLFastParser::externDeclaration(ParserRuleContext* parent) {
+  WPLParser::ExternDeclarationContext* ctx = enter<WPLParser::ExternDeclarationContext>(parent);
+  match(ctx, WPLParser::EXTERN);
+  if (LA(1) == WPLParser::PROC) {
+    externProcHeader(ctx);
+  } else {
+    externFuncHeader(ctx);
+  }
+  match(ctx, WPLParser::SEMICOLON);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::ProcedureContext* WPLFastParser::procedure(ParserRuleContext* parent) {
+  WPLParser::ProcedureContext* ctx = enter<WPLParser::ProcedureContext>(parent);
+  ctx->ph = procHeader(ctx);
+  ctx->b = block(ctx);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::ProcHeaderContext* WPLFastParser::procHeader(ParserRuleContext* parent) {
+  WPLParser::ProcHeaderContext* ctx = enter<WPLParser::ProcHeaderContext>(parent);
+  match(ctx, WPLParser::PROC);
+  ctx->id = match(ctx, WPLParser::ID);
+  match(ctx, WPLParser::LPAR);
+  if (isType(LA(1))) {
+    ctx->p = params(ctx);
+  }
+  match(ctx, WPLParser::RPAR);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::ExternProcHeaderContext* WPLFastParser::externProcHeader(ParserRuleContext* parent) {
+  WPLParser::ExternProcHeaderContext* ctx = enter<WPLParser::ExternProcHeaderContext>(parent);
+  match(ctx, WPLParser::PROC);
+  ctx->id = match(ctx, WPLParser::ID);
+  externParams(ctx);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::FunctionContext* WPLFastParser::function(ParserRuleContext* parent) {
+  WPLParser::FunctionContext* ctx = enter<WPLParser::FunctionContext>(parent);
+  ctx->fh = funcHeader(ctx);
+  ctx->b = block(ctx);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::FuncHeaderContext* WPLFastParser::funcHeader(ParserRuleContext* parent) {
+  WPLParser::FuncHeaderContext* ctx = enter<WPLParser::FuncHeaderContext>(parent);
+  ctx->t = type(ctx);
+  match(ctx, WPLParser::FUNC);
+  ctx->id = match(ctx, WPLParser::ID);
+  match(ctx, WPLParser::LPAR);
+  if (isType(LA(1))) {
+    ctx->p = params(ctx);
+  }
+  match(ctx, WPLParser::RPAR);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::ExternFuncHeaderContext* WPLFastParser::externFuncHeader(ParserRuleContext* parent) {
+  WPLParser::ExternFuncHeaderContext* ctx = enter<WPLParser::ExternFuncHeaderContext>(parent);
+  ctx->t = type(ctx);
+  match(ctx, WPLParser::FUNC);
+  ctx->id = match(ctx, WPLParser::ID);
+  externParams(ctx);
+  exit(ctx);
+  return ctx;
+}
+
+/**
+ * @brief '(' ((params ',' ELLIPSIS) | params? | ELLIPSIS?) ')'
+ *  The parameter list of an extern header. params stops at a ','
+ *  that is not followed by a type, so the ELLIPSIS is matched here.
+ */
+void WPLFastParser::externParams(ParserRuleContext* ctx) {
+  match(ctx, WPLParser::LPAR);
+  if (isType(LA(1))) {
+    params(ctx);
+    if (LA(1) == WPLParser::COMMA) {
+      match(ctx, WPLParser::COMMA);
+      match(ctx, WPLParser::ELLIPSIS);
+    }
+  } else if (LA(1) == WPLParser::ELLIPSIS) {
+    match(ctx, WPLParser::ELLIPSIS);
+  }
+  match(ctx, WPLParser::RPAR);
+}
+
+WPLParser::ParamsContext* WPLFastParser::params(ParserRuleContext* parent) {
+  WPLParser::ParamsContext* ctx = enter<WPLParser::ParamsContext>(parent);
+  for (;;) {
+    ctx->typeContext = type(ctx);
+    ctx->types.push_back(ctx->typeContext);
+    ctx->exprContext = expr(ctx, 0);
+    ctx->ids.push_back(ctx->exprContext);
+    if (LA(1) != WPLParser::COMMA || !isType(LA(2))) {
+      break;
+    }
+    match(ctx, WPLParser::COMMA);
+  }
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::BlockContext* WPLFastParser::block(ParserRuleContext* parent) {
+  WPLParser::BlockContext* ctx = enter<WPLParser::BlockContext>(parent);
+  match(ctx, WPLParser::LBRACE);
+  do {
+    statement(ctx);
+  } while (LA(1) != WPLParser::RBRACE);
+  match(ctx, WPLParser::RBRACE);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::StatementContext* WPLFastParser::statement(ParserRuleContext* parent) {
+  WPLParser::StatementContext* ctx = enter<WPLParser::StatementContext>(parent);
+  switch (LA(1)) {
+    case WPLParser::ID:
+      if (LA(2) == WPLParser::LPAR) {
+        call(ctx);
+      } else {
+        assignment(ctx);
+      }
+      break;
+    case WPLParser::WHILE:
+      loop(ctx);
+      break;
+    case WPLParser::SELECT:
+      select(ctx);
+      break;
+    case WPLParser::IF:
+      conditional(ctx);
+      break;
+    case WPLParser::LBRACE:
+      block(ctx);
+      break;
+    case WPLParser::RETURN:
+      return_(ctx);
+      break;
+    default:
+      varDeclaration(ctx);
+      break;
+  }
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::LoopContext* WPLFastParser::loop(ParserRuleContext* parent) {
+  WPLParser::LoopContext* ctx = enter<WPLParser::LoopContext>(parent);
+  match(ctx, WPLParser::WHILE);
+  ctx->e = expr(ctx, 0);
+  match(ctx, doType);
+  ctx->b = block(ctx);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::ConditionalContext* WPLFastParser::conditional(ParserRuleContext* parent) {
+  WPLParser::ConditionalContext* ctx = enter<WPLParser::ConditionalContext>(parent);
+  match(ctx, WPLParser::IF);
+  ctx->e = expr(ctx, 0);
+  if (LA(1) == WPLParser::THEN) {
+    match(ctx, WPLParser::THEN);
+  }
+  ctx->yesblock = block(ctx);
+  if (LA(1) == WPLParser::ELSE) {
+    match(ctx, WPLParser::ELSE);
+    ctx->noblock = block(ctx);
+  }
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::SelectContext* WPLFastParser::select(ParserRuleContext* parent) {
+  WPLParser::SelectContext* ctx = enter<WPLParser::SelectContext>(parent);
+  match(ctx, WPLParser::SELECT);
+  match(ctx, WPLParser::LBRACE);
+  do {
+    selectAlt(ctx);
+  } while (LA(1) != WPLParser::RBRACE);
+  match(ctx, WPLParser::RBRACE);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::SelectAltContext* WPLFastParser::selectAlt(ParserRuleContext* parent) {
+  WPLParser::SelectAltContext* ctx = enter<WPLParser::SelectAltContext>(parent);
+  ctx->e = expr(ctx, 0);
+  match(ctx, colonType);
+  ctx->s = statement(ctx);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::CallContext* WPLFastParser::call(ParserRuleContext* parent) {
+  WPLParser::CallContext* ctx = enter<WPLParser::CallContext>(parent);
+  ctx->id = match(ctx, WPLParser::ID);
+  match(ctx, WPLParser::LPAR);
+  if (LA(1) != WPLParser::RPAR) {
+    arguments(ctx);
+  }
+  match(ctx, WPLParser::RPAR);
+  match(ctx, WPLParser::SEMICOLON);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::ArgumentsContext* WPLFastParser::arguments(ParserRuleContext* parent) {
+  WPLParser::ArgumentsContext* ctx = enter<WPLParser::ArgumentsContext>(parent);
+  ctx->argContext = arg(ctx);
+  ctx->args.push_back(ctx->argContext);
+  while (LA(1) == WPLParser::COMMA) {
+    match(ctx, WPLParser::COMMA);
+    ctx->argContext = arg(ctx);
+    ctx->args.push_back(ctx->argContext);
+  }
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::ArgContext* WPLFastParser::arg(ParserRuleContext* parent) {
+  WPLParser::ArgContext* ctx = enter<WPLParser::ArgContext>(parent);
+  expr(ctx, 0);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::ReturnContext* WPLFastParser::return_(ParserRuleContext* parent) {
+  WPLParser::ReturnContext* ctx = enter<WPLParser::ReturnContext>(parent);
+  match(ctx, WPLParser::RETURN);
+  if (LA(1) != WPLParser::SEMICOLON) {
+    expr(ctx, 0);
+  }
+  match(ctx, WPLParser::SEMICOLON);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::ConstantContext* WPLFastParser::constant(ParserRuleContext* parent) {
+  WPLParser::ConstantContext* ctx = enter<WPLParser::ConstantContext>(parent);
+  size_t type = LA(1);
+  if (type != WPLParser::INTEGER && type != WPLParser::STRING && type != WPLParser::BOOLEAN) {
+    throw antlr4::ParseCancellationException();
+  }
+  match(ctx, type);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::AssignmentContext* WPLFastParser::assignment(ParserRuleContext* parent) {
+  WPLParser::AssignmentContext* ctx = enter<WPLParser::AssignmentContext>(parent);
+  if (LA(2) == WPLParser::LBRACKET) {
+    arrayIndex(ctx);
+    match(ctx, WPLParser::ASSIGN);
+    ctx->exprContext = expr(ctx, 0);
+    ctx->e.push_back(ctx->exprContext);
+    match(ctx, WPLParser::SEMICOLON);
+    exit(ctx);
+    return ctx;
+  }
+  ctx->idToken = match(ctx, WPLParser::ID);
+  ctx->targets.push_back(ctx->idToken);
+  while (LA(1) == WPLParser::COMMA) {
+    match(ctx, WPLParser::COMMA);
+    ctx->idToken = match(ctx, WPLParser::ID);
+    ctx->targets.push_back(ctx->idToken);
+  }
+  match(ctx, WPLParser::ASSIGN);
+  ctx->exprContext = expr(ctx, 0);
+  ctx->exprs.push_back(ctx->exprContext);
+  while (LA(1) == WPLParser::COMMA) {
+    match(ctx, WPLParser::COMMA);
+    ctx->exprContext = expr(ctx, 0);
+    ctx->exprs.push_back(ctx->exprContext);
+  }
+  match(ctx, WPLParser::SEMICOLON);
+  exit(ctx);
+  return ctx;
+}
+
+WPLParser::ArrayIndexContext* WPLFastParser::arrayIndex(ParserRuleContext* parent) {
+  WPLParser::ArrayIndexContext* ctx = enter<WPLParser::ArrayIndexContext>(parent);
+  ctx->id = match(ctx, WPLParser::ID);
+  match(ctx, WPLParser::LBRACKET);
+  expr(ctx, 0);
+  match(ctx, WPLParser::RBRACKET);
+  exit(ctx);
+  return ctx;
+}
+
+/**
+ * @brief Build a binary expression on the left operand that has been
+ *  parsed and parse its right operand.
+ */
+template <typename T>
+T* WPLFastParser::binary(WPLParser::ExprContext* left, int precedence) {
+  WPLParser::ExprContext base;
+  base.start = left->start;
+  T* ctx = tracker.createInstance<T>(&base);
+  ctx->left = left;
+  left->parent = ctx;
+  ctx->addChild(left);
+  match(ctx, LA(1));
+  ctx->right = expr(ctx, precedence);
+  exit(ctx);
+  return ctx;
+}
+
+/**
+ * @brief Precedence climbing over the binary alternatives of expr.
+ *  Parses an operand and then every operator of at least the given
+ *  precedence.
+ */
+WPLParser::ExprContext* WPLFastParser::expr(ParserRuleContext* parent, int precedence) {
+  WPLParser::ExprContext* left = primary();
+  for (;;) {
+    switch (LA(1)) {
+      case WPLParser::MUL:
+      case WPLParser::DIV:
+        if (precedence > MULT_PRECEDENCE) {
+          break;
+        }
+        left = binary<WPLParser::MultExprContext>(left, MULT_PRECEDENCE + 1);
+        continue;
+      case WPLParser::PLUS:
+      case WPLParser::MINUS:
+        if (precedence > ADD_PRECEDENCE) {
+          break;
+        }
+        left = binary<WPLParser::AddExprContext>(left, ADD_PRECEDENCE + 1);
+        continue;
+      case WPLParser::LESS:
+      case WPLParser::LEQ:
+      case WPLParser::GTR:
+      case WPLParser::GEQ:
+        if (precedence > REL_PRECEDENCE) {
+          break;
+        }
+        left = binary<WPLParser::RelExprContext>(left, REL_PRECEDENCE + 1);
+        continue;
+      case WPLParser::EQUAL:
+      case WPLParser::NEQ:
+        if (precedence > EQ_PRECEDENCE) {
+          break;
+        }
+        left = binary<WPLParser::EqExprContext>(left, EQ_PRECEDENCE);    // right associative
+        continue;
+      case WPLParser::AND:
+        if (precedence > AND_PRECEDENCE) {
+          break;
+        }
+        left = binary<WPLParser::AndExprContext>(left, AND_PRECEDENCE + 1);
+        continue;
+      case WPLParser::OR:
+        if (precedence > OR_PRECEDENCE) {
+          break;
+        }
+        left = binary<WPLParser::OrExprContext>(left, OR_PRECEDENCE + 1);
+        continue;
+    }
+    break;
+  }
+  left->parent = parent;
+  parent->addChild(left);
+  return left;
+}
+
+/**
+ * @brief The alternatives of expr that do not start with an expr. The
+ *  context is added to its parent by expr once its operators are known.
+ */
+WPLParser::ExprContext* WPLFastParser::primary() {
+  switch (LA(1)) {
+    case WPLParser::ID:
+      if (LA(2) == WPLParser::LPAR) {
+        WPLParser::FuncProcCallExprContext* ctx = alternative<WPLParser::FuncProcCallExprContext>();
+        ctx->fpname = match(ctx, WPLParser::ID);
+        match(ctx, WPLParser::LPAR);
+        if (LA(1) != WPLParser::RPAR) {
+          ctx->exprContext = expr(ctx, 0);
+          ctx->args.push_back(ctx->exprContext);
+          while (LA(1) == WPLParser::COMMA) {
+            match(ctx, WPLParser::COMMA);
+            ctx->exprContext = expr(ctx, 0);
+            ctx->args.push_back(ctx->exprContext);
+          }
+        }
+        match(ctx, WPLParser::RPAR);
+        exit(ctx);
+        return ctx;
+      } else if (LA(2) == WPLParser::LBRACKET) {
+        WPLParser::SubscriptExprContext* ctx = alternative<WPLParser::SubscriptExprContext>();
+        arrayIndex(ctx);
+        exit(ctx);
+        return ctx;
+      } else if (LA(2) == WPLParser::DOT) {
+        WPLParser::ArrayLengthExprContext* ctx = alternative<WPLParser::ArrayLengthExprContext>();
+        ctx->arrayname = match(ctx, WPLParser::ID);
+        match(ctx, WPLParser::DOT);
+        match(ctx, WPLParser::LENGTH);
+        exit(ctx);
+        return ctx;
+      } else {
+        WPLParser::IDExprContext* ctx = alternative<WPLParser::IDExprContext>();
+        match(ctx, WPLParser::ID);
+        exit(ctx);
+        return ctx;
+      }
+    case WPLParser::MINUS: {
+      WPLParser::UMinusExprContext* ctx = alternative<WPLParser::UMinusExprContext>();
+      match(ctx, WPLParser::MINUS);
+      ctx->e = expr(ctx, UMINUS_PRECEDENCE);
+      exit(ctx);
+      return ctx;
+    }
+    case WPLParser::NOT: {
+      WPLParser::NotExprContext* ctx = alternative<WPLParser::NotExprContext>();
+      match(ctx, WPLParser::NOT);
+      ctx->e = expr(ctx, NOT_PRECEDENCE);
+      exit(ctx);
+      return ctx;
+    }
+    case WPLParser::LPAR: {
+      WPLParser::ParenExprContext* ctx = alternative<WPLParser::ParenExprContext>();
+      match(ctx, WPLParser::LPAR);
+      expr(ctx, 0);
+      match(ctx, WPLParser::RPAR);
+      exit(ctx);
+      return ctx;
+    }
+    case WPLParser::INTEGER:
+    case WPLParser::STRING:
+    case WPLParser::BOOLEAN: {
+      WPLParser::ConstExprContext* ctx = alternative<WPLParser::ConstExprContext>();
+      constant(ctx);
+      exit(ctx);
+      return ctx;
+    }
+    default:
+      throw antlr4::ParseCancellationException();
+  }
+}
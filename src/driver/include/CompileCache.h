@@ -0,0 +1,45 @@
+/**
+ * @file CompileCache.h
+ * @author nllopez
+ * @brief Content addressed cache of generated IR. Entries are keyed by a
+ *  hash of the compiler version, the source bytes and the options that
+ *  change the generated IR. The cache directory can be shared by many
+ *  wplc processes: entries are written to a unique temporary file and
+ *  renamed into place, and readers treat a vanished entry as a miss.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "WPLCompiler.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <cstdint>
+
+class CompileCache {
+  public:
+    CompileCache(std::string dir, uint64_t maxBytes) {
+      cacheDir = dir;
+      sizeLimit = maxBytes;
+    }
+
+    static std::string key(llvm::StringRef source, const CompileJob& job);
+    // Key for the IR of one procedure or function (see IncrementalBuild)
+    static std::string componentKey(const std::string& environment, const std::string& text);
+
+    // Returns false on a miss. A hit marks the entry as recently used.
+    bool lookup(const std::string& key, std::string& ir);
+    void store(const std::string& key, const std::string& ir);
+    // Trim the cache back under its size limit. store() does not, since
+    // one compile can store many entries; call this once after them.
+    void evict();
+
+    // Append this run's counts to the totals kept in the cache directory
+    void recordStats(unsigned hits, unsigned misses);
+    bool totalStats(uint64_t& hits, uint64_t& misses);
+
+  private:
+    std::string entryPath(const std::string& key);
+
+    std::string cacheDir;
+    uint64_t sizeLimit;
+};
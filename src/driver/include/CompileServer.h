@@ -0,0 +1,28 @@
+/**
+ * @file CompileServer.h
+ * @author nllopez
+ * @brief A compile server that listens on a local Unix socket and runs
+ *  the submitted CompileJobs in one long lived process. The ANTLR ATNs,
+ *  the parser DFA cache and the LLVM state stay warm between requests.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "WPLCompiler.h"
+#include <string>
+
+class CompileServer {
+  public:
+    // Default socket path for the current user, in a directory only that
+    // user can reach
+    static std::string defaultSocketPath();
+
+    // Serve requests until SIGINT or SIGTERM, then wait for the ones in
+    // progress. Returns non-zero on failure.
+    static int serve(const std::string& socketPath, unsigned threads);
+
+    // Send the job to a running server. Returns false if there is no server
+    // or it runs as another user.
+    static bool request(const std::string& socketPath, const CompileJob& job,
+      CompileResult& result);
+};
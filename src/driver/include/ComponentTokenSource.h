@@ -0,0 +1,43 @@
+/**
+ * @file ComponentTokenSource.h
+ * @author nllopez
+ * @brief A token source that cuts the tokens of another source into
+ *  top-level components. It hands out the tokens of one component and
+ *  then an EOF, so each component can be parsed on its own with a
+ *  fresh token stream and parser and freed before the next one is read.
+ *
+ *  A component ends at a ';' outside of any braces (declarations and
+ *  externs) or at the '}' that closes its outermost block (procedures
+ *  and functions). That is only the whole story for correct input, so
+ *  a syntax error in any component must be reported by parsing the
+ *  whole input again.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "antlr4-runtime.h"
+
+class ComponentTokenSource : public antlr4::TokenSource {
+  public:
+    explicit ComponentTokenSource(antlr4::TokenSource* tokenSource) : source(tokenSource) {}
+
+    // Start on the next component. False at the end of the input.
+    bool nextComponent();
+
+    std::unique_ptr<antlr4::Token> nextToken() override;
+    size_t getLine() const override { return source->getLine(); }
+    size_t getCharPositionInLine() override { return source->getCharPositionInLine(); }
+    antlr4::CharStream* getInputStream() override { return source->getInputStream(); }
+    std::string getSourceName() override { return source->getSourceName(); }
+    antlr4::TokenFactory<antlr4::CommonToken>* getTokenFactory() override {
+      return source->getTokenFactory();
+    }
+
+  private:
+    antlr4::Token* peek();
+
+    antlr4::TokenSource* source;
+    std::unique_ptr<antlr4::Token> lookahead;
+    size_t depth = 0;            // braces open in the current component
+    bool atEnd = true;           // the current component has been handed out
+};
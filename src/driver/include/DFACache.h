@@ -0,0 +1,29 @@
+/**
+ * @file DFACache.h
+ * @author nllopez
+ * @brief Persistent copy of the prediction DFAs of the WPL lexer and
+ *  parser. ANTLR builds these DFAs lazily and shares them between all
+ *  lexer and parser instances of a process, so a short-lived wplc spends
+ *  much of its time building DFA states that an earlier run already
+ *  built. The cache file is tied to a hash of the lexer and parser ATNs
+ *  and of the ANTLR runtime version, so a cache written before WPL.g4
+ *  changed is never loaded.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include <cstddef>
+#include <string>
+
+class DFACache {
+  public:
+    // Fill the empty shared DFAs from the file. Returns false and leaves
+    // the DFAs alone if the file is missing, damaged or stale.
+    static bool load(const std::string& path, std::string& error);
+    // Write every DFA state built so far. Must not run while a compile
+    // is in progress.
+    static bool save(const std::string& path, std::string& error);
+
+    // Number of DFA states in the shared lexer and parser DFAs
+    static size_t stateCount();
+};
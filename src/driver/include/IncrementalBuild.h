@@ -0,0 +1,52 @@
+/**
+ * @file IncrementalBuild.h
+ * @author nllopez
+ * @brief Function granularity recompilation. Every top-level procedure
+ *  and function is fingerprinted by its source text together with the
+ *  declarations that precede it, and with the bodies before it that
+ *  may give an untyped var global its type. Components whose fingerprint is in the
+ *  compile cache are only declared by the visitors, and their cached IR
+ *  is linked into the new module.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "CompileCache.h"
+#include "AST.h"
+#include "CallGraph.h"
+#include "antlr4-runtime.h"
+#include "llvm/IR/Module.h"
+#include <set>
+#include <string>
+#include <vector>
+
+class IncrementalBuild {
+  public:
+    IncrementalBuild(CompileCache* c) : cache(c) {}
+
+    // Compute the fingerprints and look the components up in the cache
+    void fingerprint(antlr4::CharStream* input, ast::CompilationUnit* tree);
+    std::set<ast::Node*> reusedComponents();
+
+    // Link the cached IR of the reused components into the module,
+    // except for those the call graph does not reach
+    bool splice(llvm::Module* module, const CallGraph* calls, std::string& error);
+    // Cache the IR of the components that were generated again
+    void store(llvm::Module* module);
+
+    unsigned reusedCount();
+    unsigned componentCount() { return components.size(); }
+
+  private:
+    struct Component {
+      ast::Node* ctx;
+      std::string name;
+      std::string key;
+      std::string ir;
+      bool reused = false;
+    };
+
+    CompileCache* cache;
+    std::vector<Component> components;    // procedures and functions in source order
+    std::vector<std::string> declarationOrder;    // every global function name in source order
+};
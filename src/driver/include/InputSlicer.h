@@ -0,0 +1,75 @@
+/**
+ * @file InputSlicer.h
+ * @author nllopez
+ * @brief Splits ASCII source into slices of whole top-level components
+ *  so that the slices can be lexed and parsed on different threads.
+ *
+ *  The split is a quick scan of the bytes that balances braces and
+ *  skips strings and comments; it does not run the lexer. A slice ends
+ *  after a ';' outside braces or after the '}' that closes a procedure
+ *  or function. SliceTokenSource checks that the lexer agrees, that is
+ *  that the last token of each slice ends exactly at the end of the
+ *  slice, so a slice boundary the scan got wrong shows up as a failed
+ *  slice and the input is parsed again in one piece.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "antlr4-runtime.h"
+#include "llvm/ADT/StringRef.h"
+#include <vector>
+
+/**
+ * @brief A range of the source and the position of its first byte.
+ */
+struct InputSlice {
+  size_t begin = 0;
+  size_t end = 0;        // exclusive
+  size_t line = 1;
+  size_t column = 0;
+};
+
+class InputSlicer {
+  public:
+    // Split the source into at most count slices of about the same size.
+    // The slices cover the whole source, in order.
+    static std::vector<InputSlice> split(llvm::StringRef source, size_t count);
+
+    // True if the source ends with a whole component, outside any braces,
+    // comment or string, so that a split of what follows does not depend
+    // on it. Whitespace and comments may follow the component.
+    static bool closes(llvm::StringRef source);
+
+    // True if the source is only whitespace and comments
+    static bool blank(llvm::StringRef source);
+};
+
+/**
+ * @brief Hands out the tokens of a lexer positioned at the start of a
+ *  slice until the end of the slice, then an EOF.
+ */
+class SliceTokenSource : public antlr4::TokenSource {
+  public:
+    SliceTokenSource(antlr4::TokenSource* tokenSource, const InputSlice& inputSlice, size_t inputSize)
+      : source(tokenSource), slice(inputSlice), size(inputSize) {}
+
+    // True if the lexer's tokens stopped exactly at the end of the slice.
+    // Only meaningful once the EOF has been handed out.
+    bool endsOnTokenBoundary() const { return boundary; }
+
+    std::unique_ptr<antlr4::Token> nextToken() override;
+    size_t getLine() const override { return source->getLine(); }
+    size_t getCharPositionInLine() override { return source->getCharPositionInLine(); }
+    antlr4::CharStream* getInputStream() override { return source->getInputStream(); }
+    std::string getSourceName() override { return source->getSourceName(); }
+    antlr4::TokenFactory<antlr4::CommonToken>* getTokenFactory() override {
+      return source->getTokenFactory();
+    }
+
+  private:
+    antlr4::TokenSource* source;
+    InputSlice slice;
+    size_t size;
+    size_t lastStop = 0;      // one past the last token handed out
+    bool boundary = false;
+};
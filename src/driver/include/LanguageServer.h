@@ -0,0 +1,24 @@
+/**
+ * @file LanguageServer.h
+ * @author nllopez
+ * @brief A language server for WPL that publishes the syntax and
+ *  semantic errors of the open documents as they are edited. It speaks
+ *  JSON-RPC with Content-Length framing, as the language server
+ *  protocol does, and keeps an OpenDocument for each open file so that
+ *  an edit is reparsed and checked incrementally. Code generation is
+ *  not run, so the errors only the code generator finds are not shown.
+ *
+ *  Handled: initialize, shutdown, exit, textDocument/didOpen,
+ *  textDocument/didChange (whole or incremental), textDocument/didClose.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include <iostream>
+
+class LanguageServer {
+  public:
+    // Serve requests until the client sends exit. With log set, the time
+    // taken by each update goes to stderr. Returns the exit code.
+    static int serve(std::istream& in, std::ostream& out, bool log);
+};
@@ -0,0 +1,42 @@
+/**
+ * @file MappedInputStream.h
+ * @author nllopez
+ * @brief A character stream that serves the lexer straight from the bytes
+ *  of a memory buffer, usually a memory-mapped source file. Unlike
+ *  ANTLRInputStream it neither copies the input nor decodes it into
+ *  32-bit code points. Stream indexes are byte offsets, which are the
+ *  code point indexes ANTLRInputStream reports only when the input is
+ *  ASCII, so use it only for input that passes isASCII().
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "antlr4-runtime.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+
+class MappedInputStream : public antlr4::CharStream {
+  public:
+    // The buffer must outlive the stream and every token made from it
+    MappedInputStream(llvm::StringRef buffer, std::string sourceName)
+      : data(buffer), name(sourceName) {}
+
+    static bool isASCII(llvm::StringRef buffer);
+
+    void consume() override;
+    size_t LA(ssize_t i) override;
+    ssize_t mark() override { return -1; }
+    void release(ssize_t marker) override {}
+    size_t index() override { return p; }
+    void seek(size_t index) override;
+    size_t size() override { return data.size(); }
+    std::string getSourceName() const override;
+
+    std::string getText(const antlr4::misc::Interval& interval) override;
+    std::string toString() const override { return data.str(); }
+
+  private:
+    llvm::StringRef data;
+    std::string name;
+    size_t p = 0;
+};
@@ -0,0 +1,111 @@
+/**
+ * @file OpenDocument.h
+ * @author nllopez
+ * @brief A WPL source kept in memory by the language server, with the
+ *  tree of each of its top-level components and what the semantic pass
+ *  found in each body, so that an edit costs a parse of the components
+ *  it touches and a check of the bodies it can affect.
+ *
+ *  The components are the slices InputSlicer cuts at each ';' or '}'
+ *  that ends one; together they cover the whole text. An edit reparses
+ *  the components it overlaps, widened until the text parsed ends on a
+ *  component boundary, so the components after it are cut the same.
+ *
+ *  Every update declares the globals and signatures of all components
+ *  again, in source order, as the first pass of a parallel check does.
+ *  That is cheap next to checking the bodies. A body is checked again
+ *  only if it was reparsed or if one of the global names it looked up
+ *  now finds a different declaration: none where there was one, or one
+ *  of another type. What a body reports depends on nothing else.
+ *
+ *  Positions in a tree are those of the text it was parsed from. The
+ *  diagnostics of a component are moved to where the component is now
+ *  when they are reported.
+ *
+ *  Text that is not ASCII, or that the slicer cuts where the lexer does
+ *  not, is compiled in one piece on every update instead.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "WPLCompiler.h"
+#include "WPLSyntaxErrorListener.h"
+#include "AST.h"
+#include "Symbol.h"
+#include "llvm/ADT/StringRef.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A syntax or semantic error at a 1-based line and 0-based column
+ *  of the current text.
+ */
+struct Diagnostic {
+  size_t line;
+  size_t column;
+  std::string message;
+};
+
+class OpenDocument {
+  public:
+    explicit OpenDocument(std::string text);
+
+    // Replace the whole text
+    void setText(std::string text);
+    // Replace the bytes from begin to end with the text
+    void edit(size_t begin, size_t end, llvm::StringRef text);
+    // The byte offset of a 0-based line and UTF-16 character, as the
+    // language server protocol counts them, clamped to the text
+    size_t offset(size_t line, size_t character) const;
+
+    // The diagnostics of the current text, in the order wplc reports them
+    const std::vector<Diagnostic>& diagnostics();
+
+    const std::string& getText() const { return text; }
+    // What the last update of the diagnostics did
+    size_t componentCount() const { return components.size(); }
+    size_t reparsedCount() const { return lastReparsed; }
+    size_t recheckedCount() const { return rechecked; }
+
+  private:
+    // A name a body looked up among the globals and what it found
+    struct GlobalUse {
+      ast::Identifier id;
+      bool found;
+      SymType type;
+    };
+    struct Component {
+      size_t begin = 0, end = 0;          // in the current text
+      size_t parsedLine = 1, parsedColumn = 0;    // where begin was when it was parsed
+      std::unique_ptr<ast::Tree> tree;    // nullptr if it has a syntax error
+      std::vector<SyntaxError> syntaxErrors;
+      // The check of a procedure or function body, if it is up to date
+      bool checked = false;
+      std::vector<SyntaxError> bodyErrors;
+      std::vector<GlobalUse> uses;
+
+      ast::Node* node() const { return tree->root->components[0]; }
+    };
+
+    bool reparse(size_t first, size_t last, size_t begin, size_t end);
+    void reparseAll();
+    void check();
+    void checkInOrder();
+    void compileWhole();
+    void report(const Component& c, size_t line, size_t column, const std::string& message);
+    size_t lineOf(size_t offset) const;
+
+    std::string text;
+    std::vector<size_t> lineStarts;     // byte offset of each line
+    size_t nonASCII = 0;                // bytes of the text above 127
+    std::vector<Component> components;
+    std::shared_ptr<ast::NameTable> names;
+    CompileJob job;
+    bool whole = false;                 // compile in one piece
+    bool dirty = true;
+    std::vector<Diagnostic> current;
+    size_t reparsed = 0;               // components parsed since the last update
+    size_t lastReparsed = 0;
+    size_t rechecked = 0;
+};
@@ -0,0 +1,185 @@
+/**
+ * @file WPLCompiler.h
+ * @author nllopez
+ * @brief The compilation pipeline for a single WPL input. Every call
+ *  to compile() builds its own lexer, parser, symbol table and
+ *  LLVMContext, so several inputs can be compiled at the same time.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <vector>
+
+namespace llvm { class StringRef; }
+namespace ast { class Tree; class NameTable; }
+struct InputSlice;
+struct SyntaxError;
+
+/**
+ * @brief Which lexer turns the source into tokens. The fast lexer only
+ *  handles ASCII input; anything else goes to the ANTLR lexer. VERIFY
+ *  runs both and fails the compile at the first token that differs.
+ */
+enum class LexerKind : uint32_t {
+  ANTLR,
+  FAST,
+  VERIFY
+};
+
+/**
+ * @brief Which parser builds the parse tree. The fast parser hands any
+ *  input with a syntax error over to the ANTLR parser, which reports it.
+ *  VERIFY runs both and fails the compile at the first node of the
+ *  parse trees that differs.
+ */
+enum class ParserKind : uint32_t {
+  ANTLR,
+  FAST,
+  VERIFY
+};
+
+/**
+ * @brief How much the module is optimized before it is written, as with
+ *  the -O levels of opt. O0 runs no passes, so the IR is exactly what
+ *  the code generator built.
+ */
+enum class OptLevel : uint32_t {
+  O0,
+  O1,
+  O2,
+  O3
+};
+
+/**
+ * @brief Everything that is needed to compile one input.
+ *  An inputFileName of "-" means the source is in inputString.
+ *  An empty cacheDir turns the compile cache off. With incremental set,
+ *  unchanged procedures and functions are reused from the cache. With
+ *  stream set, the top-level components are parsed, checked and
+ *  compiled one at a time and their tokens and trees freed as soon as
+ *  they are done. With parseThreads other than 1, ASCII input is split
+ *  into slices of components that are parsed on that many threads
+ *  (0 = one per core). With semanticThreads other than 1, the bodies of
+ *  procedures and functions are checked on that many threads. With an
+ *  errorLimit other than 0, analysis stops once it has found more than
+ *  that many errors and only the first errorLimit are reported. Procedures and functions that
+ *  program cannot reach get no code, or only a declaration with
+ *  keepUnused; with callGraphReport set, the result lists them all (see
+ *  RoutineReach). Above O0, optLevel runs the LLVM pipeline of that
+ *  level on the module. With profileParser set, the generated parser
+ *  profiles its decisions (see DecisionProfile).
+ */
+struct CompileJob {
+  std::string inputFileName = "-";
+  std::string inputString = "-";
+  std::string outputFileName = "-";
+  bool printOutput = false;
+  bool noCode = false;
+  std::string cacheDir;
+  uint64_t cacheSizeLimit = 0;
+  bool incremental = false;
+  bool timeTrace = false;
+  unsigned timeTraceGranularity = 500;    // microseconds
+  LexerKind lexer = LexerKind::ANTLR;
+  ParserKind parser = ParserKind::ANTLR;
+  bool stream = false;
+  unsigned parseThreads = 1;
+  unsigned semanticThreads = 1;
+  unsigned errorLimit = 0;
+  bool keepUnused = false;
+  bool callGraphReport = false;
+  OptLevel optLevel = OptLevel::O0;
+  bool profileParser = false;
+};
+
+/**
+ * @brief What the ANTLR profiling simulator measured for one decision of
+ *  the generated parser. A profiled parse predicts every decision with
+ *  SLL first and falls back to full LL where SLL conflicts, as a single
+ *  LL parse does, so llFallbacks counts the full-context predictions.
+ */
+struct DecisionProfile {
+  std::string rule;                   // grammar rule the decision is in
+  size_t decision = 0;
+  uint64_t invocations = 0;
+  uint64_t llFallbacks = 0;
+  uint64_t ambiguities = 0;
+  uint64_t contextSensitivities = 0;  // SLL conflicted but full LL found one alternative
+  uint64_t sllLookahead = 0;          // tokens looked at, summed over the invocations
+  uint64_t llLookahead = 0;
+  uint64_t sllMaxLookahead = 0;
+  uint64_t llMaxLookahead = 0;
+  uint64_t nanoseconds = 0;           // spent in prediction
+
+  void add(const DecisionProfile& other) {
+    invocations += other.invocations;
+    llFallbacks += other.llFallbacks;
+    ambiguities += other.ambiguities;
+    contextSensitivities += other.contextSensitivities;
+    sllLookahead += other.sllLookahead;
+    llLookahead += other.llLookahead;
+    sllMaxLookahead = std::max(sllMaxLookahead, other.sllMaxLookahead);
+    llMaxLookahead = std::max(llMaxLookahead, other.llMaxLookahead);
+    nanoseconds += other.nanoseconds;
+  }
+};
+
+/**
+ * @brief A procedure or function of the input and its place in the call
+ *  graph.
+ */
+struct RoutineReach {
+  std::string name;
+  bool reachable = false;    // from program
+  unsigned callSites = 0;    // calls to it
+  unsigned calls = 0;        // calls it makes
+};
+
+/**
+ * @brief Time and memory used by one phase of the pipeline.
+ */
+struct PhaseStats {
+  std::string name;
+  double seconds = 0;
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;       // bytes allocated during the phase
+  // Peak resident set size of the whole process when the phase ended, not
+  // of the phase: it includes the phases and inputs before it
+  uint64_t processPeakRSS = 0;
+};
+
+/**
+ * @brief The outcome of compiling one input. The diagnostics and the
+ *  printed IR are kept here so the driver decides when to write them.
+ */
+struct CompileResult {
+  std::string inputName;
+  std::string outputFileName;
+  std::string diagnostics;
+  std::string ir;
+  bool success = false;
+  bool cacheHit = false;
+  unsigned reusedComponents = 0;    // procedures and functions reused by an incremental compile
+  unsigned componentCount = 0;
+  std::vector<PhaseStats> phases;    // in pipeline order
+  std::vector<DecisionProfile> parserProfile;    // indexed by decision, with profileParser
+  std::vector<RoutineReach> callGraph;    // in source order, with callGraphReport
+};
+
+class WPLCompiler {
+  public:
+    static CompileResult compile(const CompileJob& job);
+    static std::string irFileName(const CompileJob& job);
+
+    // Parse one slice of ASCII source on its own, with the lexer and
+    // parser of the job, and lower it to a tree whose identifiers go into
+    // names. nullptr if the slice has a syntax error, which is added to
+    // syntaxErrors, or does not end on a token boundary, which adds none.
+    static std::unique_ptr<ast::Tree> parseComponent(const CompileJob& job, llvm::StringRef source,
+        const InputSlice& slice, std::shared_ptr<ast::NameTable> names,
+        std::vector<SyntaxError>& syntaxErrors);
+};
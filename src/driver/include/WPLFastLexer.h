@@ -0,0 +1,87 @@
+/**
+ * @file WPLFastLexer.h
+ * @author nllopez
+ * @brief Hand-written lexer for ASCII WPL source that produces the same
+ *  tokens, positions and error messages as the generated WPLLexer. It
+ *  scans the bytes of the input buffer directly, skips whitespace and
+ *  identifier runs 16 bytes at a time with SSE2 where available, and
+ *  classifies keywords with a perfect hash.
+ *
+ *  Keywords and operators are read from the WPLLexer vocabulary, so they
+ *  follow WPL.g4. The rules that have no single literal (ID, INTEGER,
+ *  BOOLEAN, STRING, WS and COMMENT) are written out by hand and must be
+ *  kept in step with the grammar. Strings and comments use non-greedy
+ *  loops, which ANTLR resolves in a particular way; they are matched by
+ *  replaying that resolution on a small list of ATN configurations.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "antlr4-runtime.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <vector>
+
+class WPLFastLexer : public antlr4::TokenSource {
+  public:
+    // The buffer holds the bytes of input, which must be ASCII
+    WPLFastLexer(llvm::StringRef buffer, antlr4::CharStream* input, const antlr4::dfa::Vocabulary& vocabulary);
+
+    // Lexer errors go to these listeners, with no recognizer
+    void addErrorListener(antlr4::ANTLRErrorListener* listener) { listeners.push_back(listener); }
+
+    // Start lexing at index, which must be at the given line and column
+    void seek(size_t index, size_t atLine, size_t atColumn) {
+      pos = index;
+      line = atLine;
+      column = atColumn;
+    }
+
+    std::unique_ptr<antlr4::Token> nextToken() override;
+    size_t getLine() const override { return line; }
+    size_t getCharPositionInLine() override { return column; }
+    antlr4::CharStream* getInputStream() override { return input; }
+    std::string getSourceName() override { return input->getSourceName(); }
+    antlr4::TokenFactory<antlr4::CommonToken>* getTokenFactory() override {
+      return antlr4::CommonTokenFactory::DEFAULT.get();
+    }
+
+  private:
+    struct Keyword {
+      std::string text;
+      size_t type = 0;
+    };
+    struct Literal {
+      std::string text;
+      size_t type;
+    };
+
+    // Token types and literal tables, built once from the vocabulary
+    struct Tables {
+      explicit Tables(const antlr4::dfa::Vocabulary& vocabulary);
+      void buildKeywordTable();
+      static uint32_t keywordFeatures(const char* p, size_t length);
+      size_t keywordType(const char* p, size_t length) const;
+
+      size_t idType, integerType, booleanType, stringType;
+      std::vector<Keyword> keywords;    // perfect hash table
+      uint32_t keywordSeed = 0;
+      uint32_t keywordShift = 0;
+      std::vector<Literal> literals[128];    // operators by first character, longest first
+    };
+    static const Tables& tablesFor(const antlr4::dfa::Vocabulary& vocabulary);
+
+    size_t matchLiteral(size_t start, size_t& type, size_t& dieLength);
+    size_t matchString(size_t start, size_t& dieLength);
+    size_t matchComment(size_t start);
+    void advanceTo(size_t index);
+    void reportError(size_t start, size_t startLine, size_t startColumn, size_t dieIndex);
+
+    llvm::StringRef data;
+    antlr4::CharStream* input;
+    const Tables& tables;
+    std::vector<antlr4::ANTLRErrorListener*> listeners;
+    size_t pos = 0;
+    size_t line = 1;
+    size_t column = 0;
+};
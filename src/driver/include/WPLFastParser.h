@@ -0,0 +1,80 @@
+/**
+ * @file WPLFastParser.h
+ * @author nllopez
+ * @brief Hand-written recursive descent parser for WPL. It builds the
+ *  same parse tree as WPLParser, with the same context classes, labels,
+ *  children and start and stop tokens, so the visitors cannot tell the
+ *  two apart. Expressions are parsed by precedence climbing instead of
+ *  the precedence predicates that ANTLR generates for the left-recursive
+ *  expr rule, and every other decision is made on one or two tokens of
+ *  lookahead.
+ *
+ *  Only correct input is handled. At the first unexpected token the
+ *  parse gives up and the caller parses again with WPLParser, which
+ *  reports the syntax errors.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "antlr4-runtime.h"
+#include "WPLParser.h"
+
+class WPLFastParser {
+  public:
+    // The tree is allocated by the tree tracker of parser and lives as
+    // long as the parser does. Tokens are read from its token stream.
+    explicit WPLFastParser(WPLParser& parser);
+
+    // The parse tree, or nullptr if the input has a syntax error
+    WPLParser::CompilationUnitContext* compilationUnit();
+
+  private:
+    WPLParser::CompilationUnitContext* parseCompilationUnit();
+    WPLParser::CuComponentContext* cuComponent(antlr4::ParserRuleContext* parent);
+    WPLParser::VarDeclarationContext* varDeclaration(antlr4::ParserRuleContext* parent);
+    WPLParser::ScalarDeclarationContext* scalarDeclaration(antlr4::ParserRuleContext* parent);
+    WPLParser::ScalarContext* scalar(antlr4::ParserRuleContext* parent);
+    WPLParser::ArrayDeclarationContext* arrayDeclaration(antlr4::ParserRuleContext* parent);
+    WPLParser::TypeContext* type(antlr4::ParserRuleContext* parent);
+    WPLParser::VarInitializerContext* varInitializer(antlr4::ParserRuleContext* parent);
+    WPLParser::ExternDeclarationContext* externDeclaration(antlr4::ParserRuleContext* parent);
+    WPLParser::ProcedureContext* procedure(antlr4::ParserRuleContext* parent);
+    WPLParser::ProcHeaderContext* procHeader(antlr4::ParserRuleContext* parent);
+    WPLParser::ExternProcHeaderContext* externProcHeader(antlr4::ParserRuleContext* parent);
+    WPLParser::FunctionContext* function(antlr4::ParserRuleContext* parent);
+    WPLParser::FuncHeaderContext* funcHeader(antlr4::ParserRuleContext* parent);
+    WPLParser::ExternFuncHeaderContext* externFuncHeader(antlr4::ParserRuleContext* parent);
+    void externParams(antlr4::ParserRuleContext* ctx);
+    WPLParser::ParamsContext* params(antlr4::ParserRuleContext* parent);
+    WPLParser::BlockContext* block(antlr4::ParserRuleContext* parent);
+    WPLParser::StatementContext* statement(antlr4::ParserRuleContext* parent);
+    WPLParser::LoopContext* loop(antlr4::ParserRuleContext* parent);
+    WPLParser::ConditionalContext* conditional(antlr4::ParserRuleContext* parent);
+    WPLParser::SelectContext* select(antlr4::ParserRuleContext* parent);
+    WPLParser::SelectAltContext* selectAlt(antlr4::ParserRuleContext* parent);
+    WPLParser::CallContext* call(antlr4::ParserRuleContext* parent);
+    WPLParser::ArgumentsContext* arguments(antlr4::ParserRuleContext* parent);
+    WPLParser::ArgContext* arg(antlr4::ParserRuleContext* parent);
+    WPLParser::ReturnContext* return_(antlr4::ParserRuleContext* parent);
+    WPLParser::ConstantContext* constant(antlr4::ParserRuleContext* parent);
+    WPLParser::AssignmentContext* assignment(antlr4::ParserRuleContext* parent);
+    WPLParser::ArrayIndexContext* arrayIndex(antlr4::ParserRuleContext* parent);
+    WPLParser::ExprContext* expr(antlr4::ParserRuleContext* parent, int precedence);
+    WPLParser::ExprContext* primary();
+    template <typename T> T* binary(WPLParser::ExprContext* left, int precedence);
+
+    template <typename T> T* enter(antlr4::ParserRuleContext* parent);
+    void exit(antlr4::ParserRuleContext* ctx);
+    template <typename T> T* alternative();
+    antlr4::Token* match(antlr4::ParserRuleContext* ctx, size_t type);
+    size_t LA(ssize_t i) { return tokens->LA(i); }
+    bool isType(size_t type) {
+      return type == WPLParser::BOOL || type == WPLParser::INT || type == WPLParser::STR;
+    }
+
+    WPLParser& parser;
+    antlr4::TokenStream* tokens;
+    antlr4::tree::ParseTreeTracker& tracker;
+    size_t doType = 0;       // 'do' and ':' only appear in parser rules,
+    size_t colonType = 0;    // so their token types have no names
+};
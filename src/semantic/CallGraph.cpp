@@ -0,0 +1,76 @@
+/**
+ * @file CallGraph.cpp
+ * @author nllopez
+ * @brief Implementation of the call graph and its reachability.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "CallGraph.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include <algorithm>
+
+using namespace ast;
+
+void CallGraph::addCallsOf(Routine* routine) {
+  llvm::SmallVector<Node*, 64> work{routine->b};
+  llvm::SmallVector<Node*, 8> below;
+  while (!work.empty()) {
+    Node* n = work.pop_back_val();
+    if (Call* call = llvm::dyn_cast<Call>(n)) {
+      addCall(routine->id, call->id);
+    } else if (CallExpr* call = llvm::dyn_cast<CallExpr>(n)) {
+      addCall(routine->id, call->id);
+    }
+    below.clear();
+    children(n, below);
+    work.append(below.begin(), below.end());
+  }
+}
+
+void CallGraph::merge(const CallGraph& other) {
+  calls.insert(calls.end(), other.calls.begin(), other.calls.end());
+}
+
+void CallGraph::findReachable() {
+  uint32_t idCount = 0;
+  for (Identifier id : routines) {
+    idCount = std::max(idCount, id.id() + 1);
+  }
+  for (const Edge& c : calls) {
+    idCount = std::max({idCount, c.caller + 1, c.callee + 1});
+  }
+
+  // Group the calls by caller
+  llvm::stable_sort(calls, [](const Edge& a, const Edge& b) { return a.caller < b.caller; });
+  firstCall.assign(idCount + 1, 0);
+  sites.assign(idCount, 0);
+  for (const Edge& c : calls) {
+    firstCall[c.caller + 1]++;
+    sites[c.callee]++;
+  }
+  for (uint32_t i = 0; i < idCount; i++) {
+    firstCall[i + 1] += firstCall[i];
+  }
+
+  reachable.assign(idCount, 0);
+  auto program = llvm::find_if(routines, [](Identifier id) { return id.text() == "program"; });
+  if (program == routines.end()) {
+    for (Identifier id : routines) {
+      reachable[id.id()] = 1;
+    }
+    return;
+  }
+  llvm::SmallVector<uint32_t, 64> work{program->id()};
+  reachable[program->id()] = 1;
+  while (!work.empty()) {
+    uint32_t caller = work.pop_back_val();
+    for (uint32_t i = firstCall[caller]; i < firstCall[caller + 1]; i++) {
+      uint32_t callee = calls[i].callee;
+      if (!reachable[callee]) {
+        reachable[callee] = 1;
+        work.push_back(callee);
+      }
+    }
+  }
+}
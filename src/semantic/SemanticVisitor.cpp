@@ -10,278 +10,416 @@
  * 
  */
 #include "SemanticVisitor.h"
-#include <any>
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/TimeProfiler.h"
+#include <atomic>
 
-std::any SemanticVisitor::visitCompilationUnit(WPLParser::CompilationUnitContext *ctx) {
-  stmgr->enterScope();    // initial scope (only one for this example)
+using namespace ast;
+
+SymType SemanticVisitor::visitCompilationUnit(CompilationUnit *ctx) {
+  beginCompilationUnit();
+  if (threads != 1) {
+    checkInParallel(ctx);
+    return SymType::UNDEFINED;
+  }
   for (auto e : ctx->components) {
-    e->accept(this);
+    if (errors.full()) {
+      break;
+    }
+    visitComponent(e);
   }
   return SymType::UNDEFINED;
 }
 
-std::any SemanticVisitor::visitScalarDeclaration(WPLParser::ScalarDeclarationContext *ctx) {
-  SymType declaredtype = SymType::UNDEFINED;
-  if (ctx->t) declaredtype = std::any_cast<SymType>(ctx->t->accept(this));
-  for (WPLParser::ScalarContext* sctx : ctx->scalars)
+/**
+ * @brief Check the unit in two passes. The first declares, in source
+ *  order, the globals, the externs and the procedures and functions,
+ *  leaving out their bodies. The second checks the bodies on a thread
+ *  pool. A body sees the globals declared before its procedure or
+ *  function, as it does when checked in order, through a table of its
+ *  own that defers to the global one. The errors of each body go back
+ *  where a check in order would have reported them.
+ *
+ *  A body that assigns to a global of no type yet would give it its
+ *  type, which the bodies after it depend on. Those units are left to
+ *  a check in order: see needsSequentialCheck().
+ */
+void SemanticVisitor::checkInParallel(CompilationUnit *ctx) {
+  struct Body {
+    Routine* routine;
+    size_t globals;        // declarations visible to the body
+    size_t errorIndex;     // where its errors go among those of the first pass
+    size_t worker = 0;
+    size_t errorsBegin = 0, errorsEnd = 0;   // in the worker's errors
+  };
+  std::vector<Body> bodies;
+  for (Node* e : ctx->components) {
+    if (errors.full()) {
+      break;
+    }
+    Routine* routine = llvm::dyn_cast<Routine>(e);
+    if (routine == nullptr || reusedComponents.count(e)) {
+      visitComponent(e);
+      continue;
+    }
+    bodies.push_back({routine, stmgr->declarationCount(), errors.getErrors().size()});
+    declareRoutine(routine);
+  }
+  if (bodies.empty()) {
+    return;
+  }
+
+  llvm::ThreadPool pool(llvm::hardware_concurrency(threads));
+  size_t workerCount = std::min<size_t>(pool.getThreadCount(), bodies.size());
+  std::vector<std::unique_ptr<SemanticVisitor>> workers;
+  for (size_t w = 0; w < workerCount; w++) {
+    bodyTables.push_back(std::make_unique<STManager>());
+    workers.push_back(std::make_unique<SemanticVisitor>(bodyTables.back().get(), bindings));
+    workers.back()->errors.setLimit(errors.getLimit());
+  }
+  std::vector<CallGraph> workerCalls(calls != nullptr ? workerCount : 0);
+  for (size_t w = 0; w < workerCalls.size(); w++) {
+    workers[w]->calls = &workerCalls[w];
+  }
+  // Bodies are taken in source order, so once those taken have found as
+  // many errors as the limit, the errors of the rest would come too late
+  std::atomic<size_t> next(0);
+  std::atomic<size_t> found(0);
+  std::vector<AllocationCounts> workerCounts(workerCount);
+  for (size_t w = 0; w < workerCount; w++) {
+    pool.async([&, w] {
+      AllocationCounts start = MemoryAccounting::threadCounts();
+      SemanticVisitor& worker = *workers[w];
+      size_t limit = errors.getLimit();
+      for (size_t i = next++; i < bodies.size() && (limit == 0 || found < limit); i = next++) {
+        Body& body = bodies[i];
+        worker.stmgr->setGlobals(stmgr, body.globals);
+        body.worker = w;
+        body.errorsBegin = worker.errors.getErrors().size();
+        worker.checkBody(body.routine);
+        body.errorsEnd = worker.errors.getErrors().size();
+        found += body.errorsEnd - body.errorsBegin;
+      }
+      workerCounts[w] = MemoryAccounting::threadCountsSince(start);
+    });
+  }
+  pool.wait();
+  for (AllocationCounts& counts : workerCounts) {
+    workerAllocations.add(counts);
+  }
+
+  // Merge the errors of the bodies with those of the first pass
+  const std::vector<WPLError>& declared = errors.getErrors();
+  std::vector<WPLError> merged;
+  size_t d = 0;
+  for (Body& body : bodies) {
+    for (; d < body.errorIndex; d++) {
+      merged.push_back(declared[d]);
+    }
+    const std::vector<WPLError>& bodyErrors = workers[body.worker]->errors.getErrors();
+    merged.insert(merged.end(), bodyErrors.begin() + body.errorsBegin, bodyErrors.begin() + body.errorsEnd);
+  }
+  merged.insert(merged.end(), declared.begin() + d, declared.end());
+  errors.setErrors(std::move(merged));
+
+  for (CallGraph& graph : workerCalls) {
+    calls->merge(graph);
+  }
+  for (std::unique_ptr<SemanticVisitor>& worker : workers) {
+    for (Symbol* symbol : worker->definedGlobals) {
+      symbol->defined = true;
+    }
+    sequentialOnly = sequentialOnly || worker->sequentialOnly;
+  }
+}
+
+void SemanticVisitor::beginCompilationUnit() {
+  stmgr->enterScope();    // initial scope (only one for this example)
+}
+
+/**
+ * @brief Check one top-level component. Only the global symbols it adds
+ *  outlive it, so a streaming compile may free its AST afterwards.
+ */
+void SemanticVisitor::visitComponent(Node *ctx) {
+  if (reusedComponents.count(ctx)) {
+    Routine *routine = llvm::dyn_cast<Routine>(ctx);
+    if (calls != nullptr && routine != nullptr) {
+      calls->addCallsOf(routine);
+    }
+    declareComponent(ctx);
+  } else {
+    visit(ctx);
+  }
+}
+
+/**
+ * @brief Add only the global symbol for a procedure or function whose
+ *  body was checked in an earlier compile. Other components are visited
+ *  as usual.
+ */
+void SemanticVisitor::declareComponent(Node *ctx) {
+  Routine *decl = llvm::dyn_cast<Routine>(ctx);
+  if (decl == nullptr) {
+    visit(ctx);
+    return;
+  }
+  declareRoutine(decl);
+}
+
+// The global symbol of a procedure or function, added after its body
+// is checked, so that a body cannot call itself
+void SemanticVisitor::declareRoutine(Routine *decl) {
+  Identifier id = decl->id;
+  SymType t = symTypeFromTypeName(decl->t);
+
+  Symbol *symbol = stmgr->findSymbol(id);
+  if (symbol == nullptr) {
+    symbol = stmgr->addSymbol(id, t);
+    bindings->bind(decl, symbol);
+    if (calls != nullptr) {
+      calls->addRoutine(id);
+    }
+  } else {
+    addError(decl, decl->kind == Kind::Procedure ? ErrCode::PROCEDURE_REDEFINITION : ErrCode::FUNCTION_REDEFINITION, id);
+  }
+}
+
+SymType SemanticVisitor::visitScalarDeclaration(ScalarDeclaration *ctx) {
+  SymType declaredtype = symTypeFromTypeName(ctx->t);
+  for (Scalar* sctx : ctx->scalars)
   {
     // if assignment, check type
     if (sctx->vi)
     {
-      SymType t = std::any_cast<SymType>(sctx->vi->c->accept(this));
-      std::string constant = sctx->vi->c->getText();
+      SymType t = visit(sctx->vi);
       if (declaredtype == SymType::UNDEFINED)
       {
         declaredtype = t;
       }
       else if (declaredtype != t)
       {
-        errors.addSemanticError(ctx->getStart(), "scalar declaration type mismatch. expected type " + Symbol::getSymTypeName(declaredtype) + ", got type " + Symbol::getSymTypeName(t) + " (" + constant + ")");
+        addError(ctx, ErrCode::SCALAR_TYPE_MISMATCH, Identifier(), sctx->vi, declaredtype, t);
       }
     }
     // create binding
-    std::string id = sctx->id->getText();
+    Identifier id = sctx->id;
     Symbol *symbol = stmgr->findSymbol(id);
     if (symbol == nullptr) {
       symbol = stmgr->addSymbol(id, declaredtype);
       bindings->bind(sctx, symbol);
     } else {
-      errors.addSemanticError(ctx->getStart(), "variable redeclaration: " + id);
+      addError(ctx, ErrCode::VARIABLE_REDECLARATION, id);
     }
   }
 
   return declaredtype;
 }
 
-std::any SemanticVisitor::visitArrayDeclaration(WPLParser::ArrayDeclarationContext *ctx) {
+SymType SemanticVisitor::visitArrayDeclaration(ArrayDeclaration *ctx) {
   return SymType::UNDEFINED;
 }
 
-std::any SemanticVisitor::visitType(WPLParser::TypeContext *ctx) {
-  SymType t = SymType::UNDEFINED;
-  if (ctx->BOOL())
-  {
-    t = SymType::BOOL;
+SymType SemanticVisitor::symTypeFromTypeName(TypeName t) {
+  switch (t) {
+    case TypeName::BOOL: return SymType::BOOL;
+    case TypeName::INT: return SymType::INT;
+    case TypeName::STR: return SymType::STR;
+    default: return SymType::UNDEFINED;
   }
-  else if (ctx->INT())
-  {
-    t = SymType::INT;
-  }
-  else if (ctx->STR())
-  {
-    t = SymType::STR;
-  }
-  return t;
 }
 
-std::any SemanticVisitor::visitProcedure(WPLParser::ProcedureContext *ctx) {
-  std::string id = ctx->ph->id->getText();
-
-  stmgr->enterScope();
-  if (ctx->ph->p)
+// Parameters are defined on entry, in the scope of the body
+void SemanticVisitor::declareParams(llvm::ArrayRef<Param*> params) {
+  for (Param* p : params)
   {
-    for (unsigned long i = 0; i < ctx->ph->p->types.size(); i++)
-    {
-      std::string id = ctx->ph->p->ids[i]->getText();
-      SymType t = std::any_cast<SymType>(ctx->ph->p->types[i]->accept(this));
-      Symbol* sym = stmgr->addSymbol(id, t);
-      bindings->bind(ctx->ph->p->ids[i], sym);
-      sym->defined = true;
-    }
+    Identifier id = p->id;
+    SymType t = symTypeFromTypeName(p->t);
+    Symbol* sym = stmgr->addSymbol(id, t);
+    bindings->bind(p, sym);
+    sym->defined = true;
   }
-  ctx->b->accept(this);
-  stmgr->exitScope();
-
-  Symbol *symbol = stmgr->findSymbol(id);
-  if (symbol == nullptr) {
-    symbol = stmgr->addSymbol(id, SymType::UNDEFINED);
-    bindings->bind(ctx, symbol);
-  } else {
-    errors.addSemanticError(ctx->getStart(), "procedure redefinition: " + id);
-  }
-  return SymType::UNDEFINED;
 }
 
-std::any SemanticVisitor::visitExternProcHeader(WPLParser::ExternProcHeaderContext *ctx) {
-  std::string id = ctx->id->getText();
-  Symbol *symbol = stmgr->findSymbol(id);
-  if (symbol == nullptr) {
-    symbol = stmgr->addSymbol(id, SymType::UNDEFINED);
-    bindings->bind(ctx, symbol);
-  } else {
-    errors.addSemanticError(ctx->getStart(), "procedure redefinition: " + id);
-  }
+SymType SemanticVisitor::visitProcedure(Routine *ctx) {
+  checkBody(ctx);
+  declareRoutine(ctx);
   return SymType::UNDEFINED;
 }
 
-std::any SemanticVisitor::visitFunction(WPLParser::FunctionContext *ctx) {
-  SymType t = std::any_cast<SymType>(ctx->fh->t->accept(this));
-  std::string id = ctx->fh->id->getText();
+void SemanticVisitor::checkBody(Routine *ctx) {
+  llvm::TimeTraceScope timeScope(ctx->kind == Kind::Procedure ? "Semantic procedure" : "Semantic function",
+    ctx->id.text());
 
+  currentRoutine = ctx->id;
   stmgr->enterScope();
-  if (ctx->fh->p)
-  {
-    for (unsigned long i = 0; i < ctx->fh->p->types.size(); i++)
-    {
-      std::string id = ctx->fh->p->ids[i]->getText();
-      SymType t = std::any_cast<SymType>(ctx->fh->p->types[i]->accept(this));
-      Symbol* sym = stmgr->addSymbol(id, t);
-      bindings->bind(ctx->fh->p->ids[i], sym);
-      sym->defined = true;
-    }
-  }
-  ctx->b->accept(this);
+  declareParams(ctx->params);
+  visit(ctx->b);
   stmgr->exitScope();
+  currentRoutine = Identifier();
+}
+
+SymType SemanticVisitor::visitExternDeclaration(ExternDeclaration *ctx) {
+  SymType t = symTypeFromTypeName(ctx->t);
+  Identifier id = ctx->id;
 
   Symbol *symbol = stmgr->findSymbol(id);
   if (symbol == nullptr) {
     symbol = stmgr->addSymbol(id, t);
     bindings->bind(ctx, symbol);
   } else {
-    errors.addSemanticError(ctx->getStart(), "function redefinition: " + id);
+    errors.addSemanticError(ctx->header.line, ctx->header.column,
+      ctx->kind == Kind::ExternProcedure ? ErrCode::PROCEDURE_REDEFINITION : ErrCode::FUNCTION_REDEFINITION, id);
   }
   return t;
 }
 
-std::any SemanticVisitor::visitBlock(WPLParser::BlockContext *ctx) {
+SymType SemanticVisitor::visitFunction(Routine *ctx) {
+  checkBody(ctx);
+  declareRoutine(ctx);
+  return symTypeFromTypeName(ctx->t);
+}
+
+SymType SemanticVisitor::visitBlock(Block *ctx) {
   stmgr->enterScope();
   visitChildren(ctx);
   stmgr->exitScope();
   return SymType::UNDEFINED;
 }
 
-std::any SemanticVisitor::visitExternFuncHeader(WPLParser::ExternFuncHeaderContext *ctx) {
-  SymType t = std::any_cast<SymType>(ctx->t->accept(this));
-  std::string id = ctx->id->getText();
-
-  Symbol *symbol = stmgr->findSymbol(id);
-  if (symbol == nullptr) {
-    symbol = stmgr->addSymbol(id, t);
-    bindings->bind(ctx, symbol);
-  } else {
-    errors.addSemanticError(ctx->getStart(), "function redefinition: " + id);
-  }
-  return t;
-}
-
-std::any SemanticVisitor::visitSelectAlt(WPLParser::SelectAltContext *ctx) {
-  SymType et = std::any_cast<SymType>(ctx->e->accept(this));
-  ctx->s->accept(this);
+SymType SemanticVisitor::visitSelectAlt(SelectAlt *ctx) {
+  SymType et = visit(ctx->e);
+  visit(ctx->s);
   if (et != SymType::BOOL)
   {
-    errors.addSemanticError(ctx->getStart(), "expected a boolean expression, got " + ctx->e->getText());
+    addError(ctx, ErrCode::EXPECTED_BOOLEAN_EXPRESSION, Identifier(), ctx->e);
   }
   return SymType::UNDEFINED;
 }
 
-std::any SemanticVisitor::visitCall(WPLParser::CallContext *ctx) {
-    std::string id = ctx->id->getText();
+SymType SemanticVisitor::visitCall(Call *ctx) {
+    Identifier id = ctx->id;
     Symbol *symbol = stmgr->findSymbol(id);
     SymType t = SymType::UNDEFINED;
+    recordCall(id);
     if (symbol == nullptr)
     {
-      errors.addSemanticError(ctx->getStart(), id + " undeclared.");
+      addError(ctx, ErrCode::UNDECLARED, id);
     }
     else
     {
       t = symbol->type;
     }
     // TODO make sure its actually a function
-    if (ctx->arguments())
+    for (Expr* arg : ctx->args)
     {
-      for (WPLParser::ArgContext* arg : ctx->arguments()->args)
-      {
-      // TODO check that args are supposed to be there
-        arg->accept(this);
-      }
+    // TODO check that args are supposed to be there
+      visit(arg);
     }
     return t;
 }
 
-std::any SemanticVisitor::visitReturn(WPLParser::ReturnContext *ctx) {
+SymType SemanticVisitor::visitReturn(Return *ctx) {
   SymType t = SymType::UNDEFINED;
-  if (ctx->expr()) {
-    t = std::any_cast<SymType>(ctx->expr()->accept(this));
+  if (ctx->e) {
+    t = visit(ctx->e);
   }
   // TODO: Check that this matches parent function type
   return t;
 }
 
-std::any SemanticVisitor::visitConstant(WPLParser::ConstantContext *ctx) {
+SymType SemanticVisitor::visitConstant(Constant *ctx) {
   SymType t = SymType::UNDEFINED;
-  if (ctx->BOOLEAN())
+  if (ctx->constantKind == ConstantKind::BOOLEAN)
   {
     t = SymType::BOOL;
+    bindings->setConstant(ctx, ctx->text == "true");
   }
-  else if (ctx->INTEGER())
+  else if (ctx->constantKind == ConstantKind::INTEGER)
   {
     t = SymType::INT;
+    // Literals that do not fit are left to the code generator to reject
+    int32_t value;
+    if (!ctx->text.getAsInteger(10, value))
+    {
+      bindings->setConstant(ctx, value);
+    }
   }
-  else if (ctx->STRING())
+  else if (ctx->constantKind == ConstantKind::STRING)
   {
     t = SymType::STR;
   }
   return t;
 }
 
-std::any SemanticVisitor::visitAssignment(WPLParser::AssignmentContext *ctx) {
+SymType SemanticVisitor::visitAssignment(Assignment *ctx) {
   SymType t = SymType::UNDEFINED;
 
   if (ctx->targets.size() != ctx->exprs.size())
   {
-    errors.addSemanticError(ctx->getStart(), "Expected equal number of target/expression pairs in assignment expression.");
+    addError(ctx, ErrCode::ASSIGNMENT_COUNT);
     return t;
   }
 
   for (unsigned long i = 0; i < ctx->targets.size(); i++)
   {
-    std::string id = ctx->targets[i]->getText();
+    Identifier id = ctx->targets[i];
     Symbol *symbol = stmgr->findSymbol(id);
     if (symbol != nullptr)
     {
       bindings->bind(ctx, symbol);
-      symbol->defined = true;
+      if (stmgr->isGlobal(symbol))
+      {
+        // Set once all the bodies are checked
+        definedGlobals.push_back(symbol);
+      }
+      else
+      {
+        symbol->defined = true;
+      }
     }
     else
     {
-      errors.addSemanticError(ctx->getStart(), id + " undeclared.");
+      addError(ctx, ErrCode::UNDECLARED, id);
       return t;
     }
 
-    t = std::any_cast<SymType>(ctx->exprs[i]->accept(this));
+    t = visit(ctx->exprs[i]);
 
-    if (symbol->type == SymType::UNDEFINED)
+    if (symbol->type == SymType::UNDEFINED && stmgr->isGlobal(symbol))
+    {
+      sequentialOnly = true;
+    }
+    else if (symbol->type == SymType::UNDEFINED)
     {
       symbol->type = t;
     }
     else if (symbol->type != t)
     {
-      errors.addSemanticError(ctx->getStart(), id + "Type mismatch. Expected " + Symbol::getSymTypeName(symbol->type) + ", got " +  Symbol::getSymTypeName(t));
+      addError(ctx, ErrCode::ASSIGNMENT_TYPE_MISMATCH, id, nullptr, symbol->type, t);
     }
   }
   return t;
 }
 
-std::any SemanticVisitor::visitArrayIndex(WPLParser::ArrayIndexContext *ctx) {
+SymType SemanticVisitor::visitArrayAssignment(ArrayAssignment *ctx) {
   return SymType::UNDEFINED;
 }
 
-std::any SemanticVisitor::visitAndExpr(WPLParser::AndExprContext *ctx) {
-  SymType leftt = std::any_cast<SymType>(ctx->left->accept(this));
-  SymType rightt = std::any_cast<SymType>(ctx->right->accept(this));
+SymType SemanticVisitor::visitAndExpr(BinaryExpr *ctx, SymType leftt, SymType rightt) {
   if (leftt != SymType::BOOL || rightt != SymType::BOOL)
   {
-    errors.addSemanticError(ctx->getStart(), "cannot AND " + Symbol::getSymTypeName(leftt) + "(" + ctx->left->getText() + ") with " + Symbol::getSymTypeName(rightt) + " (" + ctx->right->getText() + "). booleans only.");
+    addError(ctx, ErrCode::CANNOT_AND, Identifier(), ctx, leftt, rightt);
   }
   return SymType::BOOL;
 }
 
-std::any SemanticVisitor::visitIDExpr(WPLParser::IDExprContext *ctx) {
-  std::string id = ctx->ID()->getText();
+SymType SemanticVisitor::visitIDExpr(IDExpr *ctx) {
+  Identifier id = ctx->id;
   Symbol *symbol = stmgr->findSymbol(id);
   SymType t = SymType::UNDEFINED;
   if (symbol == nullptr) {
-    errors.addSemanticError(ctx->getStart(), id + " undeclared.");
+    addError(ctx, ErrCode::UNDECLARED, id);
   } else {
     t = symbol->type;
     bindings->bind(ctx, symbol);
@@ -289,127 +427,110 @@ std::any SemanticVisitor::visitIDExpr(WPLParser::IDExprContext *ctx) {
   return t;
 }
 
-std::any SemanticVisitor::visitSubscriptExpr(WPLParser::SubscriptExprContext *ctx) {
-  return SymType::UNDEFINED;
+// A call is looked up before its arguments are checked, and arrays are
+// not checked at all
+bool SemanticVisitor::enterExpr(Expr *ctx, SymType &result) {
+  if (CallExpr* call = llvm::dyn_cast<CallExpr>(ctx)) {
+    recordCall(call->id);
+    if (stmgr->findSymbol(call->id) == nullptr) {
+      addError(ctx, ErrCode::UNDECLARED, call->id);
+    }
+  } else if (llvm::isa<SubscriptExpr>(ctx)) {
+    result = SymType::UNDEFINED;
+    return false;
+  }
+  return true;
 }
 
-std::any SemanticVisitor::visitRelExpr(WPLParser::RelExprContext *ctx) {
-  SymType leftt = std::any_cast<SymType>(ctx->left->accept(this));
-  SymType rightt = std::any_cast<SymType>(ctx->right->accept(this));
+SymType SemanticVisitor::visitRelExpr(BinaryExpr *ctx, SymType leftt, SymType rightt) {
   if (leftt != SymType::INT || rightt != SymType::INT)
   {
-    errors.addSemanticError(ctx->getStart(), "cannot compare " + Symbol::getSymTypeName(leftt) + "(" + ctx->left->getText() + ") with " + Symbol::getSymTypeName(rightt) + " (" + ctx->right->getText() + "). integers only.");
+    addError(ctx, ErrCode::CANNOT_COMPARE_INTEGERS, Identifier(), ctx, leftt, rightt);
   }
   return SymType::BOOL;
 }
 
-std::any SemanticVisitor::visitMultExpr(WPLParser::MultExprContext *ctx) {
-  SymType leftt = std::any_cast<SymType>(ctx->left->accept(this));
-  SymType rightt = std::any_cast<SymType>(ctx->right->accept(this));
+SymType SemanticVisitor::visitMultExpr(BinaryExpr *ctx, SymType leftt, SymType rightt) {
   if (leftt != SymType::INT || rightt != SymType::INT)
   {
-    errors.addSemanticError(ctx->getStart(), "cannot multiply/divide " + Symbol::getSymTypeName(leftt) + "(" + ctx->left->getText() + ") with " + Symbol::getSymTypeName(rightt) + " (" + ctx->right->getText() + "). integers only.");
+    addError(ctx, ErrCode::CANNOT_MULTIPLY, Identifier(), ctx, leftt, rightt);
   }
   return SymType::INT;
 }
 
-std::any SemanticVisitor::visitAddExpr(WPLParser::AddExprContext *ctx) {
-  SymType leftt = std::any_cast<SymType>(ctx->left->accept(this));
-  SymType rightt = std::any_cast<SymType>(ctx->right->accept(this));
+SymType SemanticVisitor::visitAddExpr(BinaryExpr *ctx, SymType leftt, SymType rightt) {
   if (leftt != SymType::INT || rightt != SymType::INT)
   {
-    errors.addSemanticError(ctx->getStart(), "cannot add/subtract " + Symbol::getSymTypeName(leftt) + "(" + ctx->left->getText() + ") with " + Symbol::getSymTypeName(rightt) + " (" + ctx->right->getText() + "). integers only.");
+    addError(ctx, ErrCode::CANNOT_ADD, Identifier(), ctx, leftt, rightt);
   }
   return SymType::INT;
 }
 
-std::any SemanticVisitor::visitArrayLengthExpr(WPLParser::ArrayLengthExprContext *ctx) {
+SymType SemanticVisitor::visitArrayLengthExpr(ArrayLengthExpr *ctx) {
   return SymType::UNDEFINED;
 }
 
-std::any SemanticVisitor::visitUMinusExpr(WPLParser::UMinusExprContext *ctx) {
-  SymType e = std::any_cast<SymType>(ctx->e->accept(this));
+SymType SemanticVisitor::visitUMinusExpr(UnaryExpr *ctx, SymType e) {
   if (e != SymType::INT)
   {
-    errors.addSemanticError(ctx->getStart(), "expected int, got " + ctx->e->getText());
+    addError(ctx, ErrCode::EXPECTED_INT, Identifier(), ctx);
   }
   return SymType::INT;
 }
 
-std::any SemanticVisitor::visitOrExpr(WPLParser::OrExprContext *ctx) {
-  SymType leftt = std::any_cast<SymType>(ctx->left->accept(this));
-  SymType rightt = std::any_cast<SymType>(ctx->right->accept(this));
+SymType SemanticVisitor::visitOrExpr(BinaryExpr *ctx, SymType leftt, SymType rightt) {
   if (leftt != SymType::BOOL || rightt != SymType::BOOL)
   {
-    errors.addSemanticError(ctx->getStart(), "cannot OR " + Symbol::getSymTypeName(leftt) + "(" + ctx->left->getText() + ") with " + Symbol::getSymTypeName(rightt) + " (" + ctx->right->getText() + "). booleans only.");
+    addError(ctx, ErrCode::CANNOT_OR, Identifier(), ctx, leftt, rightt);
   }
   return SymType::BOOL;
 }
 
-std::any SemanticVisitor::visitEqExpr(WPLParser::EqExprContext *ctx) {
-  SymType leftt = std::any_cast<SymType>(ctx->left->accept(this));
-  SymType rightt = std::any_cast<SymType>(ctx->right->accept(this));
+SymType SemanticVisitor::visitEqExpr(BinaryExpr *ctx, SymType leftt, SymType rightt) {
   if (leftt != rightt)
   {
-    errors.addSemanticError(ctx->getStart(), "cannot compare " + Symbol::getSymTypeName(leftt) + "(" + ctx->left->getText() + ") with " + Symbol::getSymTypeName(rightt) + " (" + ctx->right->getText() + "). must be same type.");
+    addError(ctx, ErrCode::CANNOT_COMPARE_TYPES, Identifier(), ctx, leftt, rightt);
   }
   return SymType::BOOL;
 }
 
-std::any SemanticVisitor::visitFuncProcCallExpr(WPLParser::FuncProcCallExprContext *ctx) {
-  std::string id = ctx->fpname->getText();
-  Symbol *symbol = stmgr->findSymbol(id);
-  SymType t = SymType::UNDEFINED;
-  if (symbol == nullptr) {
-    errors.addSemanticError(ctx->getStart(), id + " undeclared.");
-  } else {
-    t = symbol->type;
-  } 
-
-  for (WPLParser::ExprContext* arg : ctx->args)
-  {
+SymType SemanticVisitor::visitFuncProcCallExpr(CallExpr *ctx, llvm::ArrayRef<SymType> args) {
   // TODO check that args are supposed to be there
-    arg->accept(this);
-  }
-  return t;
+  Symbol *symbol = stmgr->findSymbol(ctx->id);
+  return symbol == nullptr ? SymType::UNDEFINED : symbol->type;
 }
 
-std::any SemanticVisitor::visitNotExpr(WPLParser::NotExprContext *ctx) {
-  SymType e = std::any_cast<SymType>(ctx->e->accept(this));
+SymType SemanticVisitor::visitNotExpr(UnaryExpr *ctx, SymType e) {
   if (e != SymType::BOOL)
   {
-    errors.addSemanticError(ctx->getStart(), "expected boolean, got " + ctx->e->getText());
+    addError(ctx, ErrCode::EXPECTED_BOOLEAN, Identifier(), ctx);
   }
   return SymType::BOOL;
 }
 
-std::any SemanticVisitor::visitLoop(WPLParser::LoopContext *ctx) {
-  SymType condt = std::any_cast<SymType>(ctx->e->accept(this));
+SymType SemanticVisitor::visitLoop(Loop *ctx) {
+  SymType condt = visit(ctx->e);
   if (condt != SymType::BOOL)
   {
-    errors.addSemanticError(ctx->getStart(), "expected boolean expression for loop condition. got " + Symbol::getSymTypeName(condt));
+    addError(ctx, ErrCode::LOOP_CONDITION, Identifier(), nullptr, condt);
   }
   
-  ctx->block()->accept(this);
+  visit(ctx->b);
   return SymType::UNDEFINED;
 }
 
-std::any SemanticVisitor::visitConditional(WPLParser::ConditionalContext *ctx) {
-  SymType condt = std::any_cast<SymType>(ctx->e->accept(this));
+SymType SemanticVisitor::visitConditional(Conditional *ctx) {
+  SymType condt = visit(ctx->e);
   if (condt != SymType::BOOL)
   {
-    errors.addSemanticError(ctx->getStart(), "expected boolean expression for 'if' condition. got " + Symbol::getSymTypeName(condt));
+    addError(ctx, ErrCode::IF_CONDITION, Identifier(), nullptr, condt);
   }
   
-  ctx->yesblock->accept(this);
+  visit(ctx->yesblock);
   if (ctx->noblock)
   {
-    ctx->noblock->accept(this);
+    visit(ctx->noblock);
   }
 
   return SymType::UNDEFINED;
 }
-
-std::any SemanticVisitor::visitParenExpr(WPLParser::ParenExprContext *ctx) {
-  return std::any_cast<SymType>(ctx->expr()->accept(this));
-}
@@ -0,0 +1,60 @@
+/**
+ * @file CallGraph.h
+ * @author nllopez
+ * @brief The calls between the procedures and functions of a unit, as
+ *  the semantic pass finds them, and which of them program can reach.
+ *  The code generator leaves out the ones it cannot.
+ *
+ *  Routines and calls are keyed by identifier id, as the code generator
+ *  finds the function of a call by name, so the graph outlives the
+ *  trees of a streaming compile. A routine can only call those declared
+ *  before it, so the graph has no cycles.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "AST.h"
+#include <cstdint>
+#include <vector>
+
+class CallGraph {
+  public:
+    // A procedure or function, in source order
+    void addRoutine(ast::Identifier id) { routines.push_back(id); }
+    void addCall(ast::Identifier caller, ast::Identifier callee) {
+      calls.push_back({caller.id(), callee.id()});
+    }
+    // The calls in the body of a routine that is not checked again
+    void addCallsOf(ast::Routine* routine);
+    // The calls another graph found, for bodies checked in parallel
+    void merge(const CallGraph& other);
+
+    // Mark the routines program reaches, or all of them if there is no
+    // program, as in a unit that is linked into another
+    void findReachable();
+    bool isReachable(ast::Identifier id) const {
+      return id.id() < reachable.size() && reachable[id.id()];
+    }
+    // Calls to a routine and calls it makes, after findReachable()
+    unsigned callSites(ast::Identifier id) const {
+      return id.id() < sites.size() ? sites[id.id()] : 0;
+    }
+    unsigned callsFrom(ast::Identifier id) const {
+      return id.id() + 1 < firstCall.size() ? firstCall[id.id() + 1] - firstCall[id.id()] : 0;
+    }
+    const std::vector<ast::Identifier>& getRoutines() const { return routines; }
+
+  private:
+    struct Edge {
+      uint32_t caller;
+      uint32_t callee;
+    };
+
+    std::vector<ast::Identifier> routines;
+    std::vector<Edge> calls;
+    // Filled by findReachable(), indexed by identifier id. The calls of
+    // a caller are calls[firstCall[id], firstCall[id + 1]).
+    std::vector<uint32_t> firstCall;
+    std::vector<uint8_t> reachable;
+    std::vector<unsigned> sites;
+};
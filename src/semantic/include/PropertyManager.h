@@ -1,7 +1,7 @@
 /**
  * @file PropertyManager.h
  * @author your name (you@domain.com)
- * @brief Handles all of the ParseTreeProperties. This will be created in the driver and
+ * @brief Handles all of the properties of the AST nodes. This will be created in the driver and
  *  made available to whatever class needs it.
  * @version 0.1
  * @date 2022-07-23
@@ -10,20 +10,78 @@
  */
 #pragma once
 #include "Symbol.h"
-#include "antlr4-runtime.h"
+#include "AST.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
 
+/**
+ * @brief The properties the semantic pass computes for the nodes, kept
+ *  in one flat array per property and indexed by Node::index, so that
+ *  the code generator reads them without hashing.
+ *
+ *  - binding: the symbol a declaration, assignment or name refers to
+ *  - type: the type of every expression, as the semantic pass found it
+ *  - constant: the value of an integer or boolean literal
+ */
 class PropertyManager {
   public:
+    // Make room for the nodes of a tree up front
+    void reserve(uint32_t nodeCount) {
+      if (nodeCount > bindings.size()) {
+        bindings.resize(nodeCount, nullptr);
+        types.resize(nodeCount, SymType::UNDEFINED);
+        constants.resize(nodeCount, 0);
+        hasConstant.resize(nodeCount, 0);
+      }
+    }
+
     // Get the Symbol associated with this node
-    Symbol* getBinding(antlr4::ParserRuleContext *ctx) {
-      return bindings.get(ctx);
+    Symbol* getBinding(const ast::Node *ctx) const {
+      return ctx->index < bindings.size() ? bindings[ctx->index] : nullptr;
     }
 
     // Bind the symbol to the node
-    void bind(antlr4::ParserRuleContext *ctx, Symbol* symbol) {
-      bindings.put(ctx, symbol);
+    void bind(const ast::Node *ctx, Symbol* symbol) {
+      reserve(ctx->index + 1);
+      bindings[ctx->index] = symbol;
+    }
+
+    SymType getType(const ast::Expr *ctx) const {
+      return ctx->index < types.size() ? types[ctx->index] : SymType::UNDEFINED;
+    }
+
+    void setType(const ast::Expr *ctx, SymType t) {
+      reserve(ctx->index + 1);
+      types[ctx->index] = t;
+    }
+
+    // The value of a literal, if the semantic pass could compute it
+    bool getConstant(const ast::Constant *ctx, int32_t &value) const {
+      if (ctx->index >= hasConstant.size() || !hasConstant[ctx->index]) {
+        return false;
+      }
+      value = constants[ctx->index];
+      return true;
+    }
+
+    void setConstant(const ast::Constant *ctx, int32_t value) {
+      reserve(ctx->index + 1);
+      constants[ctx->index] = value;
+      hasConstant[ctx->index] = 1;
+    }
+
+    // Forget every property, before the nodes they belong to are freed.
+    // The arrays keep their memory for the next tree.
+    void clear() {
+      std::fill(bindings.begin(), bindings.end(), nullptr);
+      std::fill(types.begin(), types.end(), SymType::UNDEFINED);
+      std::fill(hasConstant.begin(), hasConstant.end(), 0);
     }
 
   private:
-    antlr4::tree::ParseTreeProperty<Symbol*> bindings;
-};
\ No newline at end of file
+    std::vector<Symbol*> bindings;
+    std::vector<SymType> types;
+    std::vector<int32_t> constants;
+    std::vector<uint8_t> hasConstant;    // bytes, so threads never write the same one
+};
@@ -9,13 +9,17 @@
  * 
  */
 #pragma once
-#include "antlr4-runtime.h"
-#include "WPLBaseVisitor.h"
+#include "ASTVisitor.h"
+#include "CallGraph.h"
 #include "STManager.h"
 #include "PropertyManager.h"
 #include "WPLErrorHandler.h"
+#include "MemoryAccounting.h"
+#include <memory>
+#include <set>
+#include <vector>
 
-class SemanticVisitor : WPLBaseVisitor {
+class SemanticVisitor : public ASTVisitor<SemanticVisitor, SymType> {
   public :
     // Pass in the appropriate elements
     SemanticVisitor(STManager* stm, PropertyManager* pm) {
@@ -23,45 +27,101 @@ class SemanticVisitor : WPLBaseVisitor {
       bindings = pm;
     }
 
-    std::any visitCompilationUnit(WPLParser::CompilationUnitContext *ctx) override;
-    std::any visitScalarDeclaration(WPLParser::ScalarDeclarationContext *ctx) override;
-    std::any visitArrayDeclaration(WPLParser::ArrayDeclarationContext *ctx) override;
-    std::any visitType(WPLParser::TypeContext *ctx) override;
-    std::any visitProcedure(WPLParser::ProcedureContext *ctx) override;
-    std::any visitExternProcHeader(WPLParser::ExternProcHeaderContext *ctx) override;
-    std::any visitFunction(WPLParser::FunctionContext *ctx) override;
-    std::any visitBlock(WPLParser::BlockContext *ctx) override;
-    std::any visitExternFuncHeader(WPLParser::ExternFuncHeaderContext *ctx) override;
-    std::any visitSelectAlt(WPLParser::SelectAltContext *ctx) override;
-    std::any visitCall(WPLParser::CallContext *ctx) override;
-    // std::any visitArg(WPLParser::ArgContext *ctx) override;
-    std::any visitReturn(WPLParser::ReturnContext *ctx) override;
-    std::any visitConstant(WPLParser::ConstantContext *ctx) override;
-    std::any visitAssignment(WPLParser::AssignmentContext *ctx) override;
-    std::any visitArrayIndex(WPLParser::ArrayIndexContext *ctx) override;
-    std::any visitAndExpr(WPLParser::AndExprContext *ctx) override;
-    std::any visitIDExpr(WPLParser::IDExprContext *ctx) override;
-    std::any visitSubscriptExpr(WPLParser::SubscriptExprContext *ctx) override;
-    std::any visitRelExpr(WPLParser::RelExprContext *ctx) override;
-    std::any visitMultExpr(WPLParser::MultExprContext *ctx) override;
-    std::any visitAddExpr(WPLParser::AddExprContext *ctx) override;
-    std::any visitArrayLengthExpr(WPLParser::ArrayLengthExprContext *ctx) override;
-    std::any visitUMinusExpr(WPLParser::UMinusExprContext *ctx) override;
-    std::any visitOrExpr(WPLParser::OrExprContext *ctx) override;
-    std::any visitEqExpr(WPLParser::EqExprContext *ctx) override;
-    std::any visitFuncProcCallExpr(WPLParser::FuncProcCallExprContext *ctx) override;
-    std::any visitNotExpr(WPLParser::NotExprContext *ctx) override;
-    std::any visitLoop(WPLParser::LoopContext *ctx) override;
-    std::any visitConditional(WPLParser::ConditionalContext *ctx) override;
-    std::any visitParenExpr(WPLParser::ParenExprContext *ctx) override;
+    SymType visitCompilationUnit(ast::CompilationUnit *ctx);
+    SymType visitScalarDeclaration(ast::ScalarDeclaration *ctx);
+    SymType visitArrayDeclaration(ast::ArrayDeclaration *ctx);
+    SymType visitProcedure(ast::Routine *ctx);
+    SymType visitExternDeclaration(ast::ExternDeclaration *ctx);
+    SymType visitFunction(ast::Routine *ctx);
+    SymType visitBlock(ast::Block *ctx);
+    SymType visitSelectAlt(ast::SelectAlt *ctx);
+    SymType visitCall(ast::Call *ctx);
+    SymType visitReturn(ast::Return *ctx);
+    SymType visitConstant(ast::Constant *ctx);
+    SymType visitAssignment(ast::Assignment *ctx);
+    SymType visitArrayAssignment(ast::ArrayAssignment *ctx);
+    SymType visitAndExpr(ast::BinaryExpr *ctx, SymType leftt, SymType rightt);
+    SymType visitIDExpr(ast::IDExpr *ctx);
+    bool enterExpr(ast::Expr *ctx, SymType &result);
+    // Record the type of every expression for the code generator
+    void leaveExpr(ast::Expr *ctx, SymType t) { bindings->setType(ctx, t); }
+    SymType visitRelExpr(ast::BinaryExpr *ctx, SymType leftt, SymType rightt);
+    SymType visitMultExpr(ast::BinaryExpr *ctx, SymType leftt, SymType rightt);
+    SymType visitAddExpr(ast::BinaryExpr *ctx, SymType leftt, SymType rightt);
+    SymType visitArrayLengthExpr(ast::ArrayLengthExpr *ctx);
+    SymType visitUMinusExpr(ast::UnaryExpr *ctx, SymType e);
+    SymType visitOrExpr(ast::BinaryExpr *ctx, SymType leftt, SymType rightt);
+    SymType visitEqExpr(ast::BinaryExpr *ctx, SymType leftt, SymType rightt);
+    SymType visitFuncProcCallExpr(ast::CallExpr *ctx, llvm::ArrayRef<SymType> args);
+    SymType visitNotExpr(ast::UnaryExpr *ctx, SymType e);
+    SymType visitLoop(ast::Loop *ctx);
+    SymType visitConditional(ast::Conditional *ctx);
+
+    static SymType symTypeFromTypeName(ast::TypeName t);
+
+    // A compile that streams the components calls beginCompilationUnit()
+    // once and then visitComponent() for each one in source order
+    void beginCompilationUnit();
+    void visitComponent(ast::Node *ctx);
+
+    // Procedures and functions whose bodies are not analyzed again
+    void setReusedComponents(std::set<ast::Node*> reused) { reusedComponents = reused; }
+    void declareComponent(ast::Node *ctx);
+
+    // Check the bodies of procedures and functions on this many threads
+    // (0 = one per core). The properties must already have room for
+    // every node of the tree.
+    void setThreads(unsigned count) { threads = count; }
+    // True if the bodies were checked in parallel but the result may
+    // differ from a check in order; check the unit again on one thread
+    bool needsSequentialCheck() { return sequentialOnly; }
+    // What the threads that checked bodies allocated, for -mem-report
+    const AllocationCounts& getWorkerAllocations() const { return workerAllocations; }
+
+    // Record the procedures and functions and the calls between them
+    void setCallGraph(CallGraph* graph) { calls = graph; }
+
+    // Check the body of a procedure or function without declaring it
+    void checkBody(ast::Routine *ctx);
+
+    // Stop once this many errors are found (0 = never)
+    void setErrorLimit(size_t n) { errors.setLimit(n); }
+    bool errorLimitReached() const { return errors.full(); }
+    // Turn the errors found so far into text before their tree goes
+    void keepErrorText() { errors.keepText(); }
 
     std::string getErrors() { return errors.errorList(); }
+    const std::vector<WPLError>& getErrorList() const { return errors.getErrors(); }
     STManager* getSTManager() { return stmgr; }
     PropertyManager* getBindings() { return bindings; }
     bool hasErrors() { return errors.hasErrors(); }
 
   private: 
+    void addError(ast::Node *ctx, ErrCode code, ast::Identifier id = ast::Identifier(),
+        const ast::Node *node = nullptr, SymType t0 = UNDEFINED, SymType t1 = UNDEFINED) {
+      errors.addSemanticError(ctx, code, id, node, t0, t1);
+    }
+    void recordCall(ast::Identifier callee) {
+      if (calls != nullptr && currentRoutine != ast::Identifier()) {
+        calls->addCall(currentRoutine, callee);
+      }
+    }
+    void declareParams(llvm::ArrayRef<ast::Param*> params);
+    void declareRoutine(ast::Routine *ctx);
+    void checkInParallel(ast::CompilationUnit *ctx);
+
     STManager* stmgr;
     PropertyManager* bindings; 
     WPLErrorHandler errors;
+    std::set<ast::Node*> reusedComponents;
+    unsigned threads = 1;
+    // The tables of the bodies checked in parallel, kept for the symbols
+    // bound to their nodes
+    std::vector<std::unique_ptr<STManager>> bodyTables;
+    // Globals assigned in a body checked in parallel
+    std::vector<Symbol*> definedGlobals;
+    bool sequentialOnly = false;
+    AllocationCounts workerAllocations;
+    CallGraph* calls = nullptr;
+    ast::Identifier currentRoutine;    // whose body is being checked
 };
\ No newline at end of file
@@ -7,65 +7,83 @@
  */
 #include "STManager.h"
 
-Scope& STManager::enterScope() {
-  Scope* s;
-  if (currentScope == nullptr) {
-    s = new Scope();
-  } else {
-    s = new Scope(currentScope);
-  }
-  s->setId(scopeNumber++);
-  scopes.push_back(s);
-  currentScope = s;
-  return *s;
+void STManager::enterScope() {
+  scopes.push_back(declarations.size());
+  scopeNumber++;
 }
 
 /**
- * @brief exit the scope and set the current scope to the parent.
- *  No checking is done to see if exiting the root scope. 
- * 
- * @return Scope& the scope that was exited
+ * @brief exit the scope and make visible again the names that its
+ *  declarations hid. No checking is done to see if exiting the root scope.
  */
-Scope& STManager::exitScope() {
-  Scope& s = *currentScope;
-  currentScope = currentScope->getParent();
-  return s;
+void STManager::exitScope() {
+  size_t start = scopes.back();
+  for (size_t i = declarations.size(); i > start; i--) {
+    Declaration& d = declarations[i - 1];
+    visible[d.symbol->identifier.id()] = d.hidden;
+  }
+  declarations.resize(start);
+  scopes.pop_back();
 }
 
 /**
  * @brief add a symbol to the current scope
  * 
- * @param symbol the symbol to add
  * @return Symbol* pointer to the symbol that was added or 
  *  nullptr if a symbol with the same identifier already 
  *  existed in the current scope.
  */
-Symbol* STManager::addSymbol(std::string id, SymType t) {
-  // Check to see if it exists
-  // std::string id = symbol.identifier;
-  if (currentScope->findSymbol(id) != nullptr) {
+Symbol* STManager::addSymbol(ast::Identifier id, SymType t) {
+  if (id.id() >= visible.size()) {
+    visible.resize(id.id() + 1);
+  }
+  Binding& binding = visible[id.id()];
+  // A visible declaration belongs to one of the open scopes
+  if (binding.symbol != nullptr && binding.declaration >= scopes.back()) {
     // Change if you want to throw an exception
     return nullptr;
   }
-  return currentScope->addSymbol(id, t);
+  Symbol* symbol = new (symbolArena.Allocate()) Symbol(id, t);
+  declarations.push_back({symbol, binding});
+  binding.symbol = symbol;
+  binding.declaration = declarations.size() - 1;
+  return symbol;
 }
 
-Symbol* STManager::findSymbol(std::string id) {
-  Scope* scope = currentScope;
-  Symbol* symbol = nullptr;
-  while (scope != nullptr && symbol == nullptr) {
-    symbol = scope->findSymbol(id);
-    if (symbol == nullptr) {
-      scope = scope->getParent();
+Symbol* STManager::findSymbol(ast::Identifier id) const {
+  if (id.id() < visible.size() && visible[id.id()].symbol != nullptr) {
+    return visible[id.id()].symbol;
+  }
+  if (globalTable != nullptr && globalUses != nullptr) {
+    globalUses->push_back(id);
+  }
+  if (globalTable != nullptr && id.id() < globalTable->visible.size()) {
+    const Binding& global = globalTable->visible[id.id()];
+    if (global.declaration < globalCount) {
+      return global.symbol;
     }
   }
-  return symbol;
+  return nullptr;
+}
+
+bool STManager::isGlobal(const Symbol* symbol) const {
+  uint32_t id = symbol->identifier.id();
+  return globalTable != nullptr && (id >= visible.size() || visible[id].symbol != symbol);
 }
 
+/**
+ * @brief The symbols of the open scopes, outermost scope first.
+ */
 std::string STManager::toString() const {
   std::ostringstream description;
-  for (auto scope : scopes) {
-    description << scope->toString();
+  for (size_t scope = 0; scope < scopes.size(); scope++) {
+    size_t end = scope + 1 < scopes.size() ? scopes[scope + 1] : declarations.size();
+    description << std::endl << "-------------------" << std::endl
+      << "SCOPE: " << scope << std::endl << '{';
+    for (size_t i = scopes[scope]; i < end; i++) {
+      description << std::endl << "    " << declarations[i].symbol->toString();
+    }
+    description << std::endl << '}' << std::endl;
   }
   return description.str();
-}
\ No newline at end of file
+}
@@ -6,26 +6,69 @@
  * @date 2022-07-18
  */
 #pragma once
-#include "Scope.h"
+#include "Symbol.h"
+#include "llvm/Support/Allocator.h"
 #include <vector>
 
+/**
+ * @brief The symbol table. Each name has one slot, indexed by the id of
+ *  its identifier, that holds the innermost declaration of the name, so
+ *  a lookup is a single index whatever the nesting. A declaration that
+ *  hides an outer one of the same name keeps the outer one with it, and
+ *  leaving a scope puts back what the scope's own declarations hid, so
+ *  it costs nothing for names declared elsewhere.
+ *
+ *  Symbols live in an arena owned by the manager. They stay valid after
+ *  their scope is left, for the nodes bound to them, until the manager
+ *  is destroyed.
+ */
 class STManager {
   public:
     STManager(){};
-    Scope& enterScope();
-    Scope& exitScope();
+    void enterScope();
+    void exitScope();
 
-    // Pass through methods
-    Symbol* addSymbol(std::string id, SymType t);
-    Symbol* findSymbol(std::string id);
+    // nullptr if the name is already declared in the current scope
+    Symbol* addSymbol(ast::Identifier id, SymType t);
+    Symbol* findSymbol(ast::Identifier id) const;
+
+    // A table for bodies checked apart from the rest of the unit: names
+    // it does not declare are looked up among the first count
+    // declarations of the globals table, which must not change meanwhile
+    void setGlobals(const STManager* globals, size_t count) {
+      globalTable = globals;
+      globalCount = count;
+    }
+    // True if the symbol came from the globals table
+    bool isGlobal(const Symbol* symbol) const;
+    // Keep every name looked up in the globals table, so that a caller
+    // can tell later whether the lookups would still give the same
+    // symbols. nullptr stops it.
+    void setGlobalUses(std::vector<ast::Identifier>* uses) { globalUses = uses; }
+    // Declarations in the open scopes, the globals of the root scope first
+    size_t declarationCount() const { return declarations.size(); }
 
     // Miscellaneous (useful for testing)
-    Scope& getCurrentScope() { return *currentScope; }
-    int scopeCount() { return scopes.size(); }
+    int scopeCount() { return scopeNumber; }     // scopes entered so far
+    int scopeDepth() { return scopes.size(); }   // scopes open now
     std::string toString() const;
 
   private:
-    std::vector<Scope*> scopes;
-    Scope* currentScope = nullptr;
+    struct Binding {
+      Symbol* symbol = nullptr;
+      size_t declaration = 0;     // its index in declarations
+    };
+    struct Declaration {
+      Symbol* symbol;
+      Binding hidden;             // what the name meant before
+    };
+
+    std::vector<Binding> visible;            // by identifier id
+    std::vector<Declaration> declarations;   // of the open scopes, outermost first
+    std::vector<size_t> scopes;              // where each open scope's declarations start
+    llvm::SpecificBumpPtrAllocator<Symbol> symbolArena;
     int scopeNumber = 0;
-};
\ No newline at end of file
+    const STManager* globalTable = nullptr;
+    size_t globalCount = 0;
+    std::vector<ast::Identifier>* globalUses = nullptr;
+};
@@ -6,12 +6,13 @@
  * @date 2022-07-16
  * 
  * You can use this as a template by changing the data items here. The Symbols
- * are stored in the Scope and then associated with parse tree/AST nodes.
+ * are stored in the symbol table and then associated with parse tree/AST nodes.
  */
 #pragma once
 #include<string>
 #include<sstream>
 #include "llvm/IR/Value.h"
+#include "Identifier.h"
 
 enum SymType {INT, STR, BOOL, UNDEFINED};
 
@@ -19,13 +20,13 @@ class Symbol
 {
   public:
     /* data */
-    std::string identifier;
+    ast::Identifier identifier;
     SymType type;
     bool defined;
     llvm::Value *val;
 
     // The only constructor
-    Symbol(std::string id,SymType t) {
+    Symbol(ast::Identifier id,SymType t) {
       identifier = id;
       type = t;
       defined = false;
@@ -60,7 +61,7 @@ class Symbol
      */
     std::string toString() const {
       std::ostringstream description;
-      description << '[' << identifier << ", " << getSymTypeName(type) << ']';
+      description << '[' << identifier.text().str() << ", " << getSymTypeName(type) << ']';
       return description.str(); 
     }
 };
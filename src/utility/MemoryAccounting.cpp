@@ -0,0 +1,126 @@
+/**
+ * @file MemoryAccounting.cpp
+ * @author nllopez
+ * @brief Counting replacements of the global operator new and delete.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#include "MemoryAccounting.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+// Set by enableCounting() before any other thread starts, so the threads
+// read it without synchronization
+static bool counting = false;
+
+// Plain thread locals so that they need no construction in operator new
+static thread_local uint64_t allocationCount = 0;
+static thread_local uint64_t allocatedBytes = 0;
+
+static void count(std::size_t size) {
+  if (counting) {
+    allocationCount++;
+    allocatedBytes += size;
+  }
+}
+
+static void* countedAlloc(std::size_t size) {
+  count(size);
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+static void* countedAlignedAlloc(std::size_t size, std::align_val_t alignment) {
+  count(size);
+  void* p = nullptr;
+  std::size_t align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+  if (posix_memalign(&p, align, size == 0 ? 1 : size) != 0) {
+    return nullptr;
+  }
+  return p;
+}
+
+void* operator new(std::size_t size) {
+  void* p = countedAlloc(size);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](std::size_t size) {
+  void* p = countedAlloc(size);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return countedAlloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  void* p = countedAlignedAlloc(size, alignment);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  void* p = countedAlignedAlloc(size, alignment);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return countedAlignedAlloc(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return countedAlignedAlloc(size, alignment);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+
+void MemoryAccounting::enableCounting() {
+  counting = true;
+}
+
+AllocationCounts MemoryAccounting::threadCounts() {
+  AllocationCounts counts;
+  counts.allocations = allocationCount;
+  counts.bytes = allocatedBytes;
+  return counts;
+}
+
+AllocationCounts MemoryAccounting::threadCountsSince(const AllocationCounts& start) {
+  AllocationCounts counts;
+  counts.allocations = allocationCount - start.allocations;
+  counts.bytes = allocatedBytes - start.bytes;
+  return counts;
+}
+
+uint64_t MemoryAccounting::peakRSS() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef __APPLE__
+  return usage.ru_maxrss;           // bytes
+#else
+  return usage.ru_maxrss * 1024;    // kilobytes
+#endif
+}
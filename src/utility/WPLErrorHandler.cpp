@@ -1 +1,109 @@
-#include "WPLErrorHandler.h"
\ No newline at end of file
+#include "WPLErrorHandler.h"
+#include <sstream>
+
+using namespace ast;
+
+namespace {
+
+// "cannot <verb> T(left) with T (right). <rule>"
+std::string binaryMessage(const WPLError& e, const char* verb, const char* rule) {
+  const BinaryExpr* b = llvm::cast<BinaryExpr>(e.node);
+  return std::string("cannot ") + verb + " " + Symbol::getSymTypeName(e.types[0]) + "(" + getText(b->left)
+    + ") with " + Symbol::getSymTypeName(e.types[1]) + " (" + getText(b->right) + "). " + rule;
+}
+
+}
+
+std::string WPLError::message() const {
+  switch (code) {
+    case ErrCode::PROCEDURE_REDEFINITION:
+      return "procedure redefinition: " + id.text().str();
+    case ErrCode::FUNCTION_REDEFINITION:
+      return "function redefinition: " + id.text().str();
+    case ErrCode::VARIABLE_REDECLARATION:
+      return "variable redeclaration: " + id.text().str();
+    case ErrCode::UNDECLARED:
+      return id.text().str() + " undeclared.";
+    case ErrCode::SCALAR_TYPE_MISMATCH:
+      return "scalar declaration type mismatch. expected type " + Symbol::getSymTypeName(types[0])
+        + ", got type " + Symbol::getSymTypeName(types[1]) + " (" + llvm::cast<Constant>(node)->text.str() + ")";
+    case ErrCode::ASSIGNMENT_COUNT:
+      return "Expected equal number of target/expression pairs in assignment expression.";
+    case ErrCode::ASSIGNMENT_TYPE_MISMATCH:
+      return id.text().str() + "Type mismatch. Expected " + Symbol::getSymTypeName(types[0]) + ", got "
+        + Symbol::getSymTypeName(types[1]);
+    case ErrCode::EXPECTED_BOOLEAN_EXPRESSION:
+      return "expected a boolean expression, got " + getText(llvm::cast<Expr>(node));
+    case ErrCode::CANNOT_AND:
+      return binaryMessage(*this, "AND", "booleans only.");
+    case ErrCode::CANNOT_OR:
+      return binaryMessage(*this, "OR", "booleans only.");
+    case ErrCode::CANNOT_COMPARE_INTEGERS:
+      return binaryMessage(*this, "compare", "integers only.");
+    case ErrCode::CANNOT_COMPARE_TYPES:
+      return binaryMessage(*this, "compare", "must be same type.");
+    case ErrCode::CANNOT_MULTIPLY:
+      return binaryMessage(*this, "multiply/divide", "integers only.");
+    case ErrCode::CANNOT_ADD:
+      return binaryMessage(*this, "add/subtract", "integers only.");
+    case ErrCode::EXPECTED_INT:
+      return "expected int, got " + getText(llvm::cast<UnaryExpr>(node)->e);
+    case ErrCode::EXPECTED_BOOLEAN:
+      return "expected boolean, got " + getText(llvm::cast<UnaryExpr>(node)->e);
+    case ErrCode::LOOP_CONDITION:
+      return "expected boolean expression for loop condition. got " + Symbol::getSymTypeName(types[0]);
+    case ErrCode::IF_CONDITION:
+      return "expected boolean expression for 'if' condition. got " + Symbol::getSymTypeName(types[0]);
+    case ErrCode::NO_SYMBOL:
+      return "No symbol created for " + id.text().str();
+    case ErrCode::NO_BINDING:
+      return "Cannot find associated symbol for \"" + id.text().str() + "\"";
+    case ErrCode::NOT_DEFINED:
+      return "Symbol " + id.text().str() + " has not been defined.";
+    case ErrCode::NO_VALUE:
+      return "No llvm value for symbol " + id.text().str();
+    case ErrCode::NO_FUNCTION:
+      return "No definition found for function " + id.text().str();
+    case ErrCode::ARRAYS_NOT_SUPPORTED:
+      return "Arrays are not supported: " + getText(llvm::cast<Expr>(node));
+  }
+  return "";
+}
+
+std::string WPLError::toString() const {
+  std::ostringstream e;
+  e << (type == SEMANTIC ? "SEMANTIC" : "CODEGEN") << ": [" << line << ',' << column
+    << "]: " << message();
+  return e.str();
+}
+
+void WPLErrorHandler::setErrors(std::vector<WPLError> list) {
+  errors = std::move(list);
+  if (limit != 0 && keptCount + errors.size() > limit + 1) {
+    errors.resize(limit + 1 - keptCount);
+  }
+}
+
+void WPLErrorHandler::keepText() {
+  for (const WPLError& e : errors) {
+    if (limit == 0 || keptCount < limit) {
+      kept += e.toString();
+      kept += '\n';
+    }
+    keptCount++;
+  }
+  errors.clear();
+}
+
+std::string WPLErrorHandler::errorList() {
+  std::ostringstream errList;
+  errList << kept;
+  for (size_t i = 0; i < errors.size() && (limit == 0 || keptCount + i < limit); i++) {
+    errList << errors[i].toString() << std::endl;
+  }
+  // The error past the limit is only there to show that some were left out
+  if (full()) {
+    errList << "too many errors, stopped after the first " << limit << std::endl;
+  }
+  return errList.str();
+}
@@ -0,0 +1,41 @@
+/**
+ * @file MemoryAccounting.h
+ * @author nllopez
+ * @brief Allocation counters for -mem-report. The global operator new,
+ *  including the aligned forms, is replaced so that every allocation is
+ *  counted by the thread that makes it. The counts of a phase are the
+ *  difference of the counters of its thread before and after it, plus
+ *  what the pool threads that worked for it allocated, which they
+ *  measure with threadCountsSince().
+ *
+ *  Counting is off, and the counts stay 0, unless enableCounting() was
+ *  called. Then every allocation also pays for a test and two
+ *  thread-local increments; off, it only pays for the test.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include <cstdint>
+
+struct AllocationCounts {
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+
+  void add(const AllocationCounts& other) {
+    allocations += other.allocations;
+    bytes += other.bytes;
+  }
+};
+
+class MemoryAccounting {
+  public:
+    // Allocations made by the calling thread so far
+    static AllocationCounts threadCounts();
+    // Allocations made by the calling thread since start was taken
+    static AllocationCounts threadCountsSince(const AllocationCounts& start);
+    // Start counting allocations. Called before any other thread starts.
+    static void enableCounting();
+    // Peak resident set size of the whole process so far in bytes: a
+    // high-water mark over all threads, phases and inputs
+    static uint64_t peakRSS();
+};
@@ -4,58 +4,112 @@
  * @brief A simple error handler that gathers errors and can print them out
  * @version 0.1
  * @date 2022-07-23
+ *
+ * An error is a small record: what went wrong, where, and the names,
+ * types and node it is about. Its text is only built when the errors
+ * are listed, so a run with many errors does not spend its time
+ * quoting expressions nobody reads. The nodes are those of the AST,
+ * which must still be there when the errors are listed; a compile that
+ * frees its trees as it goes lists each tree's errors first (keepText).
  */
 #pragma once
-#include "antlr4-runtime.h"
+#include "AST.h"
+#include "Symbol.h"
+#include <cstdint>
 #include <string>
 #include <vector>
-#include <sstream>
 
 enum ErrType {SEMANTIC, CODEGEN};
 
+// Each code says which operands of a WPLError its message uses
+enum class ErrCode : uint8_t {
+  // Semantic errors
+  PROCEDURE_REDEFINITION,       // id
+  FUNCTION_REDEFINITION,        // id
+  VARIABLE_REDECLARATION,       // id
+  UNDECLARED,                   // id
+  SCALAR_TYPE_MISMATCH,         // declared and found type, the initial Constant
+  ASSIGNMENT_COUNT,
+  ASSIGNMENT_TYPE_MISMATCH,     // id, expected and found type
+  EXPECTED_BOOLEAN_EXPRESSION,  // the expression
+  CANNOT_AND,                   // the BinaryExpr, the types of its operands
+  CANNOT_OR,
+  CANNOT_COMPARE_INTEGERS,
+  CANNOT_COMPARE_TYPES,
+  CANNOT_MULTIPLY,
+  CANNOT_ADD,
+  EXPECTED_INT,                 // the UnaryExpr
+  EXPECTED_BOOLEAN,             // the UnaryExpr
+  LOOP_CONDITION,               // the type of the condition
+  IF_CONDITION,                 // the type of the condition
+  // Code generator errors
+  NO_SYMBOL,                    // id
+  NO_BINDING,                   // id
+  NOT_DEFINED,                  // id
+  NO_VALUE,                     // id
+  NO_FUNCTION,                  // id
+  ARRAYS_NOT_SUPPORTED,         // the expression
+};
+
 struct WPLError {
-  antlr4::Token* token;
-  std::string message;
-  std::string type;
-
-  // Constructor
-  WPLError(antlr4::Token* tok, std::string msg, ErrType et) {
-    token = tok;
-    message = msg;
-    type = et == SEMANTIC ? "SEMANTIC" : "CODEGEN";;
-  }
-
-  std::string toString() {
-    std::ostringstream e;
-    e << type << ": [" << token->getLine() << ',' << token->getCharPositionInLine()
-      << "]: " << message;
-    return e.str();
-  }
+  ErrCode code;
+  ErrType type;
+  SymType types[2];
+  // The position is that of the first token of the node
+  size_t line;
+  size_t column;
+  ast::Identifier id;
+  const ast::Node* node;
+
+  std::string message() const;
+  std::string toString() const;
 };
 
 class WPLErrorHandler {
   public:
-    void addSemanticError(antlr4::Token* t, std::string msg) {
-      WPLError* e = new WPLError(t, msg, SEMANTIC);
-      errors.push_back(e);
+    void addSemanticError(const ast::Node* at, ErrCode code, ast::Identifier id = ast::Identifier(),
+        const ast::Node* node = nullptr, SymType t0 = UNDEFINED, SymType t1 = UNDEFINED) {
+      add(at->span.line, at->span.column, code, SEMANTIC, id, node, t0, t1);
+    }
+    void addSemanticError(size_t line, size_t column, ErrCode code, ast::Identifier id) {
+      add(line, column, code, SEMANTIC, id, nullptr, UNDEFINED, UNDEFINED);
     }
 
-    void addCodegenError(antlr4::Token* t, std::string msg) {
-      WPLError* e = new WPLError(t, msg, CODEGEN);
-      errors.push_back(e);;
+    void addCodegenError(const ast::Node* at, ErrCode code, ast::Identifier id = ast::Identifier(),
+        const ast::Node* node = nullptr) {
+      add(at->span.line, at->span.column, code, CODEGEN, id, node, UNDEFINED, UNDEFINED);
     }
 
-    std::vector<WPLError*>& getErrors() { return errors; }
+    // List at most this many errors (0 = all). One more is recorded, so
+    // that the list knows whether any were left out; full() tells when
+    // to stop
+    void setLimit(size_t n) { limit = n; }
+    size_t getLimit() const { return limit; }
+    bool full() const { return limit != 0 && keptCount + errors.size() > limit; }
+
+    // The errors not yet turned into text by keepText()
+    const std::vector<WPLError>& getErrors() const { return errors; }
+    // Replace them, dropping any past the one after the limit
+    void setErrors(std::vector<WPLError> list);
 
-    std::string errorList() {
-      std::ostringstream errList;
-      for (WPLError* e : errors) {
-        errList << e->toString() << std::endl;
+    // List the errors recorded so far as text, so that the trees they
+    // point into can go
+    void keepText();
+
+    std::string errorList();
+
+    bool hasErrors() { return keptCount + errors.size() > 0; }
+  private:
+    void add(size_t line, size_t column, ErrCode code, ErrType type, ast::Identifier id,
+        const ast::Node* node, SymType t0, SymType t1) {
+      if (full()) {
+        return;
       }
-      return errList.str();
+      errors.push_back({code, type, {t0, t1}, line, column, id, node});
     }
 
-    bool hasErrors() { return !errors.empty(); }
-  private:
-    std::vector<WPLError*> errors;
-};
\ No newline at end of file
+    std::vector<WPLError> errors;
+    std::string kept;
+    size_t keptCount = 0;
+    size_t limit = 0;
+};
@@ -0,0 +1,42 @@
+/**
+ * @file WPLSyntaxErrorListener.h
+ * @author nllopez
+ * @brief ANTLR error listener that gathers the lexer and parser errors
+ *  instead of writing them straight to std::cerr. The messages have the
+ *  same format as the ANTLR ConsoleErrorListener.
+ * @version 0.1
+ * @date 2026-10-17
+ */
+#pragma once
+#include "antlr4-runtime.h"
+#include <string>
+#include <vector>
+#include <sstream>
+
+struct SyntaxError {
+  size_t line;
+  size_t column;
+  std::string message;
+};
+
+class WPLSyntaxErrorListener : public antlr4::BaseErrorListener {
+  public:
+    void syntaxError(antlr4::Recognizer *recognizer, antlr4::Token *offendingSymbol,
+        size_t line, size_t charPositionInLine, const std::string &msg,
+        std::exception_ptr e) override {
+      errors.push_back({line, charPositionInLine, msg});
+    }
+
+    std::string errorList() {
+      std::ostringstream errList;
+      for (SyntaxError& e : errors) {
+        errList << "line " << e.line << ":" << e.column << " " << e.message << std::endl;
+      }
+      return errList.str();
+    }
+
+    std::vector<SyntaxError>& getErrors() { return errors; }
+    bool hasErrors() { return !errors.empty(); }
+  private:
+    std::vector<SyntaxError> errors;
+};
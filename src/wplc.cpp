@@ -7,28 +7,52 @@
  * 
  * @copyright Copyright (c) 2022
  * 
- * NOTE: You may want to allow multiple files and 
- * loop through them so that you can compile multiple
- * files with one command line.
+ * Several input files (or a -manifest listing them) can be given
+ * on one command line. They are compiled at the same time on a
+ * thread pool and a per-file summary is printed at the end.
  */
 #include <iostream>
 #include <fstream>
-#include "antlr4-runtime.h"
-#include "WPLLexer.h"
-#include "WPLParser.h"
-#include "SemanticVisitor.h"
-#include "CodegenVisitor.h"
+#include <vector>
+#include "WPLCompiler.h"
+#include "CompileServer.h"
+#include "LanguageServer.h"
+#include "CompileCache.h"
+#include "DFACache.h"
+#include "MemoryAccounting.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/TimeProfiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <map>
 
 llvm::cl::OptionCategory WPLCOptions("wplc Options");
-static llvm::cl::opt<std::string>
-    inputFileName(llvm::cl::Positional,
-          llvm::cl::desc("<input file>"),
-          llvm::cl::init("-"),
+static llvm::cl::list<std::string>
+    inputFileNames(llvm::cl::Positional,
+          llvm::cl::desc("<input files>"),
+          llvm::cl::ZeroOrMore,
           llvm::cl::cat(WPLCOptions));
 
+static llvm::cl::opt<std::string>
+    manifestFileName("manifest",
+      llvm::cl::desc("Read the input files from a manifest (one path per line, # starts a comment)"),
+      llvm::cl::value_desc("manifest file"),
+      llvm::cl::init("-"),
+      llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<unsigned>
+    threadCount("j",
+      llvm::cl::desc("Number of input files to compile at the same time (0 = one per core)"),
+      llvm::cl::value_desc("threads"),
+      llvm::cl::init(0),
+      llvm::cl::cat(WPLCOptions));
+
 static llvm::cl::opt<bool>
     printOutput("p", 
           llvm::cl::desc("Print the IR"),
@@ -53,6 +77,426 @@ static llvm::cl::opt<bool>
           llvm::cl::desc("Do not generate any output file"),
           llvm::cl::cat(WPLCOptions));
 
+static llvm::cl::opt<bool>
+    serve("serve", 
+          llvm::cl::desc("Run as a compile server on the -socket path"),
+          llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<bool>
+    lsp("lsp", 
+          llvm::cl::desc("Run as a language server on stdin and stdout (with -time-report, log each update to stderr)"),
+          llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<bool>
+    useServer("use-server", 
+          llvm::cl::desc("Send the inputs to a running compile server (compile locally if there is none)"),
+          llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<std::string>
+    socketPath("socket",
+      llvm::cl::desc("Unix socket of the compile server"),
+      llvm::cl::value_desc("socket path"),
+      llvm::cl::init(CompileServer::defaultSocketPath()),
+      llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<std::string>
+    cacheDir("cache-dir",
+      llvm::cl::desc("Reuse the IR of unchanged sources from this cache directory"),
+      llvm::cl::value_desc("directory"),
+      llvm::cl::init(""),
+      llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<unsigned>
+    cacheSize("cache-size",
+      llvm::cl::desc("Size limit of the cache directory in MB"),
+      llvm::cl::value_desc("MB"),
+      llvm::cl::init(512),
+      llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<bool>
+    incremental("incremental", 
+          llvm::cl::desc("Only recompile the procedures and functions that changed (needs -cache-dir)"),
+          llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<bool>
+    cacheStats("cache-stats", 
+          llvm::cl::desc("Print the cache hit/miss statistics"),
+          llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<std::string>
+    timeTrace("time-trace",
+      llvm::cl::desc("Write a Chrome trace-event JSON file of the compile phases"),
+      llvm::cl::value_desc("trace file"),
+      llvm::cl::init(""),
+      llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<unsigned>
+    timeTraceGranularity("time-trace-granularity",
+      llvm::cl::desc("Shortest span written to the time trace, in microseconds"),
+      llvm::cl::init(500),
+      llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<bool>
+    timeReport("time-report", 
+          llvm::cl::desc("Print a table of the time spent in each phase"),
+          llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<std::string>
+    dfaCacheFile("dfa-cache",
+      llvm::cl::desc("Load the lexer and parser DFAs from this file and save them back when they grew (a -serve server saves them when stopped)"),
+      llvm::cl::value_desc("cache file"),
+      llvm::cl::init(""),
+      llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<LexerKind>
+    lexerKind("lexer",
+      llvm::cl::desc("Lexer used for ASCII input"),
+      llvm::cl::values(
+        clEnumValN(LexerKind::ANTLR, "antlr", "Generated ANTLR lexer (default)"),
+        clEnumValN(LexerKind::FAST, "fast", "Hand-written lexer"),
+        clEnumValN(LexerKind::VERIFY, "verify", "Run both and fail on the first token that differs")),
+      llvm::cl::init(LexerKind::ANTLR),
+      llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<ParserKind>
+    parserKind("parser",
+      llvm::cl::desc("Parser used to build the parse tree"),
+      llvm::cl::values(
+        clEnumValN(ParserKind::ANTLR, "antlr", "Generated ANTLR parser (default)"),
+        clEnumValN(ParserKind::FAST, "fast", "Hand-written recursive descent parser"),
+        clEnumValN(ParserKind::VERIFY, "verify", "Run both and fail on the first parse tree node that differs")),
+      llvm::cl::init(ParserKind::ANTLR),
+      llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<bool>
+    stream("stream",
+          llvm::cl::desc("Compile one top-level component at a time to bound the memory used by large inputs"),
+          llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<unsigned>
+    parseThreads("parse-threads",
+      llvm::cl::desc("Number of threads that parse the components of one large input (0 = one per core)"),
+      llvm::cl::value_desc("threads"),
+      llvm::cl::init(1),
+      llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<unsigned>
+    semanticThreads("semantic-threads",
+      llvm::cl::desc("Number of threads that check the procedure and function bodies of one input (0 = one per core)"),
+      llvm::cl::value_desc("threads"),
+      llvm::cl::init(1),
+      llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<unsigned>
+    errorLimit("error-limit",
+      llvm::cl::desc("Stop after this many errors in one input (0 = no limit)"),
+      llvm::cl::value_desc("errors"),
+      llvm::cl::init(0),
+      llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<OptLevel>
+    optLevel(llvm::cl::desc("Optimization level"),
+      llvm::cl::values(
+        clEnumValN(OptLevel::O0, "O0", "No optimization, the IR as generated (default)"),
+        clEnumValN(OptLevel::O1, "O1", "Run the LLVM -O1 pipeline on the module"),
+        clEnumValN(OptLevel::O2, "O2", "Run the LLVM -O2 pipeline on the module"),
+        clEnumValN(OptLevel::O3, "O3", "Run the LLVM -O3 pipeline on the module")),
+      llvm::cl::init(OptLevel::O0),
+      llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<bool>
+    keepUnused("keep-unused",
+          llvm::cl::desc("Emit only a declaration for the procedures and functions program cannot reach"),
+          llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<bool>
+    callGraphReport("call-graph-report",
+          llvm::cl::desc("Print the procedures and functions of each input, whether program reaches them and their calls"),
+          llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<bool>
+    profileParser("profile-parser",
+          llvm::cl::desc("Profile the decisions of the ANTLR parser and print a table of them by rule"),
+          llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<bool>
+    memReport("mem-report", 
+          llvm::cl::desc("Print a table of the memory allocated in each phase"),
+          llvm::cl::cat(WPLCOptions));
+
+static llvm::cl::opt<std::string>
+    memReportJson("mem-report-json",
+      llvm::cl::desc("Write the memory used by each phase of each input as JSON"),
+      llvm::cl::value_desc("report file"),
+      llvm::cl::init(""),
+      llvm::cl::cat(WPLCOptions));
+
+/**
+ * @brief Add the input files listed in the manifest to the inputs.
+ *  Blank lines and lines starting with # are ignored.
+ * 
+ * @return false if the manifest could not be read
+ */
+static bool readManifest(std::string fileName, std::vector<std::string>& inputs) {
+  std::ifstream manifest(fileName);
+  if (!manifest) {
+    return false;
+  }
+  std::string line;
+  while (std::getline(manifest, line)) {
+    size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#') {
+      continue;
+    }
+    size_t last = line.find_last_not_of(" \t\r");
+    inputs.push_back(line.substr(first, last - first + 1));
+  }
+  return true;
+}
+
+/**
+ * @brief Compile one job, on the compile server if -use-server was given
+ *  and one is running. The server does not share our working directory,
+ *  so the paths, including the derived output path, are made absolute
+ *  before the job is sent. A job that
+ *  is traced, profiled or reports its call graph always runs here,
+ *  since the server does not send those back.
+ */
+static CompileResult runJob(const CompileJob& job) {
+  if (useServer && !job.timeTrace && !job.profileParser && !job.callGraphReport) {
+    CompileJob remote = job;
+    llvm::SmallString<256> path;
+    if (remote.inputFileName != "-") {
+      path = remote.inputFileName;
+      llvm::sys::fs::make_absolute(path);
+      remote.inputFileName = std::string(path);
+    }
+    if (!remote.cacheDir.empty()) {
+      path = remote.cacheDir;
+      llvm::sys::fs::make_absolute(path);
+      remote.cacheDir = std::string(path);
+    }
+    // The output path is derived here even without -o, so one next to
+    // the input (or -.ll for -s) lands in our directory, not the server's
+    path = WPLCompiler::irFileName(job);
+    llvm::sys::fs::make_absolute(path);
+    remote.outputFileName = std::string(path);
+    CompileResult result;
+    if (CompileServer::request(socketPath, remote, result)) {
+      result.inputName = job.inputFileName;
+      if (!result.outputFileName.empty()) {
+        result.outputFileName = WPLCompiler::irFileName(job);
+      }
+      return result;
+    }
+  }
+  return WPLCompiler::compile(job);
+}
+
+/**
+ * @brief Print the time spent in each phase, summed over all inputs.
+ */
+static void printTimeReport(std::vector<CompileResult>& results) {
+  std::vector<std::string> phases;
+  std::map<std::string, double> times;
+  double total = 0;
+  for (CompileResult& r : results) {
+    for (PhaseStats& p : r.phases) {
+      if (times.find(p.name) == times.end()) {
+        phases.push_back(p.name);
+      }
+      times[p.name] += p.seconds;
+      total += p.seconds;
+    }
+  }
+  std::cerr << "===---------------------------------------------===" << std::endl
+    << "              wplc phase time report" << std::endl
+    << "===---------------------------------------------===" << std::endl
+    << "  " << std::left << std::setw(16) << "Phase" << std::right
+    << std::setw(14) << "Time (s)" << std::setw(10) << "%" << std::endl;
+  std::cerr << std::fixed;
+  for (std::string& phase : phases) {
+    std::cerr << "  " << std::left << std::setw(16) << phase << std::right
+      << std::setw(14) << std::setprecision(6) << times[phase]
+      << std::setw(9) << std::setprecision(1)
+      << (total > 0 ? 100 * times[phase] / total : 0) << "%" << std::endl;
+  }
+  std::cerr << "  " << std::left << std::setw(16) << "Total" << std::right
+    << std::setw(14) << std::setprecision(6) << total << std::endl;
+  std::cerr.unsetf(std::ios::floatfield);
+}
+
+/**
+ * @brief What each phase holds on to when it is done, for -mem-report.
+ */
+static std::string phaseProduct(const std::string& phase) {
+  if (phase == "Lex") return "tokens";
+  if (phase == "Parse") return "parse tree";
+  if (phase == "Semantic") return "symbol tables, properties";
+  if (phase == "Codegen") return "LLVM module";
+  return "";
+}
+
+/**
+ * @brief Print the allocations of each phase, summed over all inputs, and
+ *  the peak resident set size of the process.
+ */
+static void printMemReport(std::vector<CompileResult>& results) {
+  std::vector<std::string> phases;
+  std::map<std::string, PhaseStats> totals;
+  uint64_t peakRSS = 0;
+  for (CompileResult& r : results) {
+    for (PhaseStats& p : r.phases) {
+      if (totals.find(p.name) == totals.end()) {
+        phases.push_back(p.name);
+      }
+      totals[p.name].allocations += p.allocations;
+      totals[p.name].bytes += p.bytes;
+      peakRSS = std::max(peakRSS, p.processPeakRSS);
+    }
+  }
+  std::cerr << "===---------------------------------------------------------------===" << std::endl
+    << "                     wplc phase memory report" << std::endl
+    << "===---------------------------------------------------------------===" << std::endl
+    << "  " << std::left << std::setw(16) << "Phase" << std::right
+    << std::setw(14) << "Allocations" << std::setw(14) << "KB" << "  "
+    << std::left << "Holds" << std::right << std::endl;
+  PhaseStats total;
+  for (std::string& phase : phases) {
+    PhaseStats& p = totals[phase];
+    std::cerr << "  " << std::left << std::setw(16) << phase << std::right
+      << std::setw(14) << p.allocations << std::setw(14) << p.bytes / 1024
+      << "  " << phaseProduct(phase) << std::endl;
+    total.allocations += p.allocations;
+    total.bytes += p.bytes;
+  }
+  std::cerr << "  " << std::left << std::setw(16) << "Total" << std::right
+    << std::setw(14) << total.allocations << std::setw(14) << total.bytes / 1024 << std::endl
+    << "  Peak RSS " << peakRSS / 1024 << " KB" << std::endl;
+}
+
+/**
+ * @brief Print the profile of the parser decisions, summed over all
+ *  inputs, with the decisions that took the most prediction time first.
+ *  Decisions that were never reached are left out.
+ */
+static void printParserProfile(std::vector<CompileResult>& results) {
+  std::vector<DecisionProfile> decisions;
+  for (CompileResult& r : results) {
+    if (decisions.size() < r.parserProfile.size()) {
+      decisions.resize(r.parserProfile.size());
+    }
+    for (DecisionProfile& d : r.parserProfile) {
+      if (d.invocations == 0) {
+        continue;
+      }
+      decisions[d.decision].decision = d.decision;
+      decisions[d.decision].rule = d.rule;
+      decisions[d.decision].add(d);
+    }
+  }
+  llvm::erase_if(decisions, [](const DecisionProfile& d) { return d.invocations == 0; });
+  std::stable_sort(decisions.begin(), decisions.end(),
+    [](const DecisionProfile& a, const DecisionProfile& b) { return a.nanoseconds > b.nanoseconds; });
+
+  std::cerr << "===-------------------------------------------------------------------------------------------===" << std::endl
+    << "                                wplc parser decision profile" << std::endl
+    << "===-------------------------------------------------------------------------------------------===" << std::endl
+    << "  " << std::left << std::setw(20) << "Rule" << std::right
+    << std::setw(9) << "Decision" << std::setw(12) << "Invocations" << std::setw(13) << "LL fallbacks"
+    << std::setw(12) << "Ambiguities" << std::setw(11) << "Ctx-sens" << std::setw(10) << "Avg look"
+    << std::setw(10) << "Max SLL" << std::setw(9) << "Max LL" << std::setw(12) << "Time (ms)" << std::endl;
+  std::cerr << std::fixed;
+  DecisionProfile total;
+  for (DecisionProfile& d : decisions) {
+    std::cerr << "  " << std::left << std::setw(20) << d.rule << std::right
+      << std::setw(9) << d.decision << std::setw(12) << d.invocations << std::setw(13) << d.llFallbacks
+      << std::setw(12) << d.ambiguities << std::setw(11) << d.contextSensitivities
+      << std::setw(10) << std::setprecision(2) << double(d.sllLookahead + d.llLookahead) / d.invocations
+      << std::setw(10) << d.sllMaxLookahead << std::setw(9) << d.llMaxLookahead
+      << std::setw(12) << std::setprecision(3) << d.nanoseconds / 1e6 << std::endl;
+    total.add(d);
+  }
+  std::cerr << "  " << std::left << std::setw(29) << "Total" << std::right
+    << std::setw(12) << total.invocations << std::setw(13) << total.llFallbacks
+    << std::setw(12) << total.ambiguities << std::setw(11) << total.contextSensitivities
+    << std::setw(41) << std::setprecision(3) << total.nanoseconds / 1e6 << std::endl;
+  std::cerr.unsetf(std::ios::floatfield);
+}
+
+/**
+ * @brief Print the procedures and functions of each input in source
+ *  order, whether program reaches them, how many calls to them there
+ *  are and how many calls they make.
+ */
+static void printCallGraph(std::vector<CompileResult>& results) {
+  std::cerr << "===---------------------------------------------------------------===" << std::endl
+    << "                       wplc call graph report" << std::endl
+    << "===---------------------------------------------------------------===" << std::endl;
+  for (CompileResult& r : results) {
+    unsigned reachable = 0;
+    for (RoutineReach& routine : r.callGraph) {
+      reachable += routine.reachable;
+    }
+    std::cerr << "  " << r.inputName << ": " << reachable << " of " << r.callGraph.size()
+      << " reachable" << std::endl
+      << "  " << std::left << std::setw(32) << "Routine" << std::right
+      << std::setw(11) << "Reachable" << std::setw(12) << "Call sites" << std::setw(8) << "Calls" << std::endl;
+    for (RoutineReach& routine : r.callGraph) {
+      std::cerr << "  " << std::left << std::setw(32) << routine.name << std::right
+        << std::setw(11) << (routine.reachable ? "yes" : "no")
+        << std::setw(12) << routine.callSites << std::setw(8) << routine.calls << std::endl;
+    }
+  }
+}
+
+/**
+ * @brief Write the memory used by each phase of each input as JSON.
+ */
+static bool writeMemReportJson(std::string fileName, std::vector<CompileResult>& results) {
+  std::error_code ec;
+  llvm::raw_fd_ostream out(fileName, ec);
+  if (ec) {
+    std::cerr << "Cannot write " << fileName << ": " << ec.message() << std::endl;
+    return false;
+  }
+  llvm::json::OStream json(out, 2);
+  json.object([&] {
+    json.attributeArray("files", [&] {
+      for (CompileResult& r : results) {
+        json.object([&] {
+          json.attribute("input", r.inputName);
+          json.attributeArray("phases", [&] {
+            for (PhaseStats& p : r.phases) {
+              json.object([&] {
+                json.attribute("name", p.name);
+                json.attribute("allocations", (int64_t) p.allocations);
+                json.attribute("bytes", (int64_t) p.bytes);
+                json.attribute("process_peak_rss_kb", (int64_t) (p.processPeakRSS / 1024));
+              });
+            }
+          });
+        });
+      }
+    });
+  });
+  out << "\n";
+  return true;
+}
+
+/**
+ * @brief Write the shared DFAs back to the -dfa-cache file if they grew
+ *  past the loadedStates read from it. No compile may be running.
+ */
+static void saveDFACache(size_t loadedStates) {
+  if (!dfaCacheFile.empty() && DFACache::stateCount() > loadedStates) {
+    std::string error;
+    if (!DFACache::save(dfaCacheFile, error)) {
+      std::cerr << "Cannot save the DFA cache: " << error << std::endl;
+    }
+  }
+}
+
 /**
  * @brief Main compiler driver.
  */
@@ -64,81 +508,191 @@ int main(int argc, const char* argv[]) {
   llvm::cl::HideUnrelatedOptions(WPLCOptions);
   llvm::cl::ParseCommandLineOptions(argc, argv);
 
-  if (((inputFileName == "-") && (inputString == "-")) 
-      || ((inputFileName != "-") && (inputString != "-")))
+  // Allocations are only counted for the reports that show them. A
+  // server counts them for every compile, as any client may ask.
+  if (memReport || !memReportJson.empty() || serve) {
+    MemoryAccounting::enableCounting();
+  }
+
+  // A missing or unusable DFA cache only means the DFAs are built from
+  // scratch. A missing one is expected on the first run.
+  size_t dfaStates = 0;
+  if (!dfaCacheFile.empty()) {
+    std::string error;
+    if (!DFACache::load(dfaCacheFile, error) && llvm::sys::fs::exists(dfaCacheFile)) {
+      std::cerr << "Ignoring the DFA cache: " << error << std::endl;
+    }
+    dfaStates = DFACache::stateCount();
+  }
+
+  if (serve) {
+    int status = CompileServer::serve(socketPath, threadCount);
+    saveDFACache(dfaStates);
+    return status;
+  }
+
+  if (lsp) {
+    int status = LanguageServer::serve(std::cin, std::cout, timeReport);
+    saveDFACache(dfaStates);
+    return status;
+  }
+
+  std::vector<std::string> inputs(inputFileNames.begin(), inputFileNames.end());
+  if (manifestFileName != "-" && !readManifest(manifestFileName, inputs)) {
+    std::cerr << "Cannot read the manifest file " << manifestFileName << std::endl;
+    std::exit(-1);
+  }
+
+  if ((inputs.empty() && (inputString == "-")) 
+      || (!inputs.empty() && (inputString != "-")))
   {
     std::cerr << "You can only have an input file or and input string, but not both" << std::endl;
     std::exit(-1);
   }
 
+  if (incremental && cacheDir.empty()) {
+    std::cerr << "-incremental needs a -cache-dir" << std::endl;
+    std::exit(-1);
+  }
+
+  if (profileParser && parserKind != ParserKind::ANTLR) {
+    std::cerr << "-profile-parser profiles the ANTLR parser and cannot be used with -parser=fast or -parser=verify" << std::endl;
+    std::exit(-1);
+  }
+
+  if (inputs.size() > 1 && outputFileName != "-") {
+    std::cerr << "An output file can only be supplied for a single input file" << std::endl;
+    std::exit(-1);
+  }
+
   /******************************************************************
-   * Now that we have the input, we can perform the first stage:
-   * 1. Create the lexer from the input.
-   * 2. Create the parser with the lexer's token stream as input.
-   * 3. Parse the input and get the parse tree for then exit stage.
-   * 4. TBD: handle errors
-   ******************************************************************/ 
-    
-  // 1. Create the lexer
-  antlr4::ANTLRInputStream *input = nullptr;
-  if (inputFileName != "-") {
-    std::fstream *inStream = new std::fstream(inputFileName);
-    input = new antlr4::ANTLRInputStream(*inStream);
+   * Build one job per input. Every job gets its own lexer, parser,
+   * symbol table and LLVMContext (see WPLCompiler), and its output
+   * path is derived from its input path.
+   ******************************************************************/
+  std::vector<CompileJob> jobs;
+  if (inputs.empty()) {
+    inputs.push_back("-");
+  }
+  for (std::string& in : inputs) {
+    CompileJob job;
+    job.inputFileName = in;
+    job.inputString = inputString;
+    job.outputFileName = outputFileName;
+    job.printOutput = printOutput;
+    job.noCode = noCode;
+    job.cacheDir = cacheDir;
+    job.cacheSizeLimit = uint64_t(cacheSize) * 1024 * 1024;
+    job.incremental = incremental;
+    job.timeTrace = !timeTrace.empty();
+    job.timeTraceGranularity = timeTraceGranularity;
+    job.lexer = lexerKind;
+    job.parser = parserKind;
+    job.stream = stream;
+    job.parseThreads = parseThreads;
+    job.semanticThreads = semanticThreads;
+    job.errorLimit = errorLimit;
+    job.keepUnused = keepUnused;
+    job.callGraphReport = callGraphReport;
+    job.optLevel = optLevel;
+    job.profileParser = profileParser;
+    jobs.push_back(job);
+  }
+
+  if (!timeTrace.empty()) {
+    llvm::timeTraceProfilerInitialize(timeTraceGranularity, "wplc");
+  }
+
+  std::vector<CompileResult> results(jobs.size());
+  if (jobs.size() == 1 || threadCount == 1) {
+    for (size_t i = 0; i < jobs.size(); i++) {
+      results[i] = runJob(jobs[i]);
+    }
   } else {
-    input = new antlr4::ANTLRInputStream(inputString);
-  }
-  WPLLexer lexer(input);
-  antlr4::CommonTokenStream tokens(&lexer);
-  
-  // 2. Create a parser from the token stream
-  WPLParser parser(&tokens);   
-  WPLParser::CompilationUnitContext* tree = NULL;
-
-  // // 3. Parse the program and get the parse tree
-  tree = parser.compilationUnit();
-
-  // /******************************************************************
-  //  * Perform semantic analysis and populate the symbol table
-  //  * and bind nodes to Symbols using the property manager. If
-  //  * there are any errors we print them out and exit.
-  //  ******************************************************************/
-  STManager *stm = new STManager();
-  PropertyManager *pm = new PropertyManager();
-  SemanticVisitor* sv = new SemanticVisitor(stm, pm);
-  sv->visitCompilationUnit(tree);
-  if (sv->hasErrors()) {
-    std::cerr << sv->getErrors() << std::endl;
-    return -1;
-  }
-
-  // // Generate the LLVM IR code
-  CodegenVisitor* cv = new CodegenVisitor(pm, "WPLC.ll");
-  cv->visitCompilationUnit(tree);
-  if (cv->hasErrors()) {
-    std::cerr << cv->getErrors() << std::endl;
-    return -1;
-  }
-
-  // Print out the module contents.
-  llvm::Module *module = cv->getModule();
-  std::cout << std::endl << std::endl;
-  if (printOutput) {
-    cv->modPrint();
-  }
-
-  // Dump the code to an output file
-  if (!noCode) {
-    std::string irFileName;
-    if (outputFileName != "-") {
-      irFileName = outputFileName;
-    } else {
-      irFileName = inputFileName.substr(0,inputFileName.find_last_of('.'))+".ll";
-    }
-    std::error_code ec;
-    llvm::raw_fd_ostream irFileStream(irFileName, ec);
-    module->print(irFileStream, nullptr);
-    irFileStream.flush();
-  }
-
-  return 0;
-}
\ No newline at end of file
+    llvm::ThreadPool pool(llvm::hardware_concurrency(threadCount));
+    for (size_t i = 0; i < jobs.size(); i++) {
+      pool.async([&jobs, &results, i] { results[i] = runJob(jobs[i]); });
+    }
+    pool.wait();
+  }
+
+  saveDFACache(dfaStates);
+
+  if (!timeTrace.empty()) {
+    if (llvm::Error e = llvm::timeTraceProfilerWrite(timeTrace, "wplc")) {
+      std::cerr << "Cannot write the time trace: " << llvm::toString(std::move(e)) << std::endl;
+    }
+    llvm::timeTraceProfilerCleanup();
+  }
+  if (timeReport) {
+    printTimeReport(results);
+  }
+  if (memReport) {
+    printMemReport(results);
+  }
+  if (profileParser) {
+    printParserProfile(results);
+  }
+  if (callGraphReport) {
+    printCallGraph(results);
+  }
+  if (!memReportJson.empty()) {
+    writeMemReportJson(memReportJson, results);
+  }
+
+  /******************************************************************
+   * Report the results in the order of the inputs.
+   ******************************************************************/
+  int failures = 0;
+  for (CompileResult& r : results) {
+    if (!r.success) {
+      failures++;
+      if (results.size() > 1) {
+        std::cerr << r.inputName << ":" << std::endl;
+      }
+      std::cerr << r.diagnostics << std::endl;
+      continue;
+    }
+    std::cout << std::endl << std::endl;
+    if (printOutput) {
+      std::cout << r.ir;
+    }
+  }
+
+  if (results.size() > 1) {
+    std::cerr << "wplc: " << results.size() << " files, " << results.size() - failures
+      << " succeeded, " << failures << " failed" << std::endl;
+    for (CompileResult& r : results) {
+      std::cerr << (r.success ? "  ok      " : "  FAILED  ") << r.inputName;
+      if (r.success && !r.outputFileName.empty()) {
+        std::cerr << " -> " << r.outputFileName;
+      }
+      std::cerr << std::endl;
+    }
+  }
+
+  if (!cacheDir.empty()) {
+    unsigned hits = 0;
+    unsigned reused = 0;
+    unsigned components = 0;
+    for (CompileResult& r : results) {
+      hits += r.cacheHit;
+      reused += r.reusedComponents;
+      components += r.componentCount;
+    }
+    unsigned misses = results.size() - hits;
+    CompileCache cache(cacheDir, uint64_t(cacheSize) * 1024 * 1024);
+    cache.recordStats(hits, misses);
+    uint64_t totalHits, totalMisses;
+    if (cacheStats && cache.totalStats(totalHits, totalMisses)) {
+      std::cerr << "wplc cache: " << hits << " hits, " << misses << " misses ("
+        << totalHits << " hits, " << totalMisses << " misses in total)" << std::endl;
+    }
+    if (cacheStats && incremental) {
+      std::cerr << "wplc incremental: " << reused << " of " << components
+        << " procedures and functions reused" << std::endl;
+    }
+  }
+
+  return failures == 0 ? 0 : -1;
+}
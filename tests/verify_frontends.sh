@@ -0,0 +1,37 @@
+#!/bin/sh
+# Differential check of the hand-written lexer and parser against the
+# generated ANTLR ones. Every test program is compiled with
+# -lexer=verify, which lexes it with both lexers and compares the tokens
+# and the lexer errors, and -parser=verify, which parses it with both
+# parsers and compares the parse trees. The check stops at the first
+# program where they differ.
+#
+# usage: tests/verify_frontends.sh <wplc>
+# Run by ctest as the frontend_verify test.
+
+if [ $# -ne 1 ]; then
+  echo "usage: $0 <wplc>" >&2
+  exit 2
+fi
+wplc=$1
+tests=$(dirname "$0")
+
+checked=0
+for program in "$tests"/*/*.wpl; do
+  # Programs with syntax or semantic errors are checked too; only a
+  # mismatch fails the run
+  output=$("$wplc" -lexer=verify -parser=verify -nocode "$program" 2>&1)
+  status=$?
+  if [ $status -gt 128 ]; then
+    echo "$program: wplc died with status $status"
+    exit 1
+  fi
+  case $output in
+    *"lexer mismatch"* | *"parser mismatch"*)
+      echo "$program:"
+      echo "$output"
+      exit 1;;
+  esac
+  checked=$((checked + 1))
+done
+echo "the lexers and parsers agree on all $checked test programs"